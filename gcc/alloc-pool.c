@@ -23,6 +23,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "system.h"
 #include "alloc-pool.h"
 #include "hashtab.h"
+#include "obstack.h"
 
 #define align_eight(x) (((x+7) >> 3) << 3)
 
@@ -125,6 +126,106 @@ alloc_pool_descriptor (const char *name)
 }
 #endif
 
+/* The blocks of the pools and the pass arena come in size classes.
+   When a pool is emptied its blocks are kept for the next pool of the
+   same class rather than given back to free, since most passes create
+   their pools anew for each function.  Each doubling of the size is
+   split into 1 << BLOCK_CLASS_STEPS_LOG classes, so rounding a block up
+   to its class wastes less than a quarter of it, and that space only
+   holds more elements.  */
+#define BLOCK_CLASS_STEPS_LOG 2
+#define MIN_BLOCK_CLASS_LOG 8
+#define MAX_BLOCK_CLASS_LOG 20
+#define NUM_BLOCK_CLASSES \
+  (((MAX_BLOCK_CLASS_LOG - MIN_BLOCK_CLASS_LOG) << BLOCK_CLASS_STEPS_LOG) + 1)
+
+/* The most memory the block cache keeps.  */
+#define BLOCK_CACHE_LIMIT (8 * 1024 * 1024)
+
+/* The free blocks of each class, chained through their first word,
+   and the total size of them.  */
+static alloc_pool_list block_cache[NUM_BLOCK_CLASSES];
+static size_t block_cache_size;
+
+unsigned long alloc_pool_block_mallocs;
+unsigned long alloc_pool_block_frees;
+
+/* Return the size class of blocks of SIZE bytes, or -1 if SIZE is too
+   large for any.  */
+
+static int
+block_class (size_t size)
+{
+  const int steps = 1 << BLOCK_CLASS_STEPS_LOG;
+  size_t base, step;
+  int log;
+
+  if (size <= (size_t) 1 << MIN_BLOCK_CLASS_LOG)
+    return 0;
+  if (size > (size_t) 1 << MAX_BLOCK_CLASS_LOG)
+    return -1;
+
+  /* Find LOG with 2**LOG < SIZE <= 2**(LOG + 1).  */
+  for (log = MIN_BLOCK_CLASS_LOG; ((size_t) 2 << log) < size; log++)
+    ;
+  base = (size_t) 1 << log;
+  step = base / steps;
+  return (((log - MIN_BLOCK_CLASS_LOG) << BLOCK_CLASS_STEPS_LOG)
+	  + (int) ((size - base + step - 1) / step));
+}
+
+/* Return the size of the blocks of class KLASS.  */
+
+static size_t
+block_class_size (int klass)
+{
+  const int steps = 1 << BLOCK_CLASS_STEPS_LOG;
+  size_t base = (size_t) 1 << (MIN_BLOCK_CLASS_LOG
+			       + (klass >> BLOCK_CLASS_STEPS_LOG));
+
+  return base + (base / steps) * (klass & (steps - 1));
+}
+
+/* Return a block of class KLASS, or of SIZE bytes if KLASS is -1.  */
+
+static char *
+block_alloc (int klass, size_t size)
+{
+  alloc_pool_list block;
+
+  if (klass >= 0 && block_cache[klass])
+    {
+      block = block_cache[klass];
+      block_cache[klass] = block->next;
+      block_cache_size -= block_class_size (klass);
+      return (char *) block;
+    }
+
+  alloc_pool_block_mallocs++;
+  return XNEWVEC (char, klass >= 0 ? block_class_size (klass) : size);
+}
+
+/* Give back BLOCK of class KLASS, keeping it for reuse if the cache
+   has room.  */
+
+static void
+block_release (int klass, void *block)
+{
+  if (klass >= 0
+      && block_cache_size + block_class_size (klass) <= BLOCK_CACHE_LIMIT)
+    {
+      alloc_pool_list header = (alloc_pool_list) block;
+
+      header->next = block_cache[klass];
+      block_cache[klass] = header;
+      block_cache_size += block_class_size (klass);
+      return;
+    }
+
+  alloc_pool_block_frees++;
+  free (block);
+}
+
 /* Create a pool of things of size SIZE, with NUM in each block we
    allocate.  */
 
@@ -163,14 +264,22 @@ create_alloc_pool (const char *name, size_t size, size_t num)
   desc = alloc_pool_descriptor (name);
   desc->elt_size = size;
   desc->created++;
+  pool->desc = desc;
 #endif
   pool->elt_size = size;
-  pool->elts_per_block = num;
 
   /* List header size should be a multiple of 8.  */
   header_size = align_eight (sizeof (struct alloc_pool_list_def));
 
+  /* Round the block up to its size class and fill it.  */
   pool->block_size = (size * num) + header_size;
+  pool->block_class = block_class (pool->block_size);
+  if (pool->block_class >= 0)
+    {
+      pool->block_size = block_class_size (pool->block_class);
+      num = (pool->block_size - header_size) / size;
+    }
+  pool->elts_per_block = num;
   pool->returned_free_list = NULL;
   pool->virgin_free_list = NULL;
   pool->virgin_elts_remaining = 0;
@@ -197,9 +306,6 @@ void
 empty_alloc_pool (alloc_pool pool)
 {
   alloc_pool_list block, next_block;
-#ifdef GATHER_STATISTICS
-  struct alloc_pool_descriptor *desc = alloc_pool_descriptor (pool->name);
-#endif
 
   gcc_assert (pool);
 
@@ -207,11 +313,12 @@ empty_alloc_pool (alloc_pool pool)
   for (block = pool->block_list; block != NULL; block = next_block)
     {
       next_block = block->next;
-      free (block);
+      block_release (pool->block_class, block);
     }
 
 #ifdef GATHER_STATISTICS
-  desc->current -= (pool->elts_allocated - pool->elts_free) * pool->elt_size;
+  pool->desc->current
+    -= (pool->elts_allocated - pool->elts_free) * pool->elt_size;
 #endif
   pool->returned_free_list = NULL;
   pool->virgin_free_list = NULL;
@@ -252,7 +359,7 @@ pool_alloc (alloc_pool pool)
 {
   alloc_pool_list header;
 #ifdef GATHER_STATISTICS
-  struct alloc_pool_descriptor *desc = alloc_pool_descriptor (pool->name);
+  struct alloc_pool_descriptor *desc = pool->desc;
 
   desc->allocated += pool->elt_size;
   desc->current += pool->elt_size;
@@ -271,7 +378,7 @@ pool_alloc (alloc_pool pool)
 	  alloc_pool_list block_header;
 
 	  /* Make the block.  */
-	  block = XNEWVEC (char, pool->block_size);
+	  block = block_alloc (pool->block_class, pool->block_size);
 	  block_header = (alloc_pool_list) block;
 	  block += align_eight (sizeof (struct alloc_pool_list_def));
 
@@ -324,9 +431,6 @@ void
 pool_free (alloc_pool pool, void *ptr)
 {
   alloc_pool_list header;
-#ifdef GATHER_STATISTICS
-  struct alloc_pool_descriptor *desc = alloc_pool_descriptor (pool->name);
-#endif
 
   gcc_assert (ptr);
 
@@ -349,10 +453,85 @@ pool_free (alloc_pool pool, void *ptr)
   pool->elts_free++;
 
 #ifdef GATHER_STATISTICS
-  desc->current -= pool->elt_size;
+  pool->desc->current -= pool->elt_size;
 #endif
 
 }
+
+/* The pass arena holds memory a pass needs until it finishes.
+   execute_one_pass releases all of it in one go when the pass is done,
+   and its chunks go back to the block cache for the next pass.  */
+static struct obstack pass_arena;
+static bool pass_arena_initialized;
+
+/* An arena chunk starts with its size class.  */
+typedef union arena_chunk_header
+{
+  int klass;
+
+  /* Never accessed, these keep the chunk well aligned.  */
+  char *align_p;
+  HOST_WIDEST_INT align_i;
+} arena_chunk_header;
+
+/* The chunk size of the arena, chosen so that chunks fill a class.  */
+#define PASS_ARENA_CHUNK_SIZE (65536 - sizeof (arena_chunk_header))
+
+/* Obstack chunk allocation functions for the pass arena.  */
+
+static void *
+pass_arena_chunk_alloc (long size)
+{
+  size_t total = size + sizeof (arena_chunk_header);
+  int klass = block_class (total);
+  arena_chunk_header *header
+    = (arena_chunk_header *) block_alloc (klass, total);
+
+  header->klass = klass;
+  return header + 1;
+}
+
+static void
+pass_arena_chunk_free (void *chunk)
+{
+  arena_chunk_header *header = (arena_chunk_header *) chunk - 1;
+
+  block_release (header->klass, header);
+}
+
+/* Return SIZE bytes of memory that lives until the current pass
+   finishes.  */
+
+void *
+pass_arena_alloc (size_t size)
+{
+  if (!pass_arena_initialized)
+    {
+      obstack_specify_allocation (&pass_arena, PASS_ARENA_CHUNK_SIZE, 0,
+				  pass_arena_chunk_alloc,
+				  pass_arena_chunk_free);
+      pass_arena_initialized = true;
+    }
+  return obstack_alloc (&pass_arena, size);
+}
+
+/* Return a mark for pass_arena_release.  */
+
+void *
+pass_arena_mark (void)
+{
+  return pass_arena_alloc (0);
+}
+
+/* Release the memory allocated from the pass arena since MARK was
+   taken.  */
+
+void
+pass_arena_release (void *mark)
+{
+  obstack_free (&pass_arena, mark);
+}
+
 /* Output per-alloc_pool statistics.  */
 #ifdef GATHER_STATISTICS
 
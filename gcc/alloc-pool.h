@@ -34,6 +34,10 @@ typedef struct alloc_pool_def
   const char *name;
 #ifdef ENABLE_CHECKING
   ALLOC_POOL_ID_TYPE id;
+#endif
+#ifdef GATHER_STATISTICS
+  /* The statistics of the pools with this name.  */
+  struct alloc_pool_descriptor *desc;
 #endif
   size_t elts_per_block;
 
@@ -54,9 +58,18 @@ typedef struct alloc_pool_def
   alloc_pool_list block_list;
   size_t block_size;
   size_t elt_size;
+
+  /* The size class of the blocks, or -1 if they are too large to be
+     kept in the block cache.  */
+  int block_class;
 }
  *alloc_pool;
 
+/* The number of blocks the pools and the pass arena got from malloc
+   and gave back to free.  */
+extern unsigned long alloc_pool_block_mallocs;
+extern unsigned long alloc_pool_block_frees;
+
 extern alloc_pool create_alloc_pool (const char *, size_t, size_t);
 extern void free_alloc_pool (alloc_pool);
 extern void empty_alloc_pool (alloc_pool);
@@ -64,4 +77,8 @@ extern void free_alloc_pool_if_empty (alloc_pool *);
 extern void *pool_alloc (alloc_pool);
 extern void pool_free (alloc_pool, void *);
 extern void dump_alloc_pool_statistics (void);
+
+extern void *pass_arena_alloc (size_t);
+extern void *pass_arena_mark (void);
+extern void pass_arena_release (void *);
 #endif
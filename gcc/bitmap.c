@@ -42,6 +42,9 @@ struct bitmap_descriptor
   HOST_WIDEST_INT peak;
   HOST_WIDEST_INT current;
   int nsearches;
+  int nindex_searches;
+  int nindexed;
+  HOST_WIDEST_INT nwalked;
 };
 
 /* Hashtable mapping bitmap names to descriptors.  */
@@ -133,6 +136,84 @@ static void bitmap_element_link (bitmap, bitmap_element *);
 static bitmap_element *bitmap_elt_insert_after (bitmap, bitmap_element *, unsigned int);
 static void bitmap_elt_clear_from (bitmap, bitmap_element *);
 static bitmap_element *bitmap_find_bit (bitmap, unsigned int);
+static void bitmap_index_build (bitmap);
+static void bitmap_index_drop (bitmap);
+
+/* Drop the index of HEAD, if any, keeping its storage for reuse.  Make
+   searches walk about as many elements as the index covered before we
+   try to build it again, so that a bitmap alternating between indexed
+   and unindexed updates does not rebuild the index on every search.  */
+
+static inline void
+bitmap_index_drop (bitmap head)
+{
+  if (head->index_len)
+    {
+      head->walk_budget = MAX (head->index_len, BITMAP_INDEX_WALK);
+      head->index_len = 0;
+    }
+}
+
+/* Record in the index of HEAD that ELT is in the list, extending the
+   index upwards if its storage allows; otherwise drop the index.  */
+
+static inline void
+bitmap_index_add (bitmap head, bitmap_element *elt)
+{
+  unsigned int pos = elt->indx - head->index_base;
+
+  if (elt->indx < head->index_base || pos >= head->index_alloc)
+    bitmap_index_drop (head);
+  else
+    {
+      if (pos >= head->index_len)
+	{
+	  memset (head->index + head->index_len, 0,
+		  (pos + 1 - head->index_len) * sizeof (bitmap_element *));
+	  head->index_len = pos + 1;
+	}
+      head->index[pos] = elt;
+    }
+}
+
+/* Try to build an index for HEAD, which must not be empty.  */
+
+static void
+bitmap_index_build (bitmap head)
+{
+  bitmap_element *elt;
+  unsigned int n, span;
+
+  for (n = 1, elt = head->first; elt->next; elt = elt->next)
+    n++;
+  span = elt->indx - head->first->indx + 1;
+
+  /* Too sparse.  Walk about as far as this cost before trying again.  */
+  if (span / BITMAP_INDEX_SPARSITY > n)
+    {
+      head->walk_budget = MAX (n, BITMAP_INDEX_WALK);
+      return;
+    }
+
+  if (head->index_alloc < span
+      || head->index_generation != head->obstack->generation)
+    {
+      /* Leave room for the bitmap to grow upwards.  */
+      head->index_alloc = span * 2;
+      head->index = XOBNEWVEC (&head->obstack->obstack, bitmap_element *,
+			       head->index_alloc);
+      head->index_generation = head->obstack->generation;
+    }
+  head->index_base = head->first->indx;
+  head->index_len = span;
+  memset (head->index, 0, span * sizeof (bitmap_element *));
+  for (elt = head->first; elt; elt = elt->next)
+    head->index[elt->indx - head->index_base] = elt;
+
+#ifdef GATHER_STATISTICS
+  head->desc->nindexed++;
+#endif
+}
 
 
 /* Add ELEM to the appropriate freelist.  */
@@ -172,6 +253,9 @@ bitmap_element_free (bitmap head, bitmap_element *elt)
   if (head->first == elt)
     head->first = next;
 
+  if (head->index_len)
+    head->index[elt->indx - head->index_base] = NULL;
+
   /* Since the first thing we try is to insert before current,
      make current the next entry in preference to the previous.  */
   if (head->current == elt)
@@ -252,6 +336,7 @@ bitmap_elt_clear_from (bitmap head, bitmap_element *elt)
 #endif
 
   if (!elt) return;
+  bitmap_index_drop (head);
 #ifdef GATHER_STATISTICS
   n = 0;
   for (prev = elt; prev; prev = prev->next)
@@ -294,6 +379,7 @@ bitmap_elt_clear_from (bitmap head, bitmap_element *elt)
 void
 bitmap_clear (bitmap head)
 {
+  bitmap_index_drop (head);
   if (head->first)
     bitmap_elt_clear_from (head, head->first);
 }
@@ -317,6 +403,7 @@ bitmap_obstack_initialize (bitmap_obstack *bit_obstack)
 
   bit_obstack->elements = NULL;
   bit_obstack->heads = NULL;
+  bit_obstack->generation++;
   obstack_specify_allocation (&bit_obstack->obstack, OBSTACK_CHUNK_SIZE,
 			      __alignof__ (bitmap_element),
 			      obstack_chunk_alloc,
@@ -341,6 +428,7 @@ bitmap_obstack_release (bitmap_obstack *bit_obstack)
 
   bit_obstack->elements = NULL;
   bit_obstack->heads = NULL;
+  bit_obstack->generation++;
   obstack_free (&bit_obstack->obstack, NULL);
 }
 
@@ -351,15 +439,26 @@ bitmap
 bitmap_obstack_alloc_stat (bitmap_obstack *bit_obstack MEM_STAT_DECL)
 {
   bitmap map;
+  bitmap_element **index = NULL;
+  unsigned int index_alloc = 0, index_generation = 0;
 
   if (!bit_obstack)
     bit_obstack = &bitmap_default_obstack;
   map = bit_obstack->heads;
   if (map)
-    bit_obstack->heads = (struct bitmap_head_def *) map->first;
+    {
+      bit_obstack->heads = (struct bitmap_head_def *) map->first;
+      /* Reuse the index storage of the freed bitmap.  */
+      index = map->index;
+      index_alloc = map->index_alloc;
+      index_generation = map->index_generation;
+    }
   else
     map = XOBNEW (&bit_obstack->obstack, bitmap_head);
   bitmap_initialize_stat (map, bit_obstack PASS_MEM_STAT);
+  map->index = index;
+  map->index_alloc = index_alloc;
+  map->index_generation = index_generation;
 #ifdef GATHER_STATISTICS
   register_overhead (map, sizeof (bitmap_head));
 #endif
@@ -433,6 +532,36 @@ bitmap_element_link (bitmap head, bitmap_element *element)
       head->first = element;
     }
 
+  /* If the index covers this element, it tells us the element it goes
+     after, if any.  */
+  else if (head->index_len
+	   && indx >= head->index_base
+	   && indx - head->index_base < head->index_len)
+    {
+      unsigned int pos = indx - head->index_base;
+
+      while (pos > 0 && !head->index[pos - 1])
+	pos--;
+
+      if (pos)
+	{
+	  ptr = head->index[pos - 1];
+	  if (ptr->next)
+	    ptr->next->prev = element;
+
+	  element->next = ptr->next;
+	  element->prev = ptr;
+	  ptr->next = element;
+	}
+      else
+	{
+	  element->prev = 0;
+	  element->next = head->first;
+	  head->first->prev = element;
+	  head->first = element;
+	}
+    }
+
   /* If this index is less than that of the current element, it goes someplace
      before the current element.  */
   else if (indx < head->indx)
@@ -471,6 +600,9 @@ bitmap_element_link (bitmap head, bitmap_element *element)
   /* Set up so this is the first element searched.  */
   head->current = element;
   head->indx = indx;
+
+  if (head->index_len)
+    bitmap_index_add (head, element);
 }
 
 /* Insert a new uninitialized element into bitmap HEAD after element
@@ -505,6 +637,9 @@ bitmap_elt_insert_after (bitmap head, bitmap_element *elt, unsigned int indx)
       elt->next = node;
       node->prev = elt;
     }
+
+  if (head->index_len)
+    bitmap_index_add (head, node);
   return node;
 }
 
@@ -555,6 +690,7 @@ bitmap_find_bit (bitmap head, unsigned int bit)
 {
   bitmap_element *element;
   unsigned int indx = bit / BITMAP_ELEMENT_ALL_BITS;
+  int walked = 0;
 
 #ifdef GATHER_STATISTICS
   head->desc->nsearches++;
@@ -563,13 +699,38 @@ bitmap_find_bit (bitmap head, unsigned int bit)
       || head->indx == indx)
     return head->current;
 
+  if (head->index_len)
+    {
+      /* Look the element up in the index.  If there is none, make the
+	 nearest element below it current, as the walk below would.  */
+      unsigned int pos;
+
+#ifdef GATHER_STATISTICS
+      head->desc->nindex_searches++;
+#endif
+      if (indx < head->index_base)
+	element = head->first;
+      else
+	{
+	  pos = MIN (indx - head->index_base, head->index_len - 1);
+	  while (pos > 0 && !head->index[pos])
+	    pos--;
+	  element = head->index[pos];
+	  if (!element)
+	    element = head->first;
+	}
+      head->current = element;
+      head->indx = element->indx;
+      return element->indx == indx ? element : NULL;
+    }
+
   if (head->indx < indx)
     /* INDX is beyond head->indx.  Search from head->current
        forward.  */
     for (element = head->current;
 	 element->next != 0 && element->indx < indx;
 	 element = element->next)
-      ;
+      walked++;
 
   else if (head->indx / 2 < indx)
     /* INDX is less than head->indx and closer to head->indx than to
@@ -577,7 +738,7 @@ bitmap_find_bit (bitmap head, unsigned int bit)
     for (element = head->current;
 	 element->prev != 0 && element->indx > indx;
 	 element = element->prev)
-      ;
+      walked++;
 
   else
     /* INDX is less than head->indx and closer to 0 than to
@@ -585,7 +746,11 @@ bitmap_find_bit (bitmap head, unsigned int bit)
     for (element = head->first;
 	 element->next != 0 && element->indx < indx;
 	 element = element->next)
-      ;
+      walked++;
+
+#ifdef GATHER_STATISTICS
+  head->desc->nwalked += walked;
+#endif
 
   /* `element' is the nearest to the one we want.  If it's not the one we
      want, the one we want doesn't exist.  */
@@ -594,6 +759,10 @@ bitmap_find_bit (bitmap head, unsigned int bit)
   if (element != 0 && element->indx != indx)
     element = 0;
 
+  /* If searching this bitmap has become expensive, index it.  */
+  if (head->obstack && (head->walk_budget -= walked) < 0)
+    bitmap_index_build (head);
+
   return element;
 }
 
@@ -872,6 +1041,8 @@ bitmap_and (bitmap dst, const_bitmap a, const_bitmap b)
   bitmap_element *dst_prev = NULL;
 
   gcc_assert (dst != a && dst != b);
+  /* The elements of DST get reused for other indices.  */
+  bitmap_index_drop (dst);
 
   if (a == b)
     {
@@ -1013,6 +1184,8 @@ bitmap_and_compl (bitmap dst, const_bitmap a, const_bitmap b)
   bool changed = false;
 
   gcc_assert (dst != a && dst != b);
+  /* The elements of DST get reused for other indices.  */
+  bitmap_index_drop (dst);
 
   if (a == b)
     {
@@ -1535,6 +1708,8 @@ bitmap_ior (bitmap dst, const_bitmap a, const_bitmap b)
   bool changed = false;
 
   gcc_assert (dst != a && dst != b);
+  /* The elements of DST get reused for other indices.  */
+  bitmap_index_drop (dst);
 
   while (a_elt || b_elt)
     {
@@ -1619,6 +1794,8 @@ bitmap_xor (bitmap dst, const_bitmap a, const_bitmap b)
   bitmap_element *dst_prev = NULL;
 
   gcc_assert (dst != a && dst != b);
+  /* The elements of DST get reused for other indices.  */
+  bitmap_index_drop (dst);
   if (a == b)
     {
       bitmap_clear (dst);
@@ -1837,6 +2014,8 @@ bitmap_ior_and_compl (bitmap dst, const_bitmap a, const_bitmap b, const_bitmap k
   bitmap_element **dst_prev_pnext = &dst->first;
 
   gcc_assert (dst != a && dst != b && dst != kill);
+  /* The elements of DST get reused for other indices.  */
+  bitmap_index_drop (dst);
 
   /* Special cases.  We don't bother checking for bitmap_equal_p (b, kill).  */
   if (b == kill || bitmap_empty_p (b))
@@ -2095,6 +2274,9 @@ struct output_info
 {
   HOST_WIDEST_INT size;
   int count;
+  HOST_WIDEST_INT searches;
+  HOST_WIDEST_INT index_searches;
+  int indexed;
 };
 
 /* Called via htab_traverse.  Output bitmap descriptor pointed out by SLOT
@@ -2115,10 +2297,17 @@ print_statistics (void **slot, void *b)
       sprintf (s, "%s:%i (%s)", s1, d->line, d->function);
       s[41] = 0;
       fprintf (stderr, "%-41s %8d %15"HOST_WIDEST_INT_PRINT"d %15"
-	       HOST_WIDEST_INT_PRINT"d %15"HOST_WIDEST_INT_PRINT"d %10d\n",
-	       s, d->created, d->allocated, d->peak, d->current, d->nsearches);
+	       HOST_WIDEST_INT_PRINT"d %15"HOST_WIDEST_INT_PRINT"d %10d %10.1f"
+	       " %8d %10d\n",
+	       s, d->created, d->allocated, d->peak, d->current, d->nsearches,
+	       d->nsearches - d->nindex_searches
+	       ? (double) d->nwalked / (d->nsearches - d->nindex_searches) : 0,
+	       d->nindexed, d->nindex_searches);
       i->size += d->allocated;
       i->count += d->created;
+      i->searches += d->nsearches;
+      i->index_searches += d->nindex_searches;
+      i->indexed += d->nindexed;
     }
   return 1;
 }
@@ -2135,14 +2324,21 @@ dump_bitmap_statistics (void)
 
   fprintf (stderr, "\nBitmap                                     Overall "
 		   "   Allocated        Peak           Leak   searched "
-		   "  per search\n");
+		   "walk/search  indexed   by index\n");
   fprintf (stderr, "---------------------------------------------------------------------------------\n");
   info.count = 0;
   info.size = 0;
+  info.searches = 0;
+  info.index_searches = 0;
+  info.indexed = 0;
   htab_traverse (bitmap_desc_hash, print_statistics, &info);
   fprintf (stderr, "---------------------------------------------------------------------------------\n");
   fprintf (stderr, "%-40s %9d %15"HOST_WIDEST_INT_PRINT"d\n",
 	   "Total", info.count, info.size);
+  fprintf (stderr, "Searches: %"HOST_WIDEST_INT_PRINT"d in lists, "
+	   "%"HOST_WIDEST_INT_PRINT"d in indices; %d indices built\n",
+	   info.searches - info.index_searches, info.index_searches,
+	   info.indexed);
   fprintf (stderr, "---------------------------------------------------------------------------------\n");
 #endif
 }
@@ -45,6 +45,7 @@ typedef unsigned long BITMAP_WORD;
 typedef struct GTY (()) bitmap_obstack {
   struct bitmap_element_def *elements;
   struct bitmap_head_def *heads;
+  unsigned int generation;	/* Changed whenever the memory is released.  */
   struct obstack GTY ((skip)) obstack;
 } bitmap_obstack;
 
@@ -67,17 +68,50 @@ typedef struct GTY(()) bitmap_element_def {
   BITMAP_WORD bits[BITMAP_ELEMENT_WORDS]; /* Bits that are set.  */
 } bitmap_element;
 
+/* Searches for a single bit start at the element looked at last and
+   walk the list from there, which is cheap for the usual clustered
+   accesses but linear for random ones.  Once searches in an obstack
+   bitmap have walked more than BITMAP_INDEX_WALK elements since the
+   bitmap was last considered, we try to build an index vector that
+   maps element indices directly to elements.  It is only built if the
+   bitmap spans at most BITMAP_INDEX_SPARSITY times as many element
+   indices as it has elements.  */
+
+#ifndef BITMAP_INDEX_WALK
+#define BITMAP_INDEX_WALK 256
+#endif
+
+#ifndef BITMAP_INDEX_SPARSITY
+#define BITMAP_INDEX_SPARSITY 4
+#endif
+
 struct bitmap_descriptor;
 /* Head of bitmap linked list.  gengtype ignores ifdefs, but for
    statistics we need to add a bitmap descriptor pointer.  As it is
-   not collected, we can just GTY((skip)) it.   */
+   not collected, we can just GTY((skip)) it.
+
+   The linked list is always the authoritative representation of the
+   bitmap; the index, when present, is just a faster way of finding
+   elements in it.  Entry I of the index is the element with index
+   INDEX_BASE + I, or NULL if there is none.  The index lives on the
+   bitmap obstack, so GC'd bitmaps are never indexed.  A cleared bitmap
+   keeps the storage of its index unless the obstack has been released
+   since.  */
 
 typedef struct GTY(()) bitmap_head_def {
   bitmap_element *first;	/* First element in linked list.  */
   bitmap_element *current;	/* Last element looked at.  */
   unsigned int indx;		/* Index of last element looked at.  */
+  int walk_budget;		/* Elements searches may still walk before
+				   we try to build an index.  */
   bitmap_obstack *obstack;	/* Obstack to allocate elements from.
 				   If NULL, then use ggc_alloc.  */
+  bitmap_element ** GTY((skip)) index; /* Index vector, if allocated.  */
+  unsigned int index_base;	/* Element index of the first entry.  */
+  unsigned int index_len;	/* Entries in use, 0 if not indexed.  */
+  unsigned int index_alloc;	/* Entries allocated.  */
+  unsigned int index_generation; /* Generation of OBSTACK the storage
+				    of the index is from.  */
 #ifdef GATHER_STATISTICS
   struct bitmap_descriptor GTY((skip)) *desc;
 #endif
@@ -166,6 +200,9 @@ bitmap_initialize_stat (bitmap head, bitmap_obstack *obstack MEM_STAT_DECL)
 {
   head->first = head->current = NULL;
   head->obstack = obstack;
+  head->walk_budget = BITMAP_INDEX_WALK;
+  head->index = NULL;
+  head->index_len = head->index_alloc = 0;
 #ifdef GATHER_STATISTICS
   bitmap_register (head PASS_MEM_STAT);
 #endif
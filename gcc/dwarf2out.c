@@ -16855,6 +16855,12 @@ scope_die_for (tree t, dw_die_ref context_die)
   if (containing_scope && TREE_CODE (containing_scope) == FUNCTION_TYPE)
     containing_scope = NULL_TREE;
 
+  /* Types at file scope belong in the compile unit even when they are
+     first referred to from within another type or a function.  */
+  if (containing_scope
+      && TREE_CODE (containing_scope) == TRANSLATION_UNIT_DECL)
+    containing_scope = NULL_TREE;
+
   if (containing_scope == NULL_TREE)
     scope_die = comp_unit_die;
   else if (TYPE_P (containing_scope))
@@ -17743,57 +17749,117 @@ dwarf2out_abstract_function (tree decl)
   pop_cfun ();
 }
 
+/* Return the DIE of TYPE, a type used by a function or a global
+   variable, or NULL if it has none.  Without
+   -fno-eliminate-unused-debug-types, dwarf2out_decl does not create the
+   DIEs of tagged types and typedefs outside functions, so create the
+   DIE of such a type here if nothing has referred to it yet.  */
+
+static dw_die_ref
+lookup_used_type_die (tree type)
+{
+  dw_die_ref die = lookup_type_die (type);
+  tree decl;
+
+  if (die != NULL || !flag_eliminate_unused_debug_types)
+    return die;
+
+  if (is_tagged_type (type))
+    decl = TYPE_STUB_DECL (type);
+  else if (TYPE_NAME (type) && TREE_CODE (TYPE_NAME (type)) == TYPE_DECL)
+    decl = TYPE_NAME (type);
+  else
+    decl = NULL_TREE;
+
+  if (decl != NULL_TREE
+      && !DECL_IGNORED_P (decl)
+      && decl_function_context (decl) == NULL_TREE)
+    {
+      gen_type_die (type, comp_unit_die);
+      die = lookup_type_die (type);
+    }
+  return die;
+}
+
 /* Helper function of premark_used_types() which gets called through
    htab_traverse.
 
-   Marks the DIE of a given type in *SLOT as perennial, so it never gets
-   marked as unused by prune_unused_types.  */
+   Pushes the type in *SLOT on the vector of types DATA points to.  */
 
 static int
-premark_used_types_helper (void **slot, void *data ATTRIBUTE_UNUSED)
+premark_used_types_helper (void **slot, void *data)
 {
-  tree type;
-  dw_die_ref die;
+  VEC (tree, heap) **types = (VEC (tree, heap) **) data;
 
-  type = (tree) *slot;
-  die = lookup_type_die (type);
-  if (die != NULL)
-    die->die_perennial_p = 1;
+  VEC_safe_push (tree, heap, *types, (tree) *slot);
   return 1;
 }
 
 /* Helper function of premark_types_used_by_global_vars which gets called
    through htab_traverse.
 
-   Marks the DIE of a given type in *SLOT as perennial, so it never gets
-   marked as unused by prune_unused_types. The DIE of the type is marked
+   Pushes the type of *SLOT on the vector of types DATA points to, but
    only if the global variable using the type will actually be emitted.  */
 
 static int
-premark_types_used_by_global_vars_helper (void **slot,
-					  void *data ATTRIBUTE_UNUSED)
+premark_types_used_by_global_vars_helper (void **slot, void *data)
 {
+  VEC (tree, heap) **types = (VEC (tree, heap) **) data;
   struct types_used_by_vars_entry *entry;
-  dw_die_ref die;
 
   entry = (struct types_used_by_vars_entry *) *slot;
   gcc_assert (entry->type != NULL
 	      && entry->var_decl != NULL);
-  die = lookup_type_die (entry->type);
-  if (die)
+  /* Ask cgraph if the global variable really is to be emitted.
+     If yes, then we'll keep the DIE of ENTRY->TYPE.  */
+  if (varpool_node (entry->var_decl)->needed)
+    VEC_safe_push (tree, heap, *types, entry->type);
+  return 1;
+}
+
+/* Compare the types P1 and P2 point to by TYPE_UID, for qsort.  */
+
+static int
+type_uid_cmp (const void *p1, const void *p2)
+{
+  const_tree t1 = *(const_tree const *) p1;
+  const_tree t2 = *(const_tree const *) p2;
+
+  if (TYPE_UID (t1) != TYPE_UID (t2))
+    return TYPE_UID (t1) < TYPE_UID (t2) ? -1 : 1;
+  return 0;
+}
+
+/* Mark the DIEs of the types HTAB_TRAVERSE pushes on a vector through
+   HELPER from HTAB as perennial, so they never get marked as unused by
+   prune_unused_types.  If KEEP_PARENTS, mark their parent DIEs as well.
+   The tables are hashed by address and lookup_used_type_die may create
+   DIEs, so visit the types in the order of their TYPE_UID to keep the
+   output the same from one run to the next.  */
+
+static void
+premark_types (htab_t htab, htab_trav helper, bool keep_parents)
+{
+  VEC (tree, heap) *types = NULL;
+  unsigned ix;
+  tree type;
+
+  htab_traverse (htab, helper, &types);
+  if (VEC_length (tree, types) > 1)
+    qsort (VEC_address (tree, types), VEC_length (tree, types),
+	   sizeof (tree), type_uid_cmp);
+  for (ix = 0; VEC_iterate (tree, types, ix, type); ix++)
     {
-      /* Ask cgraph if the global variable really is to be emitted.
-         If yes, then we'll keep the DIE of ENTRY->TYPE.  */
-      struct varpool_node *node = varpool_node (entry->var_decl);
-      if (node->needed)
-	{
+      dw_die_ref die = lookup_used_type_die (type);
+
+      if (die == NULL)
+	continue;
+      die->die_perennial_p = 1;
+      if (keep_parents)
+	while ((die = die->die_parent) && die->die_perennial_p == 0)
 	  die->die_perennial_p = 1;
-	  /* Keep the parent DIEs as well.  */
-	  while ((die = die->die_parent) && die->die_perennial_p == 0)
-	    die->die_perennial_p = 1;
-	}
     }
-  return 1;
+  VEC_free (tree, heap, types);
 }
 
 /* Mark all members of used_types_hash as perennial.  */
@@ -17802,7 +17868,7 @@ static void
 premark_used_types (void)
 {
   if (cfun && cfun->used_types_hash)
-    htab_traverse (cfun->used_types_hash, premark_used_types_helper, NULL);
+    premark_types (cfun->used_types_hash, premark_used_types_helper, false);
 }
 
 /* Mark all members of types_used_by_vars_entry as perennial.  */
@@ -17811,8 +17877,8 @@ static void
 premark_types_used_by_global_vars (void)
 {
   if (types_used_by_vars_hash)
-    htab_traverse (types_used_by_vars_hash,
-		   premark_types_used_by_global_vars_helper, NULL);
+    premark_types (types_used_by_vars_hash,
+		   premark_types_used_by_global_vars_helper, true);
 }
 
 /* Generate a DIE to represent a declared function (either file-scope or
@@ -19008,6 +19074,10 @@ gen_type_die_with_usage (tree type, dw_die_ref context_die,
       if (DECL_CONTEXT (TYPE_NAME (type))
 	  && TREE_CODE (DECL_CONTEXT (TYPE_NAME (type))) == NAMESPACE_DECL)
 	context_die = get_context_die (DECL_CONTEXT (TYPE_NAME (type)));
+      /* dwarf2out_decl leaves file scope typedefs alone until they are
+	 referred to, which may be from within a function.  */
+      else if (DECL_FILE_SCOPE_P (TYPE_NAME (type)))
+	context_die = comp_unit_die;
 
       TREE_ASM_WRITTEN (type) = 1;
       gen_decl_die (TYPE_NAME (type), NULL, context_die);
@@ -19999,6 +20069,14 @@ dwarf2out_decl (tree decl)
       if (debug_info_level <= DINFO_LEVEL_TERSE)
 	return;
 
+      /* prune_unused_types removes the DIEs of types outside functions
+	 that nothing refers to.  When it is going to run, create them
+	 only once something refers to them, instead of building DIEs
+	 for all the unused types the headers of a large translation
+	 unit declare.  */
+      if (flag_eliminate_unused_debug_types && !decl_function_context (decl))
+	return;
+
       /* If we're a function-scope tag, initially use a parent of NULL;
 	 this will be fixed up in decls_for_scope.  */
       if (decl_function_context (decl))
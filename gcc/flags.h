@@ -224,6 +224,15 @@ enum ira_algorithm
 
 extern enum ira_algorithm flag_ira_algorithm;
 
+/* The codec used to compress the IL in LTO object files.  */
+enum lto_compression
+{
+  LTO_COMPRESSION_ZLIB,
+  LTO_COMPRESSION_LZ
+};
+
+extern enum lto_compression flag_lto_compression;
+
 /* The regions used for the integrated register allocator (IRA).  */
 enum ira_region
 {
@@ -234,6 +243,15 @@ enum ira_region
 
 extern enum ira_region flag_ira_region;
 
+/* The format of the pass statistics written for -fpass-stats.  */
+enum pass_stats_format
+{
+  PASS_STATS_NONE,
+  PASS_STATS_JSON
+};
+
+extern enum pass_stats_format flag_pass_stats;
+
 extern unsigned int flag_ira_verbose;
 
 /* The options for excess precision.  */
@@ -252,6 +252,7 @@ static arc_t next_out_arc              (arc_t);
 #define W_OPTION "-w"
 #define NDFA_OPTION "-ndfa"
 #define PROGRESS_OPTION "-progress"
+#define COMB_OPTION "-comb"
 
 /* The following flags are set up by function `initiate_automaton_gen'.  */
 
@@ -274,6 +275,10 @@ static int time_flag;
 /* Flag of automata statistics (`-stats').  */
 static int stats_flag;
 
+/* Represent transition tables as comb vectors whose elements hold both
+   the check and the next state (`-comb').  */
+static int comb_flag;
+
 /* Flag of creation of description file which contains description of
    result automaton and statistics information (`-v').  */
 static int v_flag;
@@ -1530,6 +1535,8 @@ gen_automata_option (rtx def)
     ndfa_flag = 1;
   else if (strcmp (XSTR (def, 0), PROGRESS_OPTION + 1) == 0)
     progress_flag = 1;
+  else if (strcmp (XSTR (def, 0), COMB_OPTION + 1) == 0)
+    comb_flag = 1;
   else
     fatal ("invalid option `%s' in automata_option", XSTR (def, 0));
 }
@@ -6849,6 +6856,31 @@ output_vect (vla_hwint_t vect)
       }
 }
 
+/* The function outputs the elements of comb vector COMB_VECT paired
+   with the corresponding elements of check vector CHECK_VECT.  */
+static void
+output_comb_check_vect (vla_hwint_t comb_vect, vla_hwint_t check_vect)
+{
+  size_t vect_length = VEC_length (vect_el_t, comb_vect);
+  size_t i;
+
+  gcc_assert (VEC_length (vect_el_t, check_vect) == vect_length);
+  if (vect_length == 0)
+    fputs ("{0, 0} /* This is dummy el because the vect is empty */",
+	   output_file);
+  else
+    for (i = 0; i < vect_length; i++)
+      {
+	fprintf (output_file, "{%5ld, %5ld}",
+		 (long) VEC_index (vect_el_t, check_vect, i),
+		 (long) VEC_index (vect_el_t, comb_vect, i));
+	if (i % 5 == 4)
+	  fputs (",\n", output_file);
+	else if (i < vect_length - 1)
+	  fputs (", ", output_file);
+      }
+}
+
 /* The following is name of the structure which represents DFA(s) for
    PHR.  */
 #define CHIP_NAME "DFA_chip"
@@ -7129,10 +7161,15 @@ output_translate_vect (automaton_t automaton)
 static int undefined_vect_el_value;
 
 /* The following function returns nonzero value if the best
-   representation of the table is comb vector.  */
+   representation of the table is comb vector.  With `-comb' each comb
+   vector element also holds its check value, so the comb vector is used
+   whenever these pairs take less space than the full table.  */
 static int
 comb_vect_p (state_ainsn_table_t tab)
 {
+  if (comb_flag)
+    return (VEC_length (vect_el_t, tab->full_vect)
+	    > 2 * VEC_length (vect_el_t, tab->comb_vect));
   return  (2 * VEC_length (vect_el_t, tab->full_vect)
            > 5 * VEC_length (vect_el_t, tab->comb_vect));
 }
@@ -7189,6 +7226,30 @@ output_state_ainsn_table (state_ainsn_table_t tab, const char *table_name,
       output_vect (tab->full_vect);
       fprintf (output_file, "};\n\n");
     }
+  else if (comb_flag)
+    {
+      fprintf (output_file,
+	       "/* Comb vector with check values for %s.  */\n", table_name);
+      fprintf (output_file, "static const struct\n{\n  ");
+      output_range_type (output_file, 0, tab->automaton->achieved_states_num);
+      fprintf (output_file, " check;\n  ");
+      output_range_type (output_file, tab->min_comb_vect_el_value,
+                         tab->max_comb_vect_el_value);
+      fprintf (output_file, " next;\n} ");
+      (*output_comb_vect_name_func) (output_file, tab->automaton);
+      fprintf (output_file, "[] = {\n");
+      output_comb_check_vect (tab->comb_vect, tab->check_vect);
+      fprintf (output_file, "};\n\n");
+      fprintf (output_file, "/* Base vector for %s.  */\n", table_name);
+      fprintf (output_file, "static const ");
+      output_range_type (output_file, tab->min_base_vect_el_value,
+                         tab->max_base_vect_el_value);
+      fprintf (output_file, " ");
+      (*output_base_vect_name_func) (output_file, tab->automaton);
+      fprintf (output_file, "[] = {\n");
+      output_vect (tab->base_vect);
+      fprintf (output_file, "};\n\n");
+    }
   else
     {
       fprintf (output_file, "/* Comb vector for %s.  */\n", table_name);
@@ -7940,9 +8001,13 @@ output_automata_list_transition_code (automata_list_el_t automata_list)
 	output_translate_vect_name (output_file, el->automaton);
 	fprintf (output_file, " [%s];\n", INTERNAL_INSN_CODE_NAME);
 	fprintf (output_file, "        if (");
-	output_trans_check_vect_name (output_file, el->automaton);
-	fprintf (output_file, " [%s] != %s->",
-		 TEMPORARY_VARIABLE_NAME, CHIP_PARAMETER_NAME);
+	if (comb_flag)
+	  output_trans_comb_vect_name (output_file, el->automaton);
+	else
+	  output_trans_check_vect_name (output_file, el->automaton);
+	fprintf (output_file, " [%s]%s != %s->",
+		 TEMPORARY_VARIABLE_NAME, comb_flag ? ".check" : "",
+		 CHIP_PARAMETER_NAME);
 	output_chip_member_name (output_file, el->automaton);
 	fprintf (output_file, ")\n");
 	fprintf (output_file, "          return %s (%s, %s);\n",
@@ -7959,7 +8024,8 @@ output_automata_list_transition_code (automata_list_el_t automata_list)
 	  }
 	fprintf (output_file, " = ");
 	output_trans_comb_vect_name (output_file, el->automaton);
-	fprintf (output_file, " [%s];\n", TEMPORARY_VARIABLE_NAME);
+	fprintf (output_file, " [%s]%s;\n", TEMPORARY_VARIABLE_NAME,
+		 comb_flag ? ".next" : "");
       }
     else
       {
@@ -9163,6 +9229,7 @@ initiate_automaton_gen (int argc, char **argv)
   v_flag = 0;
   w_flag = 0;
   progress_flag = 0;
+  comb_flag = 0;
   for (i = 2; i < argc; i++)
     if (strcmp (argv [i], NO_MINIMIZATION_OPTION) == 0)
       no_minimization_flag = 1;
@@ -9178,6 +9245,8 @@ initiate_automaton_gen (int argc, char **argv)
       ndfa_flag = 1;
     else if (strcmp (argv [i], PROGRESS_OPTION) == 0)
       progress_flag = 1;
+    else if (strcmp (argv [i], COMB_OPTION) == 0)
+      comb_flag = 1;
     else if (strcmp (argv [i], "-split") == 0)
       {
 	if (i + 1 >= argc)
@@ -9471,6 +9540,153 @@ write_automata (void)
     remove (output_description_file_name);
 }
 
+/* This page contains the cache of generated automata.  If the
+   environment variable named below names a directory, the output for
+   each distinct pipeline description is kept there, so that rebuilding
+   after changes to other parts of the machine description does not
+   have to build and minimize the automata again.  */
+
+#define AUTOMATA_CACHE_DIR_ENV "GENAUTOMATA_CACHE_DIR"
+
+/* The following file collects the text the output depends on: the
+   version of the generator and every pipeline description construction
+   read.  It is NULL if the cache is not used.  */
+static FILE *automata_cache_key;
+
+/* Name of the cache file for the current description.  */
+static char *automata_cache_file_name;
+
+/* Copy the rest of stream FROM to stream TO.  */
+static void
+copy_stream (FILE *from, FILE *to)
+{
+  char buf[BUFSIZ];
+  size_t n;
+
+  while ((n = fread (buf, 1, sizeof buf, from)) > 0)
+    fwrite (buf, 1, n, to);
+}
+
+/* Start collecting the cache key if the cache is enabled.  */
+static void
+initiate_automata_cache (void)
+{
+  const char *dir = getenv (AUTOMATA_CACHE_DIR_ENV);
+
+  automata_cache_key = NULL;
+  if (dir == NULL || *dir == '\0')
+    return;
+  automata_cache_key = tmpfile ();
+  if (automata_cache_key == NULL)
+    return;
+  fprintf (automata_cache_key, "genautomata %s %s\n", __DATE__, __TIME__);
+  automata_cache_file_name = XNEWVEC (char, strlen (dir) + 32);
+}
+
+/* Return the contents of the cache key and store its length to
+   *LENGTH.  */
+static char *
+read_automata_cache_key (size_t *length)
+{
+  char *key;
+
+  *length = ftell (automata_cache_key);
+  key = XNEWVEC (char, *length + 1);
+  rewind (automata_cache_key);
+  if (fread (key, 1, *length, automata_cache_key) != *length)
+    fatal ("error reading the automata cache key");
+  return key;
+}
+
+/* If the cache has the output for the description read, copy it to
+   the standard output and return nonzero.  Otherwise return zero and
+   set up output_file so that write_automata_cache can store the
+   output.  */
+static int
+read_automata_cache (void)
+{
+  char *key, *cached_key;
+  size_t length, cached_length;
+  unsigned long stored_length;
+  FILE *f;
+  int found;
+
+  /* These options ask for output the cache does not hold.  */
+  if (automata_cache_key == NULL
+      || v_flag || time_flag || stats_flag || progress_flag)
+    return 0;
+  key = read_automata_cache_key (&length);
+  sprintf (automata_cache_file_name, "%s/automata-%08lx.c",
+	   getenv (AUTOMATA_CACHE_DIR_ENV),
+	   (unsigned long) iterative_hash (key, length, 0) & 0xffffffff);
+  found = 0;
+  f = fopen (automata_cache_file_name, "rb");
+  if (f != NULL)
+    {
+      /* The file starts with the length of the key and the key, which
+	 must match exactly.  */
+      if (fscanf (f, "/* %lu */", &stored_length) == 1
+	  && getc (f) == '\n'
+	  && stored_length == length)
+	{
+	  cached_key = XNEWVEC (char, length + 1);
+	  cached_length = fread (cached_key, 1, length, f);
+	  found = (cached_length == length
+		   && memcmp (cached_key, key, length) == 0);
+	  free (cached_key);
+	}
+      if (found)
+	copy_stream (f, stdout);
+      fclose (f);
+    }
+  free (key);
+  if (!found)
+    {
+      output_file = tmpfile ();
+      if (output_file == NULL)
+	output_file = stdout;
+    }
+  return found;
+}
+
+/* Copy the output collected in output_file to the standard output and
+   store it in the cache.  The file is written under a temporary name
+   and renamed, so that generators running in parallel never see a
+   partial file.  */
+static void
+write_automata_cache (void)
+{
+  char *key, *tmp_name;
+  size_t length;
+  FILE *f;
+
+  if (output_file == stdout)
+    return;
+  rewind (output_file);
+  copy_stream (output_file, stdout);
+  if (!have_error && !ferror (output_file))
+    {
+      key = read_automata_cache_key (&length);
+      tmp_name = XNEWVEC (char, strlen (automata_cache_file_name) + 32);
+      sprintf (tmp_name, "%s.%ld", automata_cache_file_name,
+	       (long) getpid ());
+      f = fopen (tmp_name, "wb");
+      if (f != NULL)
+	{
+	  fprintf (f, "/* %lu */\n", (unsigned long) length);
+	  fwrite (key, 1, length, f);
+	  rewind (output_file);
+	  copy_stream (output_file, f);
+	  if (fclose (f) != 0 || rename (tmp_name, automata_cache_file_name))
+	    remove (tmp_name);
+	}
+      free (tmp_name);
+      free (key);
+    }
+  fclose (output_file);
+  output_file = stdout;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -9482,6 +9698,7 @@ main (int argc, char **argv)
     return (FATAL_EXIT_CODE);
 
   initiate_automaton_gen (argc, argv);
+  initiate_automata_cache ();
   while (1)
     {
       int lineno;
@@ -9542,19 +9759,21 @@ main (int argc, char **argv)
 	  break;
 
 	default:
-	  break;
+	  continue;
 	}
+      if (automata_cache_key != NULL)
+	print_rtl (automata_cache_key, desc);
     }
 
   if (have_error)
     return FATAL_EXIT_CODE;
 
-  if (VEC_length (decl_t, decls) > 0)
+  if (VEC_length (decl_t, decls) > 0 && !read_automata_cache ())
     {
       expand_automata ();
       if (!have_error)
 	{
-	  puts ("/* Generated automatically by the program `genautomata'\n"
+	  fputs ("/* Generated automatically by the program `genautomata'\n"
 		"   from the machine description file `md'.  */\n\n"
 		"#include \"config.h\"\n"
 		"#include \"system.h\"\n"
@@ -9570,10 +9789,11 @@ main (int argc, char **argv)
 		"#include \"insn-attr.h\"\n"
 		"#include \"toplev.h\"\n"
 		"#include \"flags.h\"\n"
-		"#include \"function.h\"\n");
+		"#include \"function.h\"\n\n", output_file);
 
 	  write_automata ();
 	}
+      write_automata_cache ();
     }
 
   fflush (stdout);
@@ -1692,9 +1692,12 @@ simplify_tests (struct decision_head *head)
       if (b)
 	{
 	  /* Due to how these tests are constructed, we don't even need
-	     to check that the mode and code are compatible -- they were
-	     generated from the predicate in the first place.  */
-	  while (a->type == DT_mode || a->type == DT_code)
+	     to check that the mode is compatible -- it was generated from
+	     the predicate in the first place.  The code was too, but it
+	     is only there if the predicate accepts just that code, and
+	     comparing it is cheaper than calling the predicate to reject
+	     an operand with another code.  */
+	  while (a->type == DT_mode)
 	    a = a->next;
 	  tree->tests = a;
 	}
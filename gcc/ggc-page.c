@@ -20,6 +20,9 @@ along with GCC; see the file COPYING3.  If not see
 
 #include "config.h"
 #include "system.h"
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
 #include "coretypes.h"
 #include "tm.h"
 #include "tree.h"
@@ -64,6 +67,13 @@ along with GCC; see the file COPYING3.  If not see
 #define USING_MALLOC_PAGE_GROUPS
 #endif
 
+/* With madvise we can hand the memory of free pages back to the system
+   while keeping their address range mapped, which is what GC arenas
+   rely on.  */
+#if defined (USING_MMAP) && defined (MADV_DONTNEED)
+# define USING_MADVISE
+#endif
+
 /* Strategy:
 
    This garbage-collecting allocator allocates objects on one of a set
@@ -91,7 +101,15 @@ along with GCC; see the file COPYING3.  If not see
    Empty pages (of all orders) are kept on a single page cache list,
    and are considered first when new pages are required; they are
    deallocated at the start of the next collection if they haven't
-   been recycled by then.  */
+   been recycled by then.
+
+   If --param ggc-arena-size is nonzero and the host has madvise,
+   single system pages are instead carved out of large arenas aligned
+   for transparent huge pages.  Arena pages are never unmapped: when a
+   cached arena page is deallocated its memory is returned to the
+   system with madvise (MADV_DONTNEED), and the page stays on the cache
+   list for reuse.  This keeps the number of mappings, and the TLB
+   footprint of the heap, small.  */
 
 /* Define GGC_DEBUG_LEVEL to print debugging information.
      0: No debugging output.
@@ -291,6 +309,16 @@ typedef struct page_entry
   /* The lg of size of objects allocated from this page.  */
   unsigned char order;
 
+#ifdef USING_MADVISE
+  /* Nonzero if this page was carved out of a GC arena.  Such pages are
+     never unmapped.  */
+  unsigned char in_arena;
+
+  /* Nonzero if this page is on the free list and its memory has been
+     handed back to the system.  */
+  unsigned char discarded;
+#endif
+
   /* A bit vector indicating whether or not objects are in use.  The
      Nth bit is one if the Nth object on this page is allocated.  This
      array is dynamically sized.  */
@@ -375,6 +403,30 @@ static struct globals
   /* Total amount of memory mapped.  */
   size_t bytes_mapped;
 
+  /* The largest value bytes_mapped has reached.  */
+  size_t bytes_mapped_peak;
+
+  /* Number of regions mapped and unmapped.  */
+  unsigned long map_count;
+  unsigned long unmap_count;
+
+#ifdef USING_MADVISE
+  /* Number of calls made to madvise to discard free pages.  */
+  unsigned long discard_count;
+
+  /* Number of arenas allocated, and the total size of those.  */
+  unsigned long arena_count;
+  size_t arena_bytes;
+
+  /* Range of the current arena not yet handed out as pages.  */
+  char *arena_next;
+  char *arena_end;
+
+  /* Bytes of free arena pages whose memory is currently given back to
+     the system.  */
+  size_t bytes_discarded;
+#endif
+
   /* Bit N set if any allocations have been done at context depth N.  */
   unsigned long context_depth_allocations;
 
@@ -482,6 +534,13 @@ static struct globals
 # endif
 #endif
 
+/* Alignment of GC arenas.  Transparent huge pages on common hosts are
+   2MB, and the kernel can only back an aligned range with them.  Hosts
+   that need a different value can override this.  */
+#ifndef GGC_ARENA_ALIGN
+# define GGC_ARENA_ALIGN (2 * 1024 * 1024)
+#endif
+
 /* Initial guess as to how many page table entries we might need.  */
 #define INITIAL_PTE_COUNT 128
 
@@ -491,6 +550,9 @@ static void set_page_table_entry (void *, page_entry *);
 #ifdef USING_MMAP
 static char *alloc_anon (char *, size_t);
 #endif
+#ifdef USING_MADVISE
+static char *alloc_arena_page (void);
+#endif
 #ifdef USING_MALLOC_PAGE_GROUPS
 static size_t page_group_index (char *, char *);
 static void set_page_group_in_use (page_group *, char *);
@@ -687,6 +749,9 @@ alloc_anon (char *pref ATTRIBUTE_UNUSED, size_t size)
 
   /* Remember that we allocated this memory.  */
   G.bytes_mapped += size;
+  G.map_count++;
+  if (G.bytes_mapped > G.bytes_mapped_peak)
+    G.bytes_mapped_peak = G.bytes_mapped;
 
   /* Pretend we don't have access to the allocated pages.  We'll enable
      access to smaller pieces of the area in ggc_alloc.  Discard the
@@ -696,6 +761,57 @@ alloc_anon (char *pref ATTRIBUTE_UNUSED, size_t size)
   return page;
 }
 #endif
+#ifdef USING_MADVISE
+/* Return the next system page of the current GC arena, allocating a
+   new arena of --param ggc-arena-size kilobytes if the current one is
+   used up.  Return NULL if arenas are disabled.  */
+
+static char *
+alloc_arena_page (void)
+{
+  char *page;
+
+  if (G.arena_next == G.arena_end)
+    {
+      size_t align = MAX (G.pagesize, GGC_ARENA_ALIGN);
+      size_t size, head, tail;
+      char *region;
+
+      /* The first pages are needed before the parameters have been
+	 registered; map those the usual way.  */
+      if (compiler_params == NULL)
+	return NULL;
+      size = (size_t) PARAM_VALUE (GGC_ARENA_SIZE) * 1024;
+      if (size == 0)
+	return NULL;
+      size = ROUND_UP (size, align);
+
+      /* Over-allocate so that an aligned range of SIZE bytes is sure to
+	 fit, then give back the slop on either side.  */
+      region = alloc_anon (NULL, size + align - G.pagesize);
+      head = ROUND_UP ((size_t) region, align) - (size_t) region;
+      tail = align - G.pagesize - head;
+      if (head)
+	munmap (region, head);
+      if (tail)
+	munmap (region + head + size, tail);
+      G.bytes_mapped -= head + tail;
+
+#ifdef MADV_HUGEPAGE
+      madvise (region + head, size, MADV_HUGEPAGE);
+#endif
+
+      G.arena_next = region + head;
+      G.arena_end = G.arena_next + size;
+      G.arena_count++;
+      G.arena_bytes += size;
+    }
+
+  page = G.arena_next;
+  G.arena_next += G.pagesize;
+  return page;
+}
+#endif
 #ifdef USING_MALLOC_PAGE_GROUPS
 /* Compute the index for this page into the page group.  */
 
@@ -736,6 +852,9 @@ alloc_page (unsigned order)
 #ifdef USING_MALLOC_PAGE_GROUPS
   page_group *group;
 #endif
+#ifdef USING_MADVISE
+  unsigned char in_arena = 0;
+#endif
 
   num_objects = OBJECTS_PER_PAGE (order);
   bitmap_size = BITMAP_SIZE (num_objects + 1);
@@ -761,6 +880,11 @@ alloc_page (unsigned order)
 #ifdef USING_MALLOC_PAGE_GROUPS
       group = p->group;
 #endif
+#ifdef USING_MADVISE
+      in_arena = p->in_arena;
+      if (p->discarded)
+	G.bytes_discarded -= p->bytes;
+#endif
 
       /* ... and, if possible, the page entry itself.  */
       if (p->order == order)
@@ -771,6 +895,11 @@ alloc_page (unsigned order)
       else
 	free (p);
     }
+#ifdef USING_MADVISE
+  else if (entry_size == G.pagesize
+	   && (page = alloc_arena_page ()) != NULL)
+    in_arena = 1;
+#endif
 #ifdef USING_MMAP
   else if (entry_size == G.pagesize)
     {
@@ -850,6 +979,9 @@ alloc_page (unsigned order)
       group->in_use = 0;
       G.page_groups = group;
       G.bytes_mapped += alloc_size;
+      G.map_count++;
+      if (G.bytes_mapped > G.bytes_mapped_peak)
+	G.bytes_mapped_peak = G.bytes_mapped;
 
       /* If we allocated multiple pages, put the rest on the free list.  */
       if (multiple_pages)
@@ -886,6 +1018,9 @@ alloc_page (unsigned order)
   entry->group = group;
   set_page_group_in_use (group, page);
 #endif
+#ifdef USING_MADVISE
+  entry->in_arena = in_arena;
+#endif
 
   /* Set the one-past-the-end in-use bit.  This acts as a sentry as we
      increment the hint.  */
@@ -971,22 +1106,59 @@ static void
 release_pages (void)
 {
 #ifdef USING_MMAP
-  page_entry *p, *next;
+  page_entry *p, *next, **pp;
   char *start;
   size_t len;
 
+#ifdef USING_MADVISE
+  /* Give back the memory of free arena pages, but keep the pages
+     themselves cached.  Adjacent pages are discarded together.  */
+  for (p = G.free_pages; p; p = next)
+    {
+      next = p->next;
+      if (!p->in_arena || p->discarded)
+	continue;
+
+      start = p->page;
+      len = p->bytes;
+      p->discarded = 1;
+      while (next && next->in_arena && !next->discarded
+	     && next->page == start + len)
+	{
+	  len += next->bytes;
+	  next->discarded = 1;
+	  next = next->next;
+	}
+
+      madvise (start, len, MADV_DONTNEED);
+      G.bytes_discarded += len;
+      G.discard_count++;
+    }
+#endif
+
   /* Gather up adjacent pages so they are unmapped together.  */
-  p = G.free_pages;
+  pp = &G.free_pages;
 
-  while (p)
+  while ((p = *pp) != NULL)
     {
+#ifdef USING_MADVISE
+      if (p->in_arena)
+	{
+	  pp = &p->next;
+	  continue;
+	}
+#endif
       start = p->page;
       next = p->next;
       len = p->bytes;
       free (p);
       p = next;
 
-      while (p && p->page == start + len)
+      while (p && p->page == start + len
+#ifdef USING_MADVISE
+	     && !p->in_arena
+#endif
+	     )
 	{
 	  next = p->next;
 	  len += p->bytes;
@@ -994,11 +1166,11 @@ release_pages (void)
 	  p = next;
 	}
 
+      *pp = p;
       munmap (start, len);
       G.bytes_mapped -= len;
+      G.unmap_count++;
     }
-
-  G.free_pages = NULL;
 #endif
 #ifdef USING_MALLOC_PAGE_GROUPS
   page_entry **pp, *p;
@@ -1022,6 +1194,7 @@ release_pages (void)
       {
 	*gp = g->next;
 	G.bytes_mapped -= g->alloc_size;
+	G.unmap_count++;
 	free (g->allocation);
       }
     else
@@ -1979,6 +2152,14 @@ ggc_collect (void)
     fprintf (G.debug_file, "END COLLECTING\n");
 }
 
+/* Return the number of bytes allocated in the GC heap.  */
+
+size_t
+ggc_heap_allocated (void)
+{
+  return G.allocated;
+}
+
 /* Print allocation statistics.  */
 #define SCALE(x) ((unsigned long) ((x) < 1024*10 \
 		  ? (x) \
@@ -2050,6 +2231,34 @@ ggc_print_statistics (void)
 	   SCALE (G.allocated), STAT_LABEL(G.allocated),
 	   SCALE (total_overhead), STAT_LABEL (total_overhead));
 
+  /* Report on how the heap is laid out in the address space.  Each
+     mapping costs the kernel a VMA, and scattered small mappings cost
+     page table walks and TLB entries.  */
+  fprintf (stderr, "\nPeak mapped:     %10lu%c\n",
+	   SCALE (G.bytes_mapped_peak), STAT_LABEL (G.bytes_mapped_peak));
+#if defined (HAVE_GETRUSAGE) && defined (HAVE_SYS_RESOURCE_H)
+  {
+    struct rusage usage;
+    if (getrusage (RUSAGE_SELF, &usage) == 0)
+      {
+	/* ru_maxrss is in kilobytes.  */
+	size_t peak_rss = (size_t) usage.ru_maxrss * 1024;
+	fprintf (stderr, "Peak RSS:        %10lu%c\n",
+		 SCALE (peak_rss), STAT_LABEL (peak_rss));
+      }
+  }
+#endif
+  fprintf (stderr, "Regions mapped:  %10lu\n", G.map_count);
+  fprintf (stderr, "Regions unmapped:%10lu\n", G.unmap_count);
+#ifdef USING_MADVISE
+  fprintf (stderr, "Arenas:          %10lu (%lu%c, aligned to %luk)\n",
+	   G.arena_count, SCALE (G.arena_bytes), STAT_LABEL (G.arena_bytes),
+	   (unsigned long) MAX (G.pagesize, GGC_ARENA_ALIGN) / 1024);
+  fprintf (stderr, "Discard calls:   %10lu\n", G.discard_count);
+  fprintf (stderr, "Discarded:       %10lu%c\n",
+	   SCALE (G.bytes_discarded), STAT_LABEL (G.bytes_discarded));
+#endif
+
 #ifdef GATHER_STATISTICS
   {
     fprintf (stderr, "\nTotal allocations and overheads during the compilation process\n");
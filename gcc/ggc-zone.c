@@ -2101,6 +2101,19 @@ ggc_collect (void)
   timevar_pop (TV_GC);
 }
 
+/* Return the number of bytes allocated in the GC heap.  */
+
+size_t
+ggc_heap_allocated (void)
+{
+  struct alloc_zone *zone;
+  size_t allocated = 0;
+
+  for (zone = G.zones; zone; zone = zone->next_zone)
+    allocated += zone->allocated;
+  return allocated;
+}
+
 /* Print allocation statistics.  */
 #define SCALE(x) ((unsigned long) ((x) < 1024*10 \
 		  ? (x) \
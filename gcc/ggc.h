@@ -304,6 +304,10 @@ extern void ggc_print_common_statistics (FILE *, ggc_statistics *);
 
 /* Print allocation statistics.  */
 extern void ggc_print_statistics (void);
+
+/* Return the number of bytes allocated in the GC heap, including
+   garbage not yet collected.  */
+extern size_t ggc_heap_allocated (void);
 extern void stringpool_statistics (void);
 
 /* Heuristics.  */
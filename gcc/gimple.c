@@ -40,9 +40,13 @@ along with GCC; see the file COPYING3.  If not see
 /* Global type table.  FIXME lto, it should be possible to re-use some
    of the type hashing routines in tree.c (type_hash_canon, type_hash_lookup,
    etc), but those assume that types were built with the various
-   build_*_type routines which is not the case with the streamer.  */
-static htab_t gimple_types;
-static struct pointer_map_t *type_hash_cache;
+   build_*_type routines which is not the case with the streamer.
+   Both tables live in GC memory and forget the types that are
+   collected, so that LTO can collect garbage while it merges types.  */
+static GTY((if_marked ("ggc_marked_p"), param_is (union tree_node)))
+  htab_t gimple_types;
+static GTY((if_marked ("tree_int_map_marked_p"), param_is (struct tree_int_map)))
+  htab_t type_hash_cache;
 
 /* Global type comparison cache.  */
 static htab_t gtc_visited;
@@ -3530,6 +3534,32 @@ static hashval_t
 iterative_hash_gimple_type (tree, hashval_t, VEC(tree, heap) **,
 			    struct pointer_map_t *, struct obstack *);
 
+/* Return the entry of type_hash_cache for T, or NULL if its hash value
+   has not been computed yet.  */
+
+static struct tree_int_map *
+lookup_type_hash (const_tree t)
+{
+  struct tree_int_map in;
+
+  in.base.from = CONST_CAST_TREE (t);
+  return (struct tree_int_map *) htab_find (type_hash_cache, &in);
+}
+
+/* Record VAL as the hash value of T in type_hash_cache.  */
+
+static void
+record_type_hash (tree t, hashval_t val)
+{
+  struct tree_int_map *h = GGC_NEW (struct tree_int_map);
+  void **slot;
+
+  h->base.from = t;
+  h->to = val;
+  slot = htab_find_slot (type_hash_cache, h, INSERT);
+  *(struct tree_int_map **) slot = h;
+}
+
 /* DFS visit the edge from the callers type with state *STATE to T.
    Update the callers type hash V with the hash for T if it is not part
    of the SCC containing the callers type and return it.
@@ -3542,12 +3572,13 @@ visit (tree t, struct sccs *state, hashval_t v,
        struct obstack *sccstate_obstack)
 {
   struct sccs *cstate = NULL;
+  struct tree_int_map *h;
   void **slot;
 
   /* If there is a hash value recorded for this type then it can't
      possibly be part of our parent SCC.  Simply mix in its hash.  */
-  if ((slot = pointer_map_contains (type_hash_cache, t)))
-    return iterative_hash_hashval_t ((hashval_t) (size_t) *slot, v);
+  if ((h = lookup_type_hash (t)))
+    return iterative_hash_hashval_t (h->to, v);
 
   if ((slot = pointer_map_contains (sccstate, t)) != NULL)
     cstate = (struct sccs *)*slot;
@@ -3610,12 +3641,11 @@ iterative_hash_gimple_type (tree type, hashval_t val,
 			    struct obstack *sccstate_obstack)
 {
   hashval_t v;
-  void **slot;
   struct sccs *state;
 
 #ifdef ENABLE_CHECKING
   /* Not visited during this DFS walk nor during previous walks.  */
-  gcc_assert (!pointer_map_contains (type_hash_cache, type)
+  gcc_assert (!lookup_type_hash (type)
 	      && !pointer_map_contains (sccstate, type));
 #endif
   state = XOBNEW (sccstate_obstack, struct sccs);
@@ -3748,11 +3778,10 @@ iterative_hash_gimple_type (tree type, hashval_t val,
 	{
 	  struct sccs *cstate;
 	  x = VEC_pop (tree, *sccstack);
-	  gcc_assert (!pointer_map_contains (type_hash_cache, x));
+	  gcc_assert (!lookup_type_hash (x));
 	  cstate = (struct sccs *)*pointer_map_contains (sccstate, x);
 	  cstate->on_sccstack = false;
-	  slot = pointer_map_insert (type_hash_cache, x);
-	  *slot = (void *) (size_t) cstate->hash;
+	  record_type_hash (x, cstate->hash);
 	}
       while (x != type);
     }
@@ -3777,13 +3806,14 @@ gimple_type_hash (const void *p)
   struct pointer_map_t *sccstate;
   struct obstack sccstate_obstack;
   hashval_t val;
-  void **slot;
+  struct tree_int_map *h;
 
   if (type_hash_cache == NULL)
-    type_hash_cache = pointer_map_create ();
+    type_hash_cache = htab_create_ggc (512, tree_int_map_hash,
+				       tree_int_map_eq, NULL);
 
-  if ((slot = pointer_map_contains (type_hash_cache, p)) != NULL)
-    return iterative_hash_hashval_t ((hashval_t) (size_t) *slot, 0);
+  if ((h = lookup_type_hash (t)) != NULL)
+    return iterative_hash_hashval_t (h->to, 0);
 
   /* Perform a DFS walk and pre-hash all reachable types.  */
   next_dfs_num = 1;
@@ -3829,7 +3859,7 @@ gimple_register_type (tree t)
     gimple_register_type (TYPE_MAIN_VARIANT (t));
 
   if (gimple_types == NULL)
-    gimple_types = htab_create (16381, gimple_type_hash, gimple_type_eq, 0);
+    gimple_types = htab_create_ggc (16381, gimple_type_hash, gimple_type_eq, 0);
 
   slot = htab_find_slot (gimple_types, t, INSERT);
   if (*slot
@@ -3937,7 +3967,7 @@ free_gimple_type_tables (void)
     }
   if (type_hash_cache)
     {
-      pointer_map_destroy (type_hash_cache);
+      htab_delete (type_hash_cache);
       type_hash_cache = NULL;
     }
   if (gtc_visited)
@@ -61,20 +61,63 @@ static IRA_INT_TYPE **conflicts;
 
 
 
+/* When an allocno range starts while more than this many times as
+   many allocnos are live as there are words in its conflict bit
+   vector, its conflicts are recorded by or-ing whole words of the
+   live allocno sets rather than bit by bit.  */
+#define CONFLICT_VECTOR_RATIO 2
+
+/* Set in CONFLICT_VEC, which represents conflict ids MIN..MAX, all the
+   bits of LIVE_VEC, a set of all conflict ids, in that range.  */
+static void
+ior_live_allocno_set (IRA_INT_TYPE *conflict_vec, int min, int max,
+		      const IRA_INT_TYPE *live_vec, int live_words)
+{
+  unsigned HOST_WIDE_INT w;
+  int k, words, base, shift;
+
+  words = (max - min) / IRA_INT_BITS + 1;
+  base = min / IRA_INT_BITS;
+  shift = min % IRA_INT_BITS;
+  for (k = 0; k < words; k++)
+    {
+      w = (unsigned HOST_WIDE_INT) live_vec[base + k] >> shift;
+      if (shift != 0 && base + k + 1 < live_words)
+	w |= ((unsigned HOST_WIDE_INT) live_vec[base + k + 1]
+	      << (IRA_INT_BITS - shift));
+      if (k == words - 1 && (max - min + 1) % IRA_INT_BITS != 0)
+	w &= (((unsigned HOST_WIDE_INT) 1 << ((max - min + 1) % IRA_INT_BITS))
+	      - 1);
+      conflict_vec[k] |= (IRA_INT_TYPE) w;
+    }
+}
+
 /* Build allocno conflict table by processing allocno live ranges.
    Return true if the table was built.  The table is not built if it
-   is too big.  */
+   is too big.
+
+   The program points are swept in order keeping the set of live
+   allocnos.  When a range of an allocno starts, it conflicts with all
+   live allocnos of an intersecting cover class.  If only a few are
+   live, the conflicts are recorded for both allocnos one by one.
+   Otherwise the live allocnos of each cover class are also kept as a
+   bit vector indexed by conflict id, which is or-ed word by word into
+   the conflict vector of the starting allocno; the conflict table is
+   made symmetric after the sweep.  */
 static bool
 build_conflict_bit_table (void)
 {
   int i, num, id, allocated_words_num, conflict_bit_vec_words_num;
+  int live_num, min, max, n, c, vector_starts_num, bit_starts_num;
   unsigned int j;
   enum reg_class cover_class;
   ira_allocno_t allocno, live_a;
   allocno_live_range_t r;
   ira_allocno_iterator ai;
+  ira_allocno_set_iterator asi;
   sparseset allocnos_live;
   int allocno_set_words;
+  IRA_INT_TYPE *live_vecs[N_REG_CLASSES];
 
   allocno_set_words = (ira_allocnos_num + IRA_INT_BITS - 1) / IRA_INT_BITS;
   allocated_words_num = 0;
@@ -125,6 +168,17 @@ build_conflict_bit_table (void)
        "+++Allocating %ld bytes for conflict table (uncompressed size %ld)\n",
        (long) allocated_words_num * sizeof (IRA_INT_TYPE),
        (long) allocno_set_words * ira_allocnos_num * sizeof (IRA_INT_TYPE));
+  memset (live_vecs, 0, sizeof (live_vecs));
+  for (i = 0; i < ira_reg_class_cover_size; i++)
+    {
+      cover_class = ira_reg_class_cover[i];
+      live_vecs[cover_class]
+	= (IRA_INT_TYPE *) ira_allocate (sizeof (IRA_INT_TYPE)
+					 * allocno_set_words);
+      memset (live_vecs[cover_class], 0,
+	      sizeof (IRA_INT_TYPE) * allocno_set_words);
+    }
+  vector_starts_num = bit_starts_num = 0;
   for (i = 0; i < ira_max_point; i++)
     {
       for (r = ira_start_point_ranges[i]; r != NULL; r = r->start_next)
@@ -133,30 +187,85 @@ build_conflict_bit_table (void)
 	  num = ALLOCNO_NUM (allocno);
 	  id = ALLOCNO_CONFLICT_ID (allocno);
 	  cover_class = ALLOCNO_COVER_CLASS (allocno);
-	  sparseset_set_bit (allocnos_live, num);
-	  EXECUTE_IF_SET_IN_SPARSESET (allocnos_live, j)
+	  min = ALLOCNO_MIN (allocno);
+	  max = ALLOCNO_MAX (allocno);
+	  live_num = sparseset_cardinality (allocnos_live);
+	  if (conflicts[num] != NULL
+	      && live_num > (CONFLICT_VECTOR_RATIO
+			     * ((max - min) / IRA_INT_BITS + 1)))
 	    {
-	      live_a = ira_allocnos[j];
-	      if (ira_reg_classes_intersect_p
-		  [cover_class][ALLOCNO_COVER_CLASS (live_a)]
-		  /* Don't set up conflict for the allocno with itself.  */
-		  && num != (int) j)
+	      vector_starts_num++;
+	      for (c = 0; c < ira_reg_class_cover_size; c++)
+		if (ira_reg_classes_intersect_p
+		    [cover_class][ira_reg_class_cover[c]])
+		  ior_live_allocno_set (conflicts[num], min, max,
+					live_vecs[ira_reg_class_cover[c]],
+					allocno_set_words);
+	      /* Don't set up conflict for the allocno with itself.  */
+	      if (min <= id && id <= max)
+		CLEAR_ALLOCNO_SET_BIT (conflicts[num], id, min, max);
+	    }
+	  else
+	    {
+	      bit_starts_num++;
+	      EXECUTE_IF_SET_IN_SPARSESET (allocnos_live, j)
 		{
-		  SET_ALLOCNO_SET_BIT (conflicts[num],
-				       ALLOCNO_CONFLICT_ID (live_a),
-				       ALLOCNO_MIN (allocno),
-				       ALLOCNO_MAX (allocno));
-		  SET_ALLOCNO_SET_BIT (conflicts[j], id,
-				       ALLOCNO_MIN (live_a),
-				       ALLOCNO_MAX (live_a));
+		  live_a = ira_allocnos[j];
+		  if (ira_reg_classes_intersect_p
+		      [cover_class][ALLOCNO_COVER_CLASS (live_a)]
+		      /* Don't set up conflict for the allocno with
+			 itself.  */
+		      && num != (int) j)
+		    {
+		      SET_ALLOCNO_SET_BIT (conflicts[num],
+					   ALLOCNO_CONFLICT_ID (live_a),
+					   min, max);
+		      SET_ALLOCNO_SET_BIT (conflicts[j], id,
+					   ALLOCNO_MIN (live_a),
+					   ALLOCNO_MAX (live_a));
+		    }
 		}
 	    }
+	  sparseset_set_bit (allocnos_live, num);
+	  if (live_vecs[cover_class] != NULL)
+	    SET_ALLOCNO_SET_BIT (live_vecs[cover_class], id,
+				 0, ira_allocnos_num - 1);
 	}
 
       for (r = ira_finish_point_ranges[i]; r != NULL; r = r->finish_next)
-	sparseset_clear_bit (allocnos_live, ALLOCNO_NUM (r->allocno));
+	{
+	  allocno = r->allocno;
+	  sparseset_clear_bit (allocnos_live, ALLOCNO_NUM (allocno));
+	  if (live_vecs[ALLOCNO_COVER_CLASS (allocno)] != NULL)
+	    CLEAR_ALLOCNO_SET_BIT (live_vecs[ALLOCNO_COVER_CLASS (allocno)],
+				   ALLOCNO_CONFLICT_ID (allocno),
+				   0, ira_allocnos_num - 1);
+	}
     }
+  for (i = 0; i < ira_reg_class_cover_size; i++)
+    ira_free (live_vecs[ira_reg_class_cover[i]]);
   sparseset_free (allocnos_live);
+  if (vector_starts_num != 0)
+    /* The conflicts found by or-ing live sets were only recorded for
+       the allocno whose range started later.  */
+    FOR_EACH_ALLOCNO (allocno, ai)
+      {
+	num = ALLOCNO_NUM (allocno);
+	if (conflicts[num] == NULL)
+	  continue;
+	id = ALLOCNO_CONFLICT_ID (allocno);
+	FOR_EACH_ALLOCNO_IN_SET (conflicts[num], ALLOCNO_MIN (allocno),
+				 ALLOCNO_MAX (allocno), n, asi)
+	  {
+	    live_a = ira_conflict_id_allocno_map[n];
+	    SET_ALLOCNO_SET_BIT (conflicts[ALLOCNO_NUM (live_a)], id,
+				 ALLOCNO_MIN (live_a), ALLOCNO_MAX (live_a));
+	  }
+      }
+  if (internal_flag_ira_verbose > 0 && ira_dump_file != NULL)
+    fprintf (ira_dump_file,
+	     "+++Conflict sweep: %d range starts by bits, %d by vectors\n",
+	     bit_starts_num, vector_starts_num);
   return true;
 }
 
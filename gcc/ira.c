@@ -3123,6 +3123,7 @@ ira (FILE *f)
   int max_regno_before_ira, ira_max_point_before_emit;
   int rebuild_p;
   int saved_flag_ira_share_spill_slots;
+  enum ira_region saved_flag_ira_region;
   basic_block bb;
 
   timevar_push (TV_IRA);
@@ -3210,6 +3211,25 @@ ira (FILE *f)
   record_loop_exits ();
   current_loops = &ira_loops;
 
+  saved_flag_ira_region = flag_ira_region;
+  if (optimize
+      && (flag_ira_region == IRA_REGION_ALL
+	  || flag_ira_region == IRA_REGION_MIXED)
+      && IRA_MAX_REGIONAL_PSEUDOS != 0
+      && max_reg_num () - FIRST_PSEUDO_REGISTER > IRA_MAX_REGIONAL_PSEUDOS)
+    {
+      /* Regional allocation creates allocnos for each pseudo in each
+	 region it lives in, and the conflict building and coloring
+	 times grow with their number.  For huge functions, this is
+	 not worth the better allocation.  */
+      if (internal_flag_ira_verbose > 0 && ira_dump_file != NULL)
+	fprintf (ira_dump_file,
+		 "+++Too many pseudos (%d > %d) -- allocate in one region\n",
+		 max_reg_num () - FIRST_PSEUDO_REGISTER,
+		 IRA_MAX_REGIONAL_PSEUDOS);
+      flag_ira_region = IRA_REGION_ONE;
+    }
+
   if (internal_flag_ira_verbose > 0 && ira_dump_file != NULL)
     fprintf (ira_dump_file, "Building IRA IR\n");
   loops_p = ira_build (optimize
@@ -3333,6 +3353,7 @@ ira (FILE *f)
   ira_destroy ();
 
   flag_ira_share_spill_slots = saved_flag_ira_share_spill_slots;
+  flag_ira_region = saved_flag_ira_region;
 
   flow_loops_free (&ira_loops);
   free_dominance_info (CDI_DOMINATORS);
@@ -28,11 +28,13 @@ along with GCC; see the file COPYING3.  If not see
 #include <zlib.h>
 #include "coretypes.h"
 #include "tree.h"
+#include "flags.h"
 #include "diagnostic.h"
 #include "errors.h"
 #include "langhooks.h"
 #include "lto-streamer.h"
 #include "lto-compress.h"
+#include "timevar.h"
 
 /* Compression stream structure, holds the flush callback and opaque token,
    the buffered data, and a note of whether compressing or uncompressing.  */
@@ -91,6 +93,236 @@ lto_normalized_zlib_level (void)
   return level;
 }
 
+/* The LZ codec is a byte oriented LZ77 compressor in the style of LZ4.
+   It compresses worse than zlib, but both ways it is several times
+   faster.  A compressed segment is LZ_MAGIC, followed by the lengths of
+   the uncompressed and the compressed data as 32-bit little endian
+   numbers, followed by the compressed data.  The low four bits of the
+   first byte of a zlib stream are always 8, so LZ_MAGIC distinguishes
+   the two.
+
+   The compressed data is a series of sequences.  A sequence starts with
+   a token byte, whose high and low four bits are the number of literal
+   bytes and the length of the match minus LZ_MIN_MATCH.  A value of 15
+   is followed by further bytes that are added to it, up to and including
+   the first that is not 255.  After the literals come the two byte
+   little endian offset of the match and the extension of its length.
+   The last sequence has only literals.  */
+
+#define LZ_MAGIC 0x4c
+#define LZ_HEADER_LENGTH 9
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+#define LZ_MAX_OFFSET 65535
+#define LZ_MAX_HASH_BITS 14
+
+/* Store the low 32 bits of VALUE at P in little endian order.  */
+
+static inline void
+lz_put_32 (unsigned char *p, size_t value)
+{
+  p[0] = value & 0xff;
+  p[1] = (value >> 8) & 0xff;
+  p[2] = (value >> 16) & 0xff;
+  p[3] = (value >> 24) & 0xff;
+}
+
+/* Return the 32-bit little endian number at P.  */
+
+static inline unsigned int
+lz_get_32 (const unsigned char *p)
+{
+  return (p[0] | (p[1] << 8) | (p[2] << 16)
+	  | ((unsigned int) p[3] << 24));
+}
+
+/* Return the largest number of bytes lz_compress can produce for SIZE
+   bytes of input.  */
+
+static inline size_t
+lz_compress_bound (size_t size)
+{
+  return size + size / 255 + 16;
+}
+
+/* Write the extension of length LEN to OP and return the new end.  */
+
+static unsigned char *
+lz_put_length (unsigned char *op, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = len;
+  return op;
+}
+
+/* Write to OP the sequence of NUM_LITERALS bytes from LITERALS followed
+   by a match of MATCH_LENGTH bytes at OFFSET, or by nothing if
+   MATCH_LENGTH is zero.  Return the new end.  */
+
+static unsigned char *
+lz_put_sequence (unsigned char *op, const unsigned char *literals,
+		 size_t num_literals, size_t offset, size_t match_length)
+{
+  unsigned char *token = op++;
+
+  *token = (num_literals < 15 ? num_literals : 15) << 4;
+  if (num_literals >= 15)
+    op = lz_put_length (op, num_literals - 15);
+  memcpy (op, literals, num_literals);
+  op += num_literals;
+
+  if (match_length != 0)
+    {
+      size_t len = match_length - LZ_MIN_MATCH;
+
+      *op++ = offset & 0xff;
+      *op++ = offset >> 8;
+      *token |= len < 15 ? len : 15;
+      if (len >= 15)
+	op = lz_put_length (op, len - 15);
+    }
+
+  return op;
+}
+
+/* Compress the SIZE bytes at IN to OUT, which must have room for
+   lz_compress_bound (SIZE) bytes, and return the compressed length.
+   Unless SEARCH, store the data without looking for matches.  */
+
+static size_t
+lz_compress (const unsigned char *in, size_t size, unsigned char *out,
+	     bool search)
+{
+  unsigned char *op = out;
+  size_t ip = 0, anchor = 0;
+
+  if (search && size > LZ_MIN_MATCH + LZ_LAST_LITERALS)
+    {
+      /* The hash table maps the hash of four bytes to one more than the
+	 position where they were last seen.  Small inputs get a small
+	 table, as a function body section often is only a few hundred
+	 bytes long.  */
+      size_t limit = size - LZ_LAST_LITERALS;
+      int hash_bits = 8;
+      unsigned int *table;
+
+      while (hash_bits < LZ_MAX_HASH_BITS && ((size_t) 1 << hash_bits) < size)
+	hash_bits++;
+      table = XCNEWVEC (unsigned int, 1 << hash_bits);
+
+      while (ip + LZ_MIN_MATCH <= limit)
+	{
+	  unsigned int value = lz_get_32 (in + ip);
+	  unsigned int hash = ((value * 2654435761U) & 0xffffffff)
+			      >> (32 - hash_bits);
+	  size_t ref = table[hash];
+
+	  table[hash] = ip + 1;
+	  if (ref != 0
+	      && ip - (ref - 1) <= LZ_MAX_OFFSET
+	      && lz_get_32 (in + ref - 1) == value)
+	    {
+	      size_t len = LZ_MIN_MATCH;
+
+	      ref--;
+
+	      while (ip + len < limit && in[ref + len] == in[ip + len])
+		len++;
+	      op = lz_put_sequence (op, in + anchor, ip - anchor,
+				    ip - ref, len);
+	      ip += len;
+	      anchor = ip;
+	    }
+	  else
+	    /* Skip ahead faster the longer nothing has matched, so that
+	       incompressible data costs little time.  */
+	    ip += 1 + ((ip - anchor) >> 6);
+	}
+
+      free (table);
+    }
+
+  op = lz_put_sequence (op, in + anchor, size - anchor, 0, 0);
+  return op - out;
+}
+
+/* Read the extension of a length at *IPP, before END, and add it to
+   *LEN.  Return false if the data ends first.  */
+
+static inline bool
+lz_get_length (const unsigned char **ipp, const unsigned char *end,
+	       size_t *len)
+{
+  unsigned int byte;
+
+  do
+    {
+      if (*ipp >= end)
+	return false;
+      byte = *(*ipp)++;
+      *len += byte;
+    }
+  while (byte == 255);
+  return true;
+}
+
+/* Uncompress the IN_SIZE bytes at IN to the OUT_SIZE bytes at OUT.
+   Return false if the data is not valid or does not uncompress to
+   exactly OUT_SIZE bytes.  */
+
+static bool
+lz_uncompress (const unsigned char *in, size_t in_size,
+	       unsigned char *out, size_t out_size)
+{
+  const unsigned char *ip = in, *in_end = in + in_size;
+  unsigned char *op = out, *out_end = out + out_size;
+
+  while (ip < in_end)
+    {
+      unsigned int token = *ip++;
+      size_t len = token >> 4, offset;
+      const unsigned char *ref;
+
+      if (len == 15 && !lz_get_length (&ip, in_end, &len))
+	return false;
+      if ((size_t) (in_end - ip) < len || (size_t) (out_end - op) < len)
+	return false;
+      memcpy (op, ip, len);
+      op += len;
+      ip += len;
+      if (ip == in_end)
+	break;
+
+      if (in_end - ip < 2)
+	return false;
+      offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if (offset == 0 || offset > (size_t) (op - out))
+	return false;
+
+      len = token & 15;
+      if (len == 15 && !lz_get_length (&ip, in_end, &len))
+	return false;
+      len += LZ_MIN_MATCH;
+      if ((size_t) (out_end - op) < len)
+	return false;
+
+      /* The match may overlap the bytes it produces.  */
+      ref = op - offset;
+      if (offset >= len)
+	{
+	  memcpy (op, ref, len);
+	  op += len;
+	}
+      else
+	while (len--)
+	  *op++ = *ref++;
+    }
+
+  return op == out_end;
+}
+
 /* Create a new compression stream, with CALLBACK flush function passed
    OPAQUE token, IS_COMPRESSION indicates if compressing or uncompressing.  */
 
@@ -162,21 +394,19 @@ lto_compress_block (struct lto_compression_stream *stream,
   lto_stats.num_output_il_bytes += num_chars;
 }
 
-/* Finalize STREAM compression, and free stream allocations.  */
+/* Compress the data buffered in STREAM with zlib and pass the result
+   to the flush callback.  */
 
-void
-lto_end_compression (struct lto_compression_stream *stream)
+static void
+lto_zlib_compress (struct lto_compression_stream *stream)
 {
   unsigned char *cursor = (unsigned char *) stream->buffer;
   size_t remaining = stream->bytes;
   const size_t outbuf_length = Z_BUFFER_LENGTH;
   unsigned char *outbuf = (unsigned char *) xmalloc (outbuf_length);
   z_stream out_stream;
-  size_t compressed_bytes = 0;
   int status;
 
-  gcc_assert (stream->is_compression);
-
   out_stream.next_out = outbuf;
   out_stream.avail_out = outbuf_length;
   out_stream.next_in = cursor;
@@ -202,7 +432,6 @@ lto_end_compression (struct lto_compression_stream *stream)
 
       stream->callback ((const char *) outbuf, out_bytes, stream->opaque);
       lto_stats.num_compressed_il_bytes += out_bytes;
-      compressed_bytes += out_bytes;
 
       cursor += in_bytes;
       remaining -= in_bytes;
@@ -218,10 +447,60 @@ lto_end_compression (struct lto_compression_stream *stream)
   if (status != Z_OK)
     internal_error ("compressed stream: %s", zError (status));
 
-  lto_destroy_compression_stream (stream);
   free (outbuf);
 }
 
+/* Compress the data buffered in STREAM with the LZ codec and pass the
+   result to the flush callback as a single segment.  */
+
+static void
+lto_lz_compress (struct lto_compression_stream *stream)
+{
+  size_t bound = LZ_HEADER_LENGTH + lz_compress_bound (stream->bytes);
+  unsigned char *outbuf = XNEWVEC (unsigned char, bound);
+  size_t out_bytes;
+
+  out_bytes = lz_compress ((const unsigned char *) stream->buffer,
+			   stream->bytes, outbuf + LZ_HEADER_LENGTH,
+			   flag_lto_compression_level != 0);
+  gcc_assert (out_bytes <= bound - LZ_HEADER_LENGTH);
+
+  outbuf[0] = LZ_MAGIC;
+  lz_put_32 (outbuf + 1, stream->bytes);
+  lz_put_32 (outbuf + 5, out_bytes);
+  out_bytes += LZ_HEADER_LENGTH;
+
+  stream->callback ((const char *) outbuf, out_bytes, stream->opaque);
+  lto_stats.num_compressed_il_bytes += out_bytes;
+  free (outbuf);
+}
+
+/* Finalize STREAM compression, and free stream allocations.  */
+
+void
+lto_end_compression (struct lto_compression_stream *stream)
+{
+  gcc_assert (stream->is_compression);
+
+  timevar_push (TV_IPA_LTO_COMPRESS);
+  switch (flag_lto_compression)
+    {
+    case LTO_COMPRESSION_ZLIB:
+      lto_zlib_compress (stream);
+      break;
+
+    case LTO_COMPRESSION_LZ:
+      lto_lz_compress (stream);
+      break;
+
+    default:
+      gcc_unreachable ();
+    }
+  timevar_pop (TV_IPA_LTO_COMPRESS);
+
+  lto_destroy_compression_stream (stream);
+}
+
 /* Return a new uncompression stream, with CALLBACK flush function passed
    OPAQUE token.  */
 
@@ -244,71 +523,183 @@ lto_uncompress_block (struct lto_compression_stream *stream,
   lto_stats.num_input_il_bytes += num_chars;
 }
 
-/* Finalize STREAM uncompression, and free stream allocations.
-
-   Because of the way LTO IL streams are compressed, there may be several
-   concatenated compressed segments in the accumulated data, so for this
-   function we iterate decompressions until no data remains.  */
-
-void
-lto_end_uncompression (struct lto_compression_stream *stream)
+/* Uncompress the zlib segment at CURSOR, which is followed by REMAINING
+   bytes of compressed data including it, and pass the result to
+   CALLBACK with OPAQUE.  Add the number of uncompressed bytes to
+   *OUT_TOTAL and return the length of the segment, or return 0 and set
+   *ERRMSG if the segment is corrupt.  */
+
+static size_t
+lto_zlib_uncompress (void (*callback) (const char *, unsigned, void *),
+		     void *opaque, const unsigned char *cursor,
+		     size_t remaining, size_t *out_total,
+		     const char **errmsg)
 {
-  unsigned char *cursor = (unsigned char *) stream->buffer;
-  size_t remaining = stream->bytes;
   const size_t outbuf_length = Z_BUFFER_LENGTH;
-  unsigned char *outbuf = (unsigned char *) xmalloc (outbuf_length);
-  size_t uncompressed_bytes = 0;
+  unsigned char *outbuf;
+  size_t segment_bytes = 0;
+  z_stream in_stream;
+  size_t out_bytes;
+  int status;
 
-  gcc_assert (!stream->is_compression);
+  in_stream.next_in = CONST_CAST (unsigned char *, cursor);
+  in_stream.avail_in = remaining;
+  in_stream.zalloc = lto_zalloc;
+  in_stream.zfree = lto_zfree;
+  in_stream.opaque = Z_NULL;
 
-  while (remaining > 0)
+  status = inflateInit (&in_stream);
+  if (status != Z_OK)
+    {
+      *errmsg = zError (status);
+      return 0;
+    }
+
+  outbuf = (unsigned char *) xmalloc (outbuf_length);
+  in_stream.next_out = outbuf;
+  in_stream.avail_out = outbuf_length;
+
+  do
     {
-      z_stream in_stream;
-      size_t out_bytes;
-      int status;
+      size_t in_bytes;
+
+      status = inflate (&in_stream, Z_SYNC_FLUSH);
+      if (status != Z_OK && status != Z_STREAM_END)
+	{
+	  *errmsg = zError (status);
+	  inflateEnd (&in_stream);
+	  free (outbuf);
+	  return 0;
+	}
+
+      in_bytes = remaining - in_stream.avail_in;
+      out_bytes = outbuf_length - in_stream.avail_out;
+
+      callback ((const char *) outbuf, out_bytes, opaque);
+      *out_total += out_bytes;
+
+      cursor += in_bytes;
+      remaining -= in_bytes;
+      segment_bytes += in_bytes;
 
       in_stream.next_out = outbuf;
       in_stream.avail_out = outbuf_length;
-      in_stream.next_in = cursor;
+      in_stream.next_in = CONST_CAST (unsigned char *, cursor);
       in_stream.avail_in = remaining;
-      in_stream.zalloc = lto_zalloc;
-      in_stream.zfree = lto_zfree;
-      in_stream.opaque = Z_NULL;
+    }
+  while (!(status == Z_STREAM_END && out_bytes == 0));
 
-      status = inflateInit (&in_stream);
-      if (status != Z_OK)
-	internal_error ("compressed stream: %s", zError (status));
+  free (outbuf);
+  status = inflateEnd (&in_stream);
+  if (status != Z_OK)
+    {
+      *errmsg = zError (status);
+      return 0;
+    }
 
-      do
-	{
-	  size_t in_bytes;
+  return segment_bytes;
+}
 
-	  status = inflate (&in_stream, Z_SYNC_FLUSH);
-	  if (status != Z_OK && status != Z_STREAM_END)
-	    internal_error ("compressed stream: %s", zError (status));
+/* Likewise for an LZ segment.  */
 
-	  in_bytes = remaining - in_stream.avail_in;
-	  out_bytes = outbuf_length - in_stream.avail_out;
+static size_t
+lto_lz_uncompress (void (*callback) (const char *, unsigned, void *),
+		   void *opaque, const unsigned char *cursor,
+		   size_t remaining, size_t *out_total,
+		   const char **errmsg)
+{
+  size_t in_bytes, out_bytes;
+  unsigned char *outbuf;
 
-	  stream->callback ((const char *) outbuf, out_bytes, stream->opaque);
-	  lto_stats.num_uncompressed_il_bytes += out_bytes;
-	  uncompressed_bytes += out_bytes;
+  if (remaining < LZ_HEADER_LENGTH)
+    {
+      *errmsg = "truncated LZ segment";
+      return 0;
+    }
+  out_bytes = lz_get_32 (cursor + 1);
+  in_bytes = lz_get_32 (cursor + 5);
+  if (in_bytes > remaining - LZ_HEADER_LENGTH)
+    {
+      *errmsg = "truncated LZ segment";
+      return 0;
+    }
 
-	  cursor += in_bytes;
-	  remaining -= in_bytes;
+  outbuf = XNEWVEC (unsigned char, out_bytes);
+  if (!lz_uncompress (cursor + LZ_HEADER_LENGTH, in_bytes,
+		      outbuf, out_bytes))
+    {
+      *errmsg = "invalid LZ data";
+      free (outbuf);
+      return 0;
+    }
 
-	  in_stream.next_out = outbuf;
-	  in_stream.avail_out = outbuf_length;
-	  in_stream.next_in = cursor;
-	  in_stream.avail_in = remaining;
-	}
-      while (!(status == Z_STREAM_END && out_bytes == 0));
+  callback ((const char *) outbuf, out_bytes, opaque);
+  *out_total += out_bytes;
+  free (outbuf);
+  return LZ_HEADER_LENGTH + in_bytes;
+}
 
-      status = inflateEnd (&in_stream);
-      if (status != Z_OK)
-	internal_error ("compressed stream: %s", zError (status));
+/* Uncompress the LEN bytes of compressed IL at DATA and pass the
+   result to CALLBACK with OPAQUE.
+
+   Because of the way LTO IL streams are compressed, there may be several
+   concatenated compressed segments in DATA, so we iterate decompressions
+   until no data remains.  The codec of each segment is told by its first
+   byte, so the reader does not depend on -flto-compression.
+
+   This touches neither the timers nor lto_stats nor the diagnostic
+   machinery, so it may run on a thread other than the main one.  Store
+   the number of uncompressed bytes in *OUT_TOTAL and return NULL, or
+   return a description of the error if DATA is corrupt, in which case
+   CALLBACK may already have been passed part of the result.  */
+
+const char *
+lto_uncompress_buffer (const char *data, size_t len,
+		       void (*callback) (const char *, unsigned, void *),
+		       void *opaque, size_t *out_total)
+{
+  const unsigned char *cursor = (const unsigned char *) data;
+  size_t remaining = len;
+  const char *errmsg = NULL;
+
+  *out_total = 0;
+  while (remaining > 0)
+    {
+      size_t segment_bytes;
+
+      if (*cursor == LZ_MAGIC)
+	segment_bytes = lto_lz_uncompress (callback, opaque, cursor,
+					   remaining, out_total, &errmsg);
+      else
+	segment_bytes = lto_zlib_uncompress (callback, opaque, cursor,
+					     remaining, out_total, &errmsg);
+      if (segment_bytes == 0)
+	return errmsg;
+
+      cursor += segment_bytes;
+      remaining -= segment_bytes;
     }
 
+  return NULL;
+}
+
+/* Finalize STREAM uncompression, and free stream allocations.  */
+
+void
+lto_end_uncompression (struct lto_compression_stream *stream)
+{
+  const char *errmsg;
+  size_t out_total;
+
+  gcc_assert (!stream->is_compression);
+
+  timevar_push (TV_IPA_LTO_DECOMPRESS);
+  errmsg = lto_uncompress_buffer (stream->buffer, stream->bytes,
+				  stream->callback, stream->opaque, &out_total);
+  if (errmsg)
+    internal_error ("compressed stream: %s", errmsg);
+  lto_stats.num_uncompressed_il_bytes += out_total;
+  timevar_pop (TV_IPA_LTO_DECOMPRESS);
+
   lto_destroy_compression_stream (stream);
-  free (outbuf);
 }
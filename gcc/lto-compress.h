@@ -38,5 +38,9 @@ extern struct lto_compression_stream
 extern void lto_uncompress_block (struct lto_compression_stream *stream,
 				  const char *base, size_t num_chars);
 extern void lto_end_uncompression (struct lto_compression_stream *stream);
+extern const char *lto_uncompress_buffer (const char *data, size_t len,
+					  void (*callback) (const char *,
+							    unsigned, void *),
+					  void *opaque, size_t *out_total);
 
 #endif /* GCC_LTO_COMPRESS_H  */
@@ -165,8 +165,8 @@ lto_append_data (const char *chars, unsigned int num_chars, void *opaque)
 
 static struct lto_compression_stream *compression_stream = NULL;
 
-/* Begin a new output section named NAME. If COMPRESS is true, zlib compress
-   the section. */
+/* Begin a new output section named NAME. If COMPRESS is true, compress
+   the section with the codec chosen by -flto-compression. */
 
 void
 lto_begin_section (const char *name, bool compress)
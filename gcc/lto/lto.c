@@ -42,6 +42,9 @@ along with GCC; see the file COPYING3.  If not see
 #include "lto.h"
 #include "lto-tree.h"
 #include "lto-streamer.h"
+#include "lto-compress.h"
+#include "md5.h"
+#include "version.h"
 
 /* This needs to be included after config.h.  Otherwise, _GNU_SOURCE will not
    be defined in time to set __USE_GNU in the system headers, and strsignal
@@ -50,6 +53,10 @@ along with GCC; see the file COPYING3.  If not see
 #include <sys/mman.h>
 #endif
 
+#ifdef HAVE_LTO_PTHREAD
+#include <pthread.h>
+#endif
+
 /* Handle opening elf files on hosts, such as Windows, that may use 
    text file handling that will break binary access.  */
 
@@ -75,6 +82,22 @@ lto_materialize_constructors_and_inits (struct lto_file_decl_data * file_data)
 			 data, len);
 }
 
+/* Return true if FILE_DATA has a section of SECTION_TYPE with NAME,
+   without reading it.  */
+
+static bool
+lto_section_present_p (struct lto_file_decl_data *file_data,
+		       enum lto_section_type section_type, const char *name)
+{
+  struct lto_section_slot s_slot;
+  bool present;
+
+  s_slot.name = lto_get_section_name (section_type, name);
+  present = htab_find (file_data->section_hash_table, &s_slot) != NULL;
+  free (CONST_CAST (char *, s_slot.name));
+  return present;
+}
+
 /* Read the function body for the function associated with NODE if possible.  */
 
 static void
@@ -85,6 +108,7 @@ lto_materialize_function (struct cgraph_node *node)
   const char *data, *name;
   size_t len;
   tree step;
+  bool has_body;
 
   /* Ignore clone nodes.  Read the body only from the original one.
      We may find clone nodes during LTRANS after WPA has made inlining
@@ -99,9 +123,23 @@ lto_materialize_function (struct cgraph_node *node)
   /* We may have renamed the declaration, e.g., a static function.  */
   name = lto_get_decl_name_mapping (file_data, name);
 
-  data = lto_get_section_data (file_data, LTO_section_function_body,
-			       name, &len);
-  if (data)
+  /* In WPA mode, the body of the function is not needed: lto_output
+     copies its section to the partition without decoding it.  So only
+     look whether there is one, without reading the section.  */
+  if (flag_wpa)
+    {
+      data = NULL;
+      has_body = lto_section_present_p (file_data,
+					LTO_section_function_body, name);
+    }
+  else
+    {
+      data = lto_get_section_data (file_data, LTO_section_function_body,
+				   name, &len);
+      has_body = data != NULL;
+    }
+
+  if (has_body)
     {
       struct function *fn;
 
@@ -113,27 +151,25 @@ lto_materialize_function (struct cgraph_node *node)
       gcc_assert (DECL_STRUCT_FUNCTION (decl) == NULL);
       allocate_struct_function (decl, false);
 
-      /* Load the function body only if not operating in WPA mode.  In
-	 WPA mode, the body of the function is not needed.  */
-      if (!flag_wpa)
+      if (data)
 	{
 	  lto_input_function_body (file_data, decl, data);
 	  lto_stats.num_function_bodies++;
-	}
 
-      fn = DECL_STRUCT_FUNCTION (decl);
-      lto_free_section_data (file_data, LTO_section_function_body, name,
-			     data, len);
+	  fn = DECL_STRUCT_FUNCTION (decl);
+	  lto_free_section_data (file_data, LTO_section_function_body, name,
+				 data, len);
 
-      /* Look for initializers of constant variables and private
-	 statics.  */
-      for (step = fn->local_decls; step; step = TREE_CHAIN (step))
-	{
-	  tree decl = TREE_VALUE (step);
-	  if (TREE_CODE (decl) == VAR_DECL
-	      && (TREE_STATIC (decl) && !DECL_EXTERNAL (decl))
-	      && flag_unit_at_a_time)
-	    varpool_finalize_decl (decl);
+	  /* Look for initializers of constant variables and private
+	     statics.  */
+	  for (step = fn->local_decls; step; step = TREE_CHAIN (step))
+	    {
+	      tree decl = TREE_VALUE (step);
+	      if (TREE_CODE (decl) == VAR_DECL
+		  && (TREE_STATIC (decl) && !DECL_EXTERNAL (decl))
+		  && flag_unit_at_a_time)
+		varpool_finalize_decl (decl);
+	    }
 	}
     }
   else
@@ -170,7 +206,7 @@ lto_read_in_decl_state (struct data_in *data_in, const uint32_t *data,
   for (i = 0; i < LTO_N_DECL_STREAMS; i++)
     {
       uint32_t size = *data++;
-      tree *decls = (tree *) xcalloc (size, sizeof (tree));
+      tree *decls = GGC_NEWVEC (tree, size);
 
       for (j = 0; j < size; j++)
 	{
@@ -235,7 +271,7 @@ lto_read_decls (struct lto_file_decl_data *decl_data, const void *data,
 
   /* Read in per-function decl states and enter them in hash table.  */
   decl_data->function_decl_states =
-    htab_create (37, lto_hash_in_decl_state, lto_eq_in_decl_state, free);
+    htab_create_ggc (37, lto_hash_in_decl_state, lto_eq_in_decl_state, NULL);
 
   for (i = 1; i < num_decl_states; i++)
     {
@@ -359,32 +395,24 @@ lto_resolution_read (FILE *resolution, lto_file *file)
   return ret;
 }
 
-/* Generate a TREE representation for all types and external decls
-   entities in FILE.  
-
-   Read all of the globals out of the file.  Then read the cgraph
-   and process the .o index into the cgraph nodes so that it can open
-   the .o file to load the functions and ipa information.   */
+/* Open the sections of FILE for reading and return its
+   lto_file_decl_data.  Store the symbol resolutions of FILE read from
+   RESOLUTION_FILE in *RESOLUTIONS.  The global decls and types of the
+   file are read later by lto_read_decls.  */
 
 static struct lto_file_decl_data *
-lto_file_read (lto_file *file, FILE *resolution_file)
+lto_file_read (lto_file *file, FILE *resolution_file,
+	       VEC(ld_plugin_symbol_resolution_t,heap) **resolutions)
 {
   struct lto_file_decl_data *file_data;
-  const char *data;
-  size_t len;
-  VEC(ld_plugin_symbol_resolution_t,heap) *resolutions;
-  
-  resolutions = lto_resolution_read (resolution_file, file);
 
-  file_data = XCNEW (struct lto_file_decl_data);
+  *resolutions = lto_resolution_read (resolution_file, file);
+
+  file_data = GGC_CNEW (struct lto_file_decl_data);
   file_data->file_name = file->filename;
   file_data->section_hash_table = lto_obj_build_section_table (file);
   file_data->renaming_hash_table = lto_create_renaming_table ();
 
-  data = lto_get_section_data (file_data, LTO_section_decls, NULL, &len);
-  lto_read_decls (file_data, data, resolutions);
-  lto_free_section_data (file_data, LTO_section_decls, NULL, data, len);
-
   return file_data;
 }
 
@@ -521,6 +549,263 @@ free_section_data (struct lto_file_decl_data *file_data ATTRIBUTE_UNUSED,
 #endif
 }
 
+/* With -flto-read-threads=N, N helper threads read and uncompress the
+   decls sections of the input files ahead of their decoding.  Trees,
+   the garbage collector and the diagnostic machinery are used only on
+   the main thread, which still decodes and merges the files one at a
+   time in command-line order, so the result does not depend on N.  */
+
+#ifdef HAVE_LTO_PTHREAD
+struct lto_prefetch_slot
+{
+  /* The input file and the location of its raw decls section.  */
+  const char *file_name;
+  intptr_t offset;
+  size_t raw_len;
+
+  /* The uncompressed section, or NULL if it could not be read.  Valid
+     once DONE is set.  */
+  char *data;
+  size_t len;
+  bool done;
+};
+
+static struct lto_prefetch_slot *lto_prefetch_slots;
+static unsigned lto_prefetch_num_slots;
+
+/* The next slot for a helper thread to fill, the number of slots the
+   main thread has taken, and how far the helpers may run ahead of it.  */
+static unsigned lto_prefetch_next, lto_prefetch_taken, lto_prefetch_window;
+static bool lto_prefetch_stop;
+
+static pthread_mutex_t lto_prefetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t lto_prefetch_done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t lto_prefetch_space_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *lto_prefetch_threads;
+static unsigned lto_prefetch_num_threads;
+
+/* Append the LENGTH bytes at DATA to the lto_prefetch_slot OPAQUE.  */
+
+static void
+lto_prefetch_append (const char *data, unsigned length, void *opaque)
+{
+  struct lto_prefetch_slot *slot = (struct lto_prefetch_slot *) opaque;
+
+  slot->data = (char *) xrealloc (slot->data, slot->len + length);
+  memcpy (slot->data + slot->len, data, length);
+  slot->len += length;
+}
+
+/* Read and uncompress the decls section of SLOT.  This runs on a
+   helper thread, so it reports failure only by leaving SLOT->data
+   NULL; the main thread then reads the section itself.  */
+
+static void
+lto_prefetch_read (struct lto_prefetch_slot *slot)
+{
+  size_t done = 0;
+  char *raw;
+  int fd;
+
+  fd = open (slot->file_name, O_RDONLY|O_BINARY);
+  if (fd == -1)
+    return;
+
+  raw = XNEWVEC (char, slot->raw_len);
+  if (lseek (fd, slot->offset, SEEK_SET) == slot->offset)
+    while (done < slot->raw_len)
+      {
+	ssize_t n = read (fd, raw + done, slot->raw_len - done);
+	if (n <= 0)
+	  break;
+	done += n;
+      }
+  close (fd);
+
+  if (done < slot->raw_len)
+    free (raw);
+  /* FIXME lto: WPA mode does not write compressed sections, see
+     lto_get_section_data.  */
+  else if (flag_ltrans)
+    {
+      slot->data = raw;
+      slot->len = slot->raw_len;
+    }
+  else
+    {
+      size_t len;
+
+      /* A corrupt section is left to the main thread to report.  */
+      if (lto_uncompress_buffer (raw, slot->raw_len, lto_prefetch_append,
+				 slot, &len))
+	{
+	  free (slot->data);
+	  slot->data = NULL;
+	  slot->len = 0;
+	}
+      free (raw);
+    }
+}
+
+/* The body of the helper threads.  */
+
+static void *
+lto_prefetch_worker (void *arg ATTRIBUTE_UNUSED)
+{
+  pthread_mutex_lock (&lto_prefetch_lock);
+  for (;;)
+    {
+      struct lto_prefetch_slot *slot;
+
+      while (!lto_prefetch_stop
+	     && lto_prefetch_next < lto_prefetch_num_slots
+	     && lto_prefetch_next >= lto_prefetch_taken + lto_prefetch_window)
+	pthread_cond_wait (&lto_prefetch_space_cond, &lto_prefetch_lock);
+      if (lto_prefetch_stop || lto_prefetch_next >= lto_prefetch_num_slots)
+	break;
+
+      slot = &lto_prefetch_slots[lto_prefetch_next++];
+      pthread_mutex_unlock (&lto_prefetch_lock);
+      lto_prefetch_read (slot);
+      pthread_mutex_lock (&lto_prefetch_lock);
+
+      slot->done = true;
+      pthread_cond_broadcast (&lto_prefetch_done_cond);
+    }
+  pthread_mutex_unlock (&lto_prefetch_lock);
+  return NULL;
+}
+#endif
+
+/* Start reading the decls sections of the NFILES files in FILES on
+   helper threads, if -flto-read-threads asks for them.  */
+
+static void
+lto_prefetch_start (struct lto_file_decl_data **files ATTRIBUTE_UNUSED,
+		    unsigned nfiles ATTRIBUTE_UNUSED)
+{
+#ifdef HAVE_LTO_PTHREAD
+  const char *section_name;
+  unsigned i, nthreads;
+
+  if (lto_read_threads <= 1 || nfiles <= 1)
+    return;
+
+  section_name = lto_get_section_name (LTO_section_decls, NULL);
+  lto_prefetch_slots = XCNEWVEC (struct lto_prefetch_slot, nfiles);
+  for (i = 0; i < nfiles; i++)
+    {
+      struct lto_section_slot s_slot, *f_slot;
+
+      s_slot.name = section_name;
+      f_slot = (struct lto_section_slot *)
+	htab_find (files[i]->section_hash_table, &s_slot);
+      lto_prefetch_slots[i].file_name = files[i]->file_name;
+      if (f_slot)
+	{
+	  lto_prefetch_slots[i].offset = f_slot->start;
+	  lto_prefetch_slots[i].raw_len = f_slot->len;
+	}
+    }
+  free (CONST_CAST (char *, section_name));
+
+  nthreads = MIN ((unsigned) lto_read_threads, nfiles);
+  lto_prefetch_num_slots = nfiles;
+  lto_prefetch_next = 0;
+  lto_prefetch_taken = 0;
+  lto_prefetch_window = 2 * nthreads;
+  lto_prefetch_stop = false;
+
+  lto_prefetch_threads = XNEWVEC (pthread_t, nthreads);
+  for (lto_prefetch_num_threads = 0;
+       lto_prefetch_num_threads < nthreads;
+       lto_prefetch_num_threads++)
+    if (pthread_create (&lto_prefetch_threads[lto_prefetch_num_threads],
+			NULL, lto_prefetch_worker, NULL) != 0)
+      break;
+
+  /* Without any helper the main thread reads the sections itself.  */
+  if (lto_prefetch_num_threads == 0)
+    {
+      free (lto_prefetch_threads);
+      free (lto_prefetch_slots);
+      lto_prefetch_threads = NULL;
+      lto_prefetch_slots = NULL;
+      lto_prefetch_num_slots = 0;
+    }
+#endif
+}
+
+/* Return the uncompressed decls section of the INDEXth input file read
+   by the helper threads and store its length in *LEN, or return NULL
+   if there is none.  The caller must free the section.  */
+
+static char *
+lto_prefetch_get (unsigned index ATTRIBUTE_UNUSED,
+		  size_t *len ATTRIBUTE_UNUSED)
+{
+#ifdef HAVE_LTO_PTHREAD
+  struct lto_prefetch_slot *slot;
+
+  if (!lto_prefetch_slots)
+    return NULL;
+
+  slot = &lto_prefetch_slots[index];
+  pthread_mutex_lock (&lto_prefetch_lock);
+  while (!slot->done)
+    pthread_cond_wait (&lto_prefetch_done_cond, &lto_prefetch_lock);
+  lto_prefetch_taken = index + 1;
+  pthread_cond_broadcast (&lto_prefetch_space_cond);
+  pthread_mutex_unlock (&lto_prefetch_lock);
+
+  if (!slot->data)
+    return NULL;
+
+  lto_stats.section_size[LTO_section_decls] += slot->raw_len;
+  if (!flag_ltrans)
+    {
+      lto_stats.num_input_il_bytes += slot->raw_len;
+      lto_stats.num_uncompressed_il_bytes += slot->len;
+    }
+
+  *len = slot->len;
+  return slot->data;
+#else
+  return NULL;
+#endif
+}
+
+/* Stop the helper threads and release the sections nobody took.  */
+
+static void
+lto_prefetch_finish (void)
+{
+#ifdef HAVE_LTO_PTHREAD
+  unsigned i;
+
+  if (!lto_prefetch_slots)
+    return;
+
+  pthread_mutex_lock (&lto_prefetch_lock);
+  lto_prefetch_stop = true;
+  pthread_cond_broadcast (&lto_prefetch_space_cond);
+  pthread_mutex_unlock (&lto_prefetch_lock);
+
+  for (i = 0; i < lto_prefetch_num_threads; i++)
+    pthread_join (lto_prefetch_threads[i], NULL);
+
+  for (i = lto_prefetch_taken; i < lto_prefetch_num_slots; i++)
+    free (lto_prefetch_slots[i].data);
+
+  free (lto_prefetch_threads);
+  free (lto_prefetch_slots);
+  lto_prefetch_threads = NULL;
+  lto_prefetch_slots = NULL;
+  lto_prefetch_num_threads = 0;
+  lto_prefetch_num_slots = 0;
+#endif
+}
+
 /* Vector of all cgraph node sets. */
 static GTY (()) VEC(cgraph_node_set, gc) *lto_cgraph_node_sets;
 
@@ -1080,15 +1365,371 @@ lto_wpa_write_files (void)
 /* Template of LTRANS dumpbase suffix.  */
 #define DUMPBASE_SUFFIX	".ltrans18446744073709551615"
 
+/* The LTRANS drivers running concurrently, in LTO_LTRANS_NUM_SLOTS slots
+   reused in the order the drivers were started.  */
+static struct pex_obj **lto_ltrans_pex;
+static size_t lto_ltrans_num_slots;
+
+/* Wait for all the LTRANS drivers still running, so that none is left
+   behind when the link fails.  Their status does not matter any more.  */
+
+static void
+lto_reap_ltrans (void)
+{
+  size_t k;
+
+  for (k = 0; k < lto_ltrans_num_slots; k++)
+    if (lto_ltrans_pex[k])
+      {
+	pex_free (lto_ltrans_pex[k]);
+	lto_ltrans_pex[k] = NULL;
+      }
+}
+
+/* Wait for the LTRANS driver PROG in slot K of LTO_LTRANS_PEX to finish,
+   release it and empty the slot.  If it failed, reap the other drivers
+   before reporting the failure.  */
+
+static void
+lto_wait_ltrans (size_t k, const char *prog)
+{
+  struct pex_obj *pex = lto_ltrans_pex[k];
+  int status;
+
+  lto_ltrans_pex[k] = NULL;
+  if (!pex_get_status (pex, 1, &status))
+    {
+      int saved_errno = errno;
+
+      pex_free (pex);
+      lto_reap_ltrans ();
+      fatal_error ("can't get program status: %s", xstrerror (saved_errno));
+    }
+  pex_free (pex);
+
+  if (status)
+    {
+      lto_reap_ltrans ();
+      if (WIFSIGNALED (status))
+	{
+	  int sig = WTERMSIG (status);
+	  fatal_error ("%s terminated with signal %d [%s]%s",
+		       prog, sig, strsignal (sig),
+		       WCOREDUMP (status) ? ", core dumped" : "");
+	}
+      else
+	fatal_error ("%s terminated with status %d", prog, status);
+    }
+}
+
+/* The LTRANS cache of -flto-cache-dir= keeps the objects LTRANS
+   produced for earlier links, named after the MD5 sum of the partition
+   and of the options and compiler used to compile it.  The file "index"
+   in the cache directory lists the objects with their sizes, least
+   recently used first.  Links sharing the directory at the same time
+   may lose each other's updates of the index, which only means that
+   some objects are compiled again.  */
+
+struct lto_cache_entry
+{
+  char *key;
+  unsigned long size;
+};
+
+static struct lto_cache_entry *lto_cache_entries;
+static size_t lto_cache_num_entries, lto_cache_max_entries;
+static unsigned lto_cache_hits, lto_cache_misses, lto_cache_evictions;
+
+/* Return the name of the file KEY in the cache directory.  */
+
+static char *
+lto_cache_file_name (const char *key)
+{
+  return concat (lto_cache_dir, "/", key, NULL);
+}
+
+/* Return the index of the cache entry for KEY, or -1 if there is none.  */
+
+static int
+lto_cache_lookup (const char *key)
+{
+  size_t i;
+
+  for (i = 0; i < lto_cache_num_entries; i++)
+    if (strcmp (lto_cache_entries[i].key, key) == 0)
+      return i;
+  return -1;
+}
+
+/* Remove the cache entry with index I, returning its key.  */
+
+static char *
+lto_cache_remove (size_t i)
+{
+  char *key = lto_cache_entries[i].key;
+
+  memmove (&lto_cache_entries[i], &lto_cache_entries[i + 1],
+	   (lto_cache_num_entries - i - 1) * sizeof (struct lto_cache_entry));
+  lto_cache_num_entries--;
+  return key;
+}
+
+/* Add an entry for KEY, a file of SIZE bytes, as the most recently used
+   one.  Take over KEY.  */
+
+static void
+lto_cache_push (char *key, unsigned long size)
+{
+  if (lto_cache_num_entries == lto_cache_max_entries)
+    {
+      lto_cache_max_entries = lto_cache_max_entries * 2 + 16;
+      lto_cache_entries = XRESIZEVEC (struct lto_cache_entry,
+				      lto_cache_entries,
+				      lto_cache_max_entries);
+    }
+  lto_cache_entries[lto_cache_num_entries].key = key;
+  lto_cache_entries[lto_cache_num_entries].size = size;
+  lto_cache_num_entries++;
+}
+
+/* Read the index of the cache directory.  */
+
+static void
+lto_cache_read_index (void)
+{
+  char *name = lto_cache_file_name ("index");
+  FILE *f = fopen (name, "r");
+  char key[2 * 16 + 5];
+  unsigned long size;
+
+  if (f)
+    {
+      while (fscanf (f, "%36s %lu", key, &size) == 2)
+	if (lto_cache_lookup (key) < 0)
+	  lto_cache_push (xstrdup (key), size);
+      fclose (f);
+    }
+  free (name);
+}
+
+/* Return a name for a temporary file that will be renamed to NAME.  */
+
+static char *
+lto_cache_temp_name (const char *name)
+{
+  char suffix[32];
+
+  sprintf (suffix, ".tmp%ld", (long) getpid ());
+  return concat (name, suffix, NULL);
+}
+
+/* Copy the file FROM to TO, through a temporary file so that nobody
+   sees a partial TO.  Return false if that fails.  */
+
+static bool
+lto_cache_copy (const char *from, const char *to)
+{
+  char *tmp = lto_cache_temp_name (to);
+  FILE *in = fopen (from, "rb"), *out = NULL;
+  char buf[8192];
+  size_t len;
+  bool ok = false;
+
+  if (in)
+    out = fopen (tmp, "wb");
+  if (out)
+    {
+      ok = true;
+      while ((len = fread (buf, 1, sizeof (buf), in)) > 0)
+	if (fwrite (buf, 1, len, out) != len)
+	  ok = false;
+      if (ferror (in))
+	ok = false;
+      if (fclose (out) != 0)
+	ok = false;
+      if (ok && rename (tmp, to) != 0)
+	ok = false;
+      if (!ok)
+	unlink (tmp);
+    }
+  if (in)
+    fclose (in);
+  free (tmp);
+  return ok;
+}
+
+/* Return the cache key for compiling FILE with the LTRANS command line
+   ARGV, or NULL if FILE cannot be read.  The names of the files
+   involved change from link to link and are left out.  */
+
+static char *
+lto_cache_key (const char **argv, const char *file)
+{
+  struct md5_ctx ctx;
+  unsigned char digest[16];
+  char buf[8192], *key;
+  size_t len, i;
+  FILE *f;
+
+  md5_init_ctx (&ctx);
+  md5_process_bytes (version_string, strlen (version_string) + 1, &ctx);
+  for (i = 0; argv[i]; i++)
+    {
+      if (strcmp (argv[i], "-dumpbase") == 0
+	  || strcmp (argv[i], "-dumpdir") == 0
+	  || strcmp (argv[i], "-fresolution") == 0)
+	{
+	  if (argv[i + 1])
+	    i++;
+	  continue;
+	}
+      md5_process_bytes (argv[i], strlen (argv[i]) + 1, &ctx);
+    }
+
+  f = fopen (file, "rb");
+  if (f == NULL)
+    return NULL;
+  while ((len = fread (buf, 1, sizeof (buf), f)) > 0)
+    md5_process_bytes (buf, len, &ctx);
+  if (ferror (f))
+    {
+      fclose (f);
+      return NULL;
+    }
+  fclose (f);
+  md5_finish_ctx (&ctx, digest);
+
+  key = XNEWVEC (char, 2 * 16 + 3);
+  for (i = 0; i < 16; i++)
+    sprintf (key + 2 * i, "%02x", digest[i]);
+  strcpy (key + 2 * 16, ".o");
+  return key;
+}
+
+/* If the cache has an object for KEY, copy it to OUTPUT and return
+   true.  */
+
+static bool
+lto_cache_fetch (const char *key, const char *output)
+{
+  int i = lto_cache_lookup (key);
+  unsigned long size;
+  char *name;
+  bool ok;
+
+  if (i < 0)
+    return false;
+
+  name = lto_cache_file_name (key);
+  ok = lto_cache_copy (name, output);
+  free (name);
+
+  /* Make the entry the most recently used one, or forget it if the
+     file has gone.  */
+  size = lto_cache_entries[i].size;
+  name = lto_cache_remove (i);
+  if (ok)
+    lto_cache_push (name, size);
+  else
+    free (name);
+  return ok;
+}
+
+/* Store OUTPUT, which LTRANS produced, in the cache under KEY.  Take
+   over KEY.  */
+
+static void
+lto_cache_store (char *key, const char *output)
+{
+  char *name = lto_cache_file_name (key);
+  struct stat st;
+
+  if (stat (output, &st) == 0 && lto_cache_copy (output, name))
+    lto_cache_push (key, st.st_size);
+  else
+    {
+      warning (0, "cannot store %s in LTRANS cache %s", output,
+	       lto_cache_dir);
+      free (key);
+    }
+  free (name);
+}
+
+/* Remove the least recently used objects until the cache is no larger
+   than -flto-cache-size=, write the index and report what happened if
+   -flto-report.  */
+
+static void
+lto_cache_finish (void)
+{
+  unsigned HOST_WIDE_INT total = 0, limit;
+  char *name, *tmp;
+  FILE *f;
+  size_t i;
+
+  limit = (unsigned HOST_WIDE_INT) lto_cache_size * 1024;
+  for (i = 0; i < lto_cache_num_entries; i++)
+    total += lto_cache_entries[i].size;
+  while (total > limit && lto_cache_num_entries > 0)
+    {
+      char *key;
+
+      total -= lto_cache_entries[0].size;
+      key = lto_cache_remove (0);
+      name = lto_cache_file_name (key);
+      unlink (name);
+      free (name);
+      free (key);
+      lto_cache_evictions++;
+    }
+
+  name = lto_cache_file_name ("index");
+  tmp = lto_cache_temp_name (name);
+  f = fopen (tmp, "w");
+  if (f)
+    {
+      for (i = 0; i < lto_cache_num_entries; i++)
+	fprintf (f, "%s %lu\n", lto_cache_entries[i].key,
+		 lto_cache_entries[i].size);
+      if (fclose (f) != 0 || rename (tmp, name) != 0)
+	{
+	  warning (0, "cannot write LTRANS cache index %s: %m", name);
+	  unlink (tmp);
+	}
+    }
+  else
+    warning (0, "cannot write LTRANS cache index %s: %m", name);
+  free (tmp);
+  free (name);
+
+  if (flag_lto_report)
+    fprintf (stderr, "[WPA] LTRANS cache: %u hits, %u misses, "
+	     "%u evicted, " HOST_WIDE_INT_PRINT_UNSIGNED " bytes kept\n",
+	     lto_cache_hits, lto_cache_misses, lto_cache_evictions, total);
+
+  for (i = 0; i < lto_cache_num_entries; i++)
+    free (lto_cache_entries[i].key);
+  free (lto_cache_entries);
+  lto_cache_entries = NULL;
+  lto_cache_num_entries = lto_cache_max_entries = 0;
+}
+
 /* Perform local transformations (LTRANS) on the files in the NULL-terminated
    FILES array.  These should have been written previously by
    lto_wpa_write_files ().  Transformations are performed via executing
-   COLLECT_GCC for reach file.  */
+   COLLECT_GCC for reach file.  Up to -fltrans-jobs= of these run at the
+   same time; the output list is always written in the order of FILES
+   so the final link does not depend on which job finishes first.  With
+   -flto-cache-dir=, files compiled by an earlier link are not compiled
+   again.  */
 
 static void
 lto_execute_ltrans (char *const *files)
 {
   struct pex_obj *pex;
+  char **job_keys;
+  const char **job_outputs;
+  size_t nstarted, k;
   const char *collect_gcc_options, *collect_gcc;
   struct obstack env_obstack;
   const char **argv;
@@ -1096,7 +1737,6 @@ lto_execute_ltrans (char *const *files)
   const char *errmsg;
   size_t i, j;
   int err;
-  int status;
   FILE *ltrans_output_list_stream = NULL;
   bool seen_dumpbase = false;
   char *dumpbase_suffix = NULL;
@@ -1150,9 +1790,10 @@ lto_execute_ltrans (char *const *files)
 	    seen_dumpbase = false;
 	  }
 
-	/* LTRANS does not need -fwpa nor -fltrans-*.  */
+	/* LTRANS does not need -fwpa nor -fltrans-* nor -flto-cache-*.  */
 	if (strncmp (option, "-fwpa", 5) != 0
-	    && strncmp (option, "-fltrans-", 9) != 0)
+	    && strncmp (option, "-fltrans-", 9) != 0
+	    && strncmp (option, "-flto-cache-", 12) != 0)
 	  {
 	    if (strncmp (option, "-dumpbase", 9) == 0)
 	      seen_dumpbase = true;
@@ -1161,6 +1802,15 @@ lto_execute_ltrans (char *const *files)
       }
   *argv_ptr++ = "-fltrans";
 
+  lto_ltrans_num_slots = ltrans_jobs > 1 ? (size_t) ltrans_jobs : 1;
+  lto_ltrans_pex = XCNEWVEC (struct pex_obj *, lto_ltrans_num_slots);
+  job_keys = XCNEWVEC (char *, lto_ltrans_num_slots);
+  job_outputs = XCNEWVEC (const char *, lto_ltrans_num_slots);
+  nstarted = 0;
+
+  if (lto_cache_dir)
+    lto_cache_read_index ();
+
   /* Open the LTRANS output list.  */
   if (ltrans_output_list)
     {
@@ -1189,7 +1839,7 @@ lto_execute_ltrans (char *const *files)
 	}
       else
 	{
-	  char *output_name;
+	  char *output_name, *key = NULL;
 
 	  /* Otherwise, add FILES[I] to lto_execute_ltrans command line
 	     and add the resulting file to LTRANS output list.  */
@@ -1210,6 +1860,21 @@ lto_execute_ltrans (char *const *files)
 		       ltrans_output_list);
 	    }
 
+	  /* Reuse the object of an earlier link if the partition and the
+	     options are the same.  */
+	  if (lto_cache_dir)
+	    {
+	      *argv_ptr = NULL;
+	      key = lto_cache_key (argv, files[i]);
+	      if (key && lto_cache_fetch (key, output_name))
+		{
+		  lto_cache_hits++;
+		  free (key);
+		  continue;
+		}
+	      lto_cache_misses++;
+	    }
+
 	  argv_ptr[0] = "-o";
 	  argv_ptr[1] = output_name;
 	  argv_ptr[2] = files[i];
@@ -1220,35 +1885,60 @@ lto_execute_ltrans (char *const *files)
 	    snprintf (dumpbase_suffix, sizeof (DUMPBASE_SUFFIX) - 7,
 		      "%lu", (unsigned long) i);
 
-	  /* Execute the driver.  */
+	  /* If all slots are busy, wait for the oldest driver before
+	     starting another one.  */
+	  k = nstarted % lto_ltrans_num_slots;
+	  if (lto_ltrans_pex[k])
+	    {
+	      lto_wait_ltrans (k, argv[0]);
+	      if (job_keys[k])
+		lto_cache_store (job_keys[k], job_outputs[k]);
+	    }
+
+	  /* Execute the driver.  pex_run has forked by the time it
+	     returns, so ARGV may be reused for the next file.  */
 	  pex = pex_init (0, "lto1", NULL);
 	  if (pex == NULL)
-	    fatal_error ("pex_init failed: %s", xstrerror (errno));
+	    {
+	      err = errno;
+	      lto_reap_ltrans ();
+	      fatal_error ("pex_init failed: %s", xstrerror (err));
+	    }
 
 	  errmsg = pex_run (pex, PEX_LAST | PEX_SEARCH, argv[0],
 			    CONST_CAST (char **, argv), NULL, NULL, &err);
 	  if (errmsg)
-	    fatal_error ("%s: %s", errmsg, xstrerror (err));
-
-	  if (!pex_get_status (pex, 1, &status))
-	    fatal_error ("can't get program status: %s", xstrerror (errno));
-
-	  if (status)
 	    {
-	      if (WIFSIGNALED (status))
-		{
-		  int sig = WTERMSIG (status);
-		  fatal_error ("%s terminated with signal %d [%s]%s",
-			       argv[0], sig, strsignal (sig),
-			       WCOREDUMP (status) ? ", core dumped" : "");
-		}
-	      else
-		fatal_error ("%s terminated with status %d", argv[0], status);
+	      lto_reap_ltrans ();
+	      fatal_error ("%s: %s", errmsg, xstrerror (err));
 	    }
 
-	  pex_free (pex);
+	  lto_ltrans_pex[k] = pex;
+	  job_keys[k] = key;
+	  job_outputs[k] = output_name;
+	  nstarted++;
+	}
+    }
+
+  /* Wait for the drivers still running, oldest first.  */
+  for (i = 0; i < lto_ltrans_num_slots; i++)
+    {
+      k = (nstarted + i) % lto_ltrans_num_slots;
+      if (lto_ltrans_pex[k])
+	{
+	  lto_wait_ltrans (k, argv[0]);
+	  if (job_keys[k])
+	    lto_cache_store (job_keys[k], job_outputs[k]);
 	}
     }
+  free (lto_ltrans_pex);
+  lto_ltrans_pex = NULL;
+  lto_ltrans_num_slots = 0;
+  free (job_keys);
+  free (job_outputs);
+
+  if (lto_cache_dir)
+    lto_cache_finish ();
 
   /* Close the LTRANS output list.  */
   if (ltrans_output_list_stream && fclose (ltrans_output_list_stream))
@@ -1263,6 +1953,10 @@ lto_execute_ltrans (char *const *files)
 
 typedef struct {
   struct pointer_set_t *seen;
+
+  /* True if only types are to be replaced, because the prevailing
+     decls are not known yet.  */
+  bool types_only;
 } lto_fixup_data_t;
 
 #define LTO_FIXUP_SUBTREE(t) \
@@ -1574,7 +2268,8 @@ lto_fixup_tree (tree *tp, int *walk_subtrees, void *data)
   if (pointer_set_contains (fixup_data->seen, t))
     return NULL;
 
-  if (TREE_CODE (t) == VAR_DECL || TREE_CODE (t) == FUNCTION_DECL)
+  if ((TREE_CODE (t) == VAR_DECL || TREE_CODE (t) == FUNCTION_DECL)
+      && !fixup_data->types_only)
     {
       prevailing = lto_symtab_prevailing_decl (t);
 
@@ -1722,6 +2417,7 @@ lto_fixup_decls (struct lto_file_decl_data **files)
   lto_fixup_data_t data;
 
   data.seen = seen;
+  data.types_only = false;
   for (i = 0; files[i]; i++)
     {
       struct lto_file_decl_data *file = files[i];
@@ -1742,6 +2438,23 @@ lto_fixup_decls (struct lto_file_decl_data **files)
   pointer_set_destroy (seen);
 }
 
+/* Replace the types of FILE, which has just been read, with the
+   prevailing ones, so that its copies of the types of earlier files can
+   be collected before the next file is read.  The decls are replaced by
+   lto_fixup_decls once all the files have been read.  */
+
+static void
+lto_fixup_file_types (struct lto_file_decl_data *file)
+{
+  lto_fixup_data_t data;
+
+  data.seen = pointer_set_create ();
+  data.types_only = true;
+  lto_fixup_state (file->global_decl_state, &data);
+  htab_traverse (file->function_decl_states, lto_fixup_state_aux, &data);
+  pointer_set_destroy (data.seen);
+}
+
 /* Unlink a temporary LTRANS file unless requested otherwise.  */
 
 static void
@@ -1801,6 +2514,10 @@ lto_read_all_file_options (void)
 }
 
 
+/* The decl states of all the input files, terminated by NULL.  */
+static GTY((length ("lto_stats.num_input_files + 1")))
+  struct lto_file_decl_data **all_file_decl_data;
+
 /* Read all the symbols from the input files FNAMES.  NFILES is the
    number of files requested in the command line.  Instantiate a
    global call graph by aggregating all the sub-graphs found in each
@@ -1810,8 +2527,8 @@ static void
 read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
 {
   unsigned int i, last_file_ix;
-  struct lto_file_decl_data **all_file_decl_data;
   FILE *resolution;
+  VEC(ld_plugin_symbol_resolution_t,heap) **resolutions;
   struct cgraph_node *node;
 
   lto_stats.num_input_files = nfiles;
@@ -1819,7 +2536,7 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
   timevar_push (TV_IPA_LTO_DECL_IO);
 
   /* Set the hooks so that all of the ipa passes can read in their data.  */
-  all_file_decl_data = XNEWVEC (struct lto_file_decl_data *, nfiles + 1);
+  all_file_decl_data = GGC_CNEWVEC (struct lto_file_decl_data *, nfiles + 1);
   lto_set_in_hooks (all_file_decl_data, get_section_data, free_section_data);
 
   /* Read the resolution file.  */
@@ -1841,7 +2558,8 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
       gcc_assert (num_objects == nfiles);
     }
 
-  /* Read all of the object files specified on the command line.  */
+  /* Open all of the object files specified on the command line.  */
+  resolutions = XCNEWVEC (VEC(ld_plugin_symbol_resolution_t,heap) *, nfiles);
   for (i = 0, last_file_ix = 0; i < nfiles; ++i)
     {
       struct lto_file_decl_data *file_data = NULL;
@@ -1850,7 +2568,8 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
       if (!current_lto_file)
 	break;
 
-      file_data = lto_file_read (current_lto_file, resolution);
+      file_data = lto_file_read (current_lto_file, resolution,
+				 &resolutions[last_file_ix]);
       if (!file_data)
 	break;
 
@@ -1865,6 +2584,41 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
 
   all_file_decl_data[last_file_ix] = NULL;
 
+  /* Read the global decls and types of each file.  */
+  lto_prefetch_start (all_file_decl_data, last_file_ix);
+  for (i = 0; i < last_file_ix; i++)
+    {
+      struct lto_file_decl_data *file_data = all_file_decl_data[i];
+      char *data;
+      size_t len;
+
+      data = lto_prefetch_get (i, &len);
+      if (data)
+	{
+	  lto_read_decls (file_data, data, resolutions[i]);
+	  free (data);
+	}
+      else
+	{
+	  const char *section;
+
+	  section = lto_get_section_data (file_data, LTO_section_decls,
+					  NULL, &len);
+	  lto_read_decls (file_data, section, resolutions[i]);
+	  lto_free_section_data (file_data, LTO_section_decls, NULL,
+				 section, len);
+	}
+
+      /* Keep only one copy of the types shared by the files.  */
+      if (nfiles > 1)
+	{
+	  lto_fixup_file_types (file_data);
+	  ggc_collect ();
+	}
+    }
+  lto_prefetch_finish ();
+  free (resolutions);
+
   /* Set the hooks so that all of the ipa passes can read in their data.  */
   lto_set_in_hooks (all_file_decl_data, get_section_data, free_section_data);
 
@@ -1881,6 +2635,11 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
   lto_fixup_decls (all_file_decl_data);
   free_gimple_type_tables ();
 
+  /* The decls and types that lost against their counterparts in other
+     files are now unreachable.  Release them before the summaries are
+     read, since WPA keeps everything else until it exits.  */
+  ggc_collect ();
+
   /* Read the IPA summary data.  */
   ipa_read_summaries ();
 
@@ -2678,12 +2678,17 @@ lower_reduction_clauses (tree clauses, gimple_seq *stmt_seqp, omp_context *ctx)
 	}
     }
 
-  stmt = gimple_build_call (built_in_decls[BUILT_IN_GOMP_ATOMIC_START], 0);
+  /* The list items can't be accessed by other atomic updates until the
+     construct is done, so the merges of all threads only need to exclude
+     each other and any one of the atomic locks will do.  */
+  stmt = gimple_build_call (built_in_decls[BUILT_IN_GOMP_ATOMIC_ADDR_START],
+			    1, null_pointer_node);
   gimple_seq_add_stmt (stmt_seqp, stmt);
 
   gimple_seq_add_seq (stmt_seqp, sub_seq);
 
-  stmt = gimple_build_call (built_in_decls[BUILT_IN_GOMP_ATOMIC_END], 0);
+  stmt = gimple_build_call (built_in_decls[BUILT_IN_GOMP_ATOMIC_ADDR_END],
+			    1, null_pointer_node);
   gimple_seq_add_stmt (stmt_seqp, stmt);
 }
 
@@ -5189,15 +5194,16 @@ expand_omp_atomic_pipeline (basic_block load_bb, basic_block store_bb,
 
 /* A subroutine of expand_omp_atomic.  Implement the atomic operation as:
 
-		 		  GOMP_atomic_start ();
+		 		  GOMP_atomic_addr_start (addr);
 		 		  *addr = rhs;
-		 		  GOMP_atomic_end ();
+		 		  GOMP_atomic_addr_end (addr);
 
    The result is not globally atomic, but works so long as all parallel
    references are within #pragma omp atomic directives.  According to
    responses received from omp@openmp.org, appears to be within spec.
    Which makes sense, since that's how several other compilers handle
-   this situation as well.
+   this situation as well.  Passing ADDR lets libgomp pick one of several
+   locks by address, so unrelated atomic updates don't contend on one lock.
    LOADED_VAL and ADDR are the operands of GIMPLE_OMP_ATOMIC_LOAD we're
    expanding.  STORED_VAL is the operand of the matching
    GIMPLE_OMP_ATOMIC_STORE.
@@ -5222,8 +5228,9 @@ expand_omp_atomic_mutex (basic_block load_bb, basic_block store_bb,
   si = gsi_last_bb (load_bb);
   gcc_assert (gimple_code (gsi_stmt (si)) == GIMPLE_OMP_ATOMIC_LOAD);
 
-  t = built_in_decls[BUILT_IN_GOMP_ATOMIC_START];
-  t = build_function_call_expr (UNKNOWN_LOCATION, t, 0);
+  t = built_in_decls[BUILT_IN_GOMP_ATOMIC_ADDR_START];
+  t = build_call_expr (t, 1,
+		       fold_convert (ptr_type_node, unshare_expr (addr)));
   force_gimple_operand_gsi (&si, t, true, NULL_TREE, true, GSI_SAME_STMT);
 
   stmt = gimple_build_assign (loaded_val, build_fold_indirect_ref (addr));
@@ -5237,8 +5244,9 @@ expand_omp_atomic_mutex (basic_block load_bb, basic_block store_bb,
 				stored_val);
   gsi_insert_before (&si, stmt, GSI_SAME_STMT);
 
-  t = built_in_decls[BUILT_IN_GOMP_ATOMIC_END];
-  t = build_function_call_expr (UNKNOWN_LOCATION, t, 0);
+  t = built_in_decls[BUILT_IN_GOMP_ATOMIC_ADDR_END];
+  t = build_call_expr (t, 1,
+		       fold_convert (ptr_type_node, unshare_expr (addr)));
   force_gimple_operand_gsi (&si, t, true, NULL_TREE, true, GSI_SAME_STMT);
   gsi_remove (&si, true);
 
@@ -2039,6 +2039,15 @@ common_handle_option (size_t scode, const char *arg, int value,
 	warning (0, "unknown ira algorithm \"%s\"", arg);
       break;
 
+    case OPT_flto_compression_:
+      if (!strcmp (arg, "zlib"))
+	flag_lto_compression = LTO_COMPRESSION_ZLIB;
+      else if (!strcmp (arg, "lz"))
+	flag_lto_compression = LTO_COMPRESSION_LZ;
+      else
+	warning (0, "unknown LTO compression codec \"%s\"", arg);
+      break;
+
     case OPT_fira_region_:
       if (!strcmp (arg, "one"))
 	flag_ira_region = IRA_REGION_ONE;
@@ -2050,6 +2059,13 @@ common_handle_option (size_t scode, const char *arg, int value,
 	warning (0, "unknown ira region \"%s\"", arg);
       break;
 
+    case OPT_fpass_stats_:
+      if (!strcmp (arg, "json"))
+	flag_pass_stats = PASS_STATS_JSON;
+      else
+	warning (0, "unknown pass statistics format \"%s\"", arg);
+      break;
+
     case OPT_fira_verbose_:
       flag_ira_verbose = value;
       break;
@@ -163,6 +163,8 @@ typedef enum compiler_param
   PARAM_VALUE (PARAM_IRA_MAX_LOOPS_NUM)
 #define IRA_MAX_CONFLICT_TABLE_SIZE \
   PARAM_VALUE (PARAM_IRA_MAX_CONFLICT_TABLE_SIZE)
+#define IRA_MAX_REGIONAL_PSEUDOS \
+  PARAM_VALUE (PARAM_IRA_MAX_REGIONAL_PSEUDOS)
 #define IRA_LOOP_RESERVED_REGS \
   PARAM_VALUE (PARAM_IRA_LOOP_RESERVED_REGS)
 #define SWITCH_CONVERSION_BRANCH_RATIO \
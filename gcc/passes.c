@@ -86,6 +86,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "predict.h"
 #include "lto-streamer.h"
 #include "plugin.h"
+#include "alloc-pool.h"
 
 #if defined (DWARF2_UNWIND_INFO) || defined (DWARF2_DEBUGGING_INFO)
 #include "dwarf2out.h"
@@ -109,6 +110,8 @@ along with GCC; see the file COPYING3.  If not see
    The variable current_pass is also used for statistics and plugins.  */
 struct opt_pass *current_pass;
 
+static void pass_stats_finish (void);
+
 /* Call from anywhere to find out what pass this is.  Useful for
    printing out debugging information deep inside an service
    routine.  */
@@ -276,6 +279,8 @@ finish_optimization_passes (void)
 	  free (name);
 	}
 
+  pass_stats_finish ();
+
   timevar_pop (TV_DUMP);
 }
 
@@ -1505,6 +1510,197 @@ execute_all_ipa_transforms (void)
     }
 }
 
+/* Statistics about one execution of a pass, for -fpass-stats.  */
+
+struct pass_stats
+{
+  /* Times and GC allocation when the pass started.  */
+  struct timevar_time_def start;
+
+  /* Largest GC heap size seen during the pass.  */
+  size_t heap_peak;
+
+  /* Blocks the pools had got from malloc and given back to free.  */
+  unsigned long pool_mallocs, pool_frees;
+
+  /* Size of the IR of the current function before the pass.  */
+  int stmts, insns, bbs;
+};
+
+/* The file -fpass-stats writes to, once opened.  */
+static FILE *pass_stats_file;
+
+/* Number of records written to PASS_STATS_FILE.  */
+static int pass_stats_count;
+
+/* Callback for walk_gimple_seq, counting statements in WI->info.  */
+
+static tree
+pass_stats_count_stmt (gimple_stmt_iterator *gsi ATTRIBUTE_UNUSED,
+		       bool *handled_ops_p ATTRIBUTE_UNUSED,
+		       struct walk_stmt_info *wi)
+{
+  (*(int *) wi->info)++;
+  return NULL_TREE;
+}
+
+/* Compute the size of the IR of the current function, if any, into
+   STMTS, INSNS and BBS.  */
+
+static void
+pass_stats_ir_size (int *stmts, int *insns, int *bbs)
+{
+  *stmts = *insns = *bbs = 0;
+  if (!cfun)
+    return;
+
+  if (cfun->curr_properties & PROP_cfg)
+    *bbs = n_basic_blocks - NUM_FIXED_BLOCKS;
+
+  if (cfun->curr_properties & PROP_rtl)
+    {
+      rtx insn;
+
+      for (insn = get_insns (); insn; insn = NEXT_INSN (insn))
+	if (INSN_P (insn))
+	  (*insns)++;
+    }
+  else if ((cfun->curr_properties & PROP_cfg) && cfun->cfg)
+    {
+      basic_block bb;
+      gimple_stmt_iterator gsi;
+
+      FOR_EACH_BB (bb)
+	for (gsi = gsi_start_bb (bb); !gsi_end_p (gsi); gsi_next (&gsi))
+	  (*stmts)++;
+    }
+  else if (current_function_decl
+	   && gimple_body (current_function_decl))
+    {
+      struct walk_stmt_info wi;
+
+      memset (&wi, 0, sizeof (wi));
+      wi.info = stmts;
+      walk_gimple_seq (gimple_body (current_function_decl),
+		       pass_stats_count_stmt, NULL, &wi);
+    }
+}
+
+/* Write S to F as a JSON string.  */
+
+static void
+pass_stats_print_string (FILE *f, const char *s)
+{
+  putc ('"', f);
+  for (; *s; s++)
+    if (*s == '"' || *s == '\\')
+      fprintf (f, "\\%c", *s);
+    else if ((unsigned char) *s < ' ')
+      fprintf (f, "\\u%04x", (unsigned char) *s);
+    else
+      putc (*s, f);
+  putc ('"', f);
+}
+
+/* Start recording STATS for the pass about to be executed.  */
+
+static void
+pass_stats_begin (struct pass_stats *stats)
+{
+  pass_stats_ir_size (&stats->stmts, &stats->insns, &stats->bbs);
+  stats->heap_peak = ggc_heap_allocated ();
+  stats->pool_mallocs = alloc_pool_block_mallocs;
+  stats->pool_frees = alloc_pool_block_frees;
+  timevar_get_time (&stats->start);
+}
+
+/* Note the GC heap size in STATS.  The heap only shrinks when it is
+   collected, which happens between passes, so sampling it when the
+   pass proper is done finds its peak.  */
+
+static void
+pass_stats_sample_heap (struct pass_stats *stats)
+{
+  size_t heap = ggc_heap_allocated ();
+
+  if (heap > stats->heap_peak)
+    stats->heap_peak = heap;
+}
+
+/* Finish recording STATS for PASS and write them out.  */
+
+static void
+pass_stats_end (struct opt_pass *pass, struct pass_stats *stats)
+{
+  struct timevar_time_def now;
+  int stmts, insns, bbs;
+  FILE *f;
+
+  timevar_get_time (&now);
+  pass_stats_sample_heap (stats);
+  pass_stats_ir_size (&stmts, &insns, &bbs);
+
+  if (!pass_stats_file)
+    {
+      char *name = concat (aux_base_name, ".pass-stats.json", NULL);
+
+      pass_stats_file = fopen (name, "w");
+      if (!pass_stats_file)
+	{
+	  error ("could not open pass statistics file %qs: %m", name);
+	  flag_pass_stats = PASS_STATS_NONE;
+	  free (name);
+	  return;
+	}
+      free (name);
+      fputs ("{\"file\": ", pass_stats_file);
+      pass_stats_print_string (pass_stats_file, main_input_filename);
+      fputs (",\n \"passes\": [", pass_stats_file);
+    }
+
+  f = pass_stats_file;
+  fputs (pass_stats_count++ ? ",\n  {" : "\n  {", f);
+  fputs ("\"pass\": ", f);
+  pass_stats_print_string (f, pass->name ? pass->name : "");
+  /* Only passes with a dump file have a unique number; the others
+     have -1 or a count of their duplicates.  */
+  if (pass->name && pass->name[0] != '*' && pass->static_pass_number > 0)
+    fprintf (f, ", \"id\": %d", pass->static_pass_number);
+  else
+    fputs (", \"id\": null", f);
+  fputs (", \"function\": ", f);
+  if (cfun)
+    pass_stats_print_string (f, current_function_name ());
+  else
+    fputs ("null", f);
+  fprintf (f, ", \"wall\": %.3f, \"user\": %.3f, \"sys\": %.3f",
+	   now.wall - stats->start.wall, now.user - stats->start.user,
+	   now.sys - stats->start.sys);
+  fprintf (f, ", \"ggc_allocated\": %lu, \"ggc_heap_peak\": %lu",
+	   (unsigned long) (now.ggc_mem - stats->start.ggc_mem),
+	   (unsigned long) stats->heap_peak);
+  fprintf (f, ", \"pool_mallocs\": %lu, \"pool_frees\": %lu",
+	   alloc_pool_block_mallocs - stats->pool_mallocs,
+	   alloc_pool_block_frees - stats->pool_frees);
+  fprintf (f, ",\n   \"before\": {\"stmts\": %d, \"insns\": %d, "
+	   "\"bbs\": %d}", stats->stmts, stats->insns, stats->bbs);
+  fprintf (f, ", \"after\": {\"stmts\": %d, \"insns\": %d, "
+	   "\"bbs\": %d}}", stmts, insns, bbs);
+}
+
+/* Finish the file -fpass-stats writes to.  */
+
+static void
+pass_stats_finish (void)
+{
+  if (!pass_stats_file)
+    return;
+  fputs ("\n ]}\n", pass_stats_file);
+  if (ferror (pass_stats_file) || fclose (pass_stats_file) != 0)
+    error ("error writing pass statistics file: %m");
+  pass_stats_file = NULL;
+}
+
 /* Execute PASS. */
 
 bool
@@ -1512,6 +1708,8 @@ execute_one_pass (struct opt_pass *pass)
 {
   bool initializing_dump;
   unsigned int todo_after = 0;
+  struct pass_stats stats;
+  void *arena_mark;
 
   bool gate_status;
 
@@ -1550,6 +1748,9 @@ execute_one_pass (struct opt_pass *pass)
 
   initializing_dump = pass_init_dump_file (pass);
 
+  if (flag_pass_stats != PASS_STATS_NONE)
+    pass_stats_begin (&stats);
+
   /* Run pre-pass verification.  */
   execute_todo (pass->todo_flags_start);
 
@@ -1565,7 +1766,9 @@ execute_one_pass (struct opt_pass *pass)
   /* Do it!  */
   if (pass->execute)
     {
+      arena_mark = pass_arena_mark ();
       todo_after = pass->execute ();
+      pass_arena_release (arena_mark);
       do_per_function (clear_last_verified, NULL);
     }
 
@@ -1573,6 +1776,9 @@ execute_one_pass (struct opt_pass *pass)
   if (pass->tv_id != TV_NONE)
     timevar_pop (pass->tv_id);
 
+  if (flag_pass_stats != PASS_STATS_NONE)
+    pass_stats_sample_heap (&stats);
+
   do_per_function (update_properties_after_pass, pass);
 
   if (initializing_dump
@@ -1602,6 +1808,9 @@ execute_one_pass (struct opt_pass *pass)
   if (!current_function_decl)
     cgraph_process_new_functions ();
 
+  if (flag_pass_stats != PASS_STATS_NONE)
+    pass_stats_end (pass, &stats);
+
   pass_fini_dump_file (pass);
 
   if (pass->type != SIMPLE_IPA_PASS && pass->type != IPA_PASS)
@@ -0,0 +1,28 @@
+/* Collect at every opportunity with the heap carved out of GC arenas,
+   so that discarded arena pages get reused.  */
+/* { dg-do compile } */
+/* { dg-options "-O2 --param ggc-arena-size=2048 --param ggc-min-expand=0 --param ggc-min-heapsize=0" } */
+
+struct node { struct node *next; int key; double val; };
+
+static double
+sum (struct node *n)
+{
+  double s = 0;
+  for (; n; n = n->next)
+    s += n->key * n->val;
+  return s;
+}
+
+double
+walk (struct node **tab, int n)
+{
+  double s = 0;
+  int i;
+  for (i = 0; i < n; i++)
+    if (tab[i] && tab[i]->key > 0)
+      s += sum (tab[i]);
+    else if (tab[i])
+      s -= sum (tab[i]->next);
+  return s;
+}
@@ -0,0 +1,31 @@
+/* Functions with more pseudos than --param ira-max-regional-pseudos are
+   allocated in one region even though there are loops.  */
+/* { dg-do compile } */
+/* { dg-options "-O2 -fira-region=mixed -fdump-rtl-ira --param ira-max-regional-pseudos=4" } */
+
+extern int in (int);
+extern void out (int);
+
+int
+machine (int state, int steps)
+{
+  int a, b, c, d, e;
+
+  while (steps-- > 0)
+    {
+      a = in (state);
+      b = in (a);
+      c = in (b);
+      d = in (c);
+      e = in (d);
+      while (a-- > 0)
+	out (a + b);
+      out (b + c);
+      out (d + e);
+      state = in (e + a);
+    }
+  return state;
+}
+
+/* { dg-final { scan-rtl-dump "Too many pseudos" "ira" } } */
+/* { dg-final { cleanup-rtl-dump "ira" } } */
@@ -0,0 +1,25 @@
+/* { dg-lto-do run } */
+/* { dg-lto-options {{-O2 -flto -flto-compression=lz} {-O2 -fwhopr -flto-compression=lz} {-O2 -flto -flto-compression=lz -flto-compression-level=0}} } */
+
+/* The IL of this file is compressed with the LZ codec, that of the
+   other file with zlib.  */
+
+extern void abort (void);
+
+struct point { int x, y, z; };
+
+extern int sum_points (const struct point *, int);
+
+static const struct point points[] =
+{
+  { 1, 2, 3 }, { 4, 5, 6 }, { 7, 8, 9 }, { 1, 2, 3 },
+  { 4, 5, 6 }, { 7, 8, 9 }, { 1, 2, 3 }, { 4, 5, 6 }
+};
+
+int
+main (void)
+{
+  if (sum_points (points, sizeof (points) / sizeof (points[0])) != 111)
+    abort ();
+  return 0;
+}
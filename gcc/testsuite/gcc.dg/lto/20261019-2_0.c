@@ -0,0 +1,30 @@
+/* { dg-lto-do run } */
+/* { dg-lto-options {{-O2 -flto -flto-compression=lz} {-O2 -fwhopr -flto-compression=lz}} } */
+/* { dg-extra-ld-options {-flto-read-threads=2} } */
+
+/* The decls sections of the three files are read and uncompressed on
+   two helper threads; the file with the LZ codec and the two with zlib
+   must still be merged as if they were read in order.  */
+
+extern void abort (void);
+
+struct point { int x, y, z; };
+
+extern int sum_points (const struct point *, int);
+extern int max_point (const struct point *, int);
+
+static const struct point points[] =
+{
+  { 1, 2, 3 }, { 4, 5, 6 }, { 7, 8, 9 }, { 1, 2, 3 },
+  { 4, 5, 6 }, { 7, 8, 9 }, { 1, 2, 3 }, { 4, 5, 6 }
+};
+
+int
+main (void)
+{
+  if (sum_points (points, sizeof (points) / sizeof (points[0])) != 111)
+    abort ();
+  if (max_point (points, sizeof (points) / sizeof (points[0])) != 24)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,13 @@
+/* { dg-options "-flto-compression=zlib" } */
+
+struct point { int x, y, z; };
+
+int
+sum_points (const struct point *p, int n)
+{
+  int i, sum = 0;
+
+  for (i = 0; i < n; i++)
+    sum += p[i].x + p[i].y + p[i].z;
+  return sum;
+}
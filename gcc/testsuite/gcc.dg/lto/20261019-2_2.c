@@ -0,0 +1,14 @@
+/* { dg-options "-flto-compression=zlib" } */
+
+struct point { int x, y, z; };
+
+int
+max_point (const struct point *p, int n)
+{
+  int i, max = 0;
+
+  for (i = 0; i < n; i++)
+    if (p[i].x + p[i].y + p[i].z > max)
+      max = p[i].x + p[i].y + p[i].z;
+  return max;
+}
@@ -0,0 +1,23 @@
+/* { dg-lto-do run } */
+/* { dg-lto-options {{-O2 -fwhopr}} } */
+/* { dg-extra-ld-options {-fltrans-jobs=2} } */
+
+/* WPA writes one partition for each of the three files and runs their
+   LTRANS compilations two at a time.  */
+
+extern void abort (void);
+
+extern int square (int);
+extern int cube (int);
+
+int
+main (void)
+{
+  int i, sum = 0;
+
+  for (i = 1; i <= 4; i++)
+    sum += square (i) + cube (i);
+  if (sum != 130)
+    abort ();
+  return 0;
+}
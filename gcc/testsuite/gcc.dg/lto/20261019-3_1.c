@@ -0,0 +1,5 @@
+int
+square (int x)
+{
+  return x * x;
+}
@@ -0,0 +1,7 @@
+extern int square (int);
+
+int
+cube (int x)
+{
+  return square (x) * x;
+}
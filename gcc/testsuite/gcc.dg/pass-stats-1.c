@@ -0,0 +1,17 @@
+/* { dg-do compile } */
+/* { dg-options "-O2 -fpass-stats=json" } */
+
+int
+f (int *p, int n)
+{
+  int i, s = 0;
+
+  for (i = 0; i < n; i++)
+    s += p[i];
+  return s;
+}
+
+/* { dg-final { scan-file pass-stats-1.pass-stats.json "\"passes\": \\\[" } } */
+/* { dg-final { scan-file pass-stats-1.pass-stats.json "\"pass\": \"expand\", \"id\": \[0-9\]+, \"function\": \"f\"" } } */
+/* { dg-final { scan-file pass-stats-1.pass-stats.json "\"after\": \{\"stmts\": 0, \"insns\": \[1-9\]\[0-9\]*, \"bbs\": \[1-9\]" } } */
+/* { dg-final { remove-build-file "pass-stats-1.pass-stats.json" } } */
@@ -0,0 +1,19 @@
+/* cselib lookups of a value must keep promoting the matching debug
+   locations, or var-tracking loses the location of SAVE after the
+   stack pointer is restored from the frame pointer.  */
+/* { dg-do compile { target or32-*-* } } */
+/* { dg-options "-O2 -g -fdump-rtl-vartrack" } */
+
+extern void *f (char *);
+
+void *
+g (void)
+{
+  char *save = (char *) __builtin_alloca (4);
+
+  return f (save);
+}
+
+/* { dg-final { scan-rtl-dump-times "var_location save" 4 "vartrack" } } */
+/* { dg-final { scan-rtl-dump "var_location save \\(plus:SI \\(reg/f:SI 2 r2\\)" "vartrack" } } */
+/* { dg-final { cleanup-rtl-dump "vartrack" } } */
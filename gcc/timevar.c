@@ -187,14 +187,37 @@ static void timevar_accumulate (struct timevar_time_def *,
 
 static void
 get_time (struct timevar_time_def *now)
+{
+  if (timevar_enable)
+    timevar_get_time (now);
+  else
+    {
+      now->user = 0;
+      now->sys  = 0;
+      now->wall = 0;
+      now->ggc_mem = timevar_ggc_mem_total;
+    }
+}
+
+/* Like get_time, but also when timing variables are not enabled,
+   for -fpass-stats.  */
+
+void
+timevar_get_time (struct timevar_time_def *now)
 {
   now->user = 0;
   now->sys  = 0;
   now->wall = 0;
   now->ggc_mem = timevar_ggc_mem_total;
 
-  if (!timevar_enable)
-    return;
+#ifdef USE_TIMES
+  if (ticks_to_msec == 0)
+    ticks_to_msec = TICKS_TO_MSEC;
+#endif
+#ifdef USE_CLOCK
+  if (clocks_to_msec == 0)
+    clocks_to_msec = CLOCKS_TO_MSEC;
+#endif
 
   {
 #ifdef USE_TIMES
@@ -91,6 +91,7 @@ extern void timevar_pop_1 (timevar_id_t);
 extern void timevar_start (timevar_id_t);
 extern void timevar_stop (timevar_id_t);
 extern void timevar_print (FILE *);
+extern void timevar_get_time (struct timevar_time_def *);
 
 /* Provided for backward compatibility.  */
 extern void print_time (const char *, long);
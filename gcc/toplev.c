@@ -294,6 +294,14 @@ enum tls_model flag_tls_default = TLS_MODEL_GLOBAL_DYNAMIC;
 enum ira_algorithm flag_ira_algorithm = IRA_ALGORITHM_CB;
 enum ira_region flag_ira_region = IRA_REGION_MIXED;
 
+/* Set the default codec for LTO IL, as selected by -flto-compression=.  */
+
+enum lto_compression flag_lto_compression = LTO_COMPRESSION_ZLIB;
+
+/* Set the format of -fpass-stats, if given.  */
+
+enum pass_stats_format flag_pass_stats = PASS_STATS_NONE;
+
 /* Set the default value for -fira-verbose.  */
 
 unsigned int flag_ira_verbose = 5;
@@ -233,9 +233,6 @@ typedef struct access *access_p;
 DEF_VEC_P (access_p);
 DEF_VEC_ALLOC_P (access_p, heap);
 
-/* Alloc pool for allocating access structures.  */
-static alloc_pool access_pool;
-
 /* A structure linking lhs and rhs accesses from an aggregate assignment.  They
    are used to propagate subaccesses from rhs to lhs as long as they don't
    conflict with what is already there.  */
@@ -245,9 +242,6 @@ struct assign_link
   struct assign_link *next;
 };
 
-/* Alloc pool for allocating assign link structures.  */
-static alloc_pool link_pool;
-
 /* Base (tree) -> Vector (VEC(access_p,heap) *) map.  */
 static struct pointer_map_t *base_access_vec;
 
@@ -567,8 +561,6 @@ sra_initialize (void)
   should_scalarize_away_bitmap = BITMAP_ALLOC (NULL);
   cannot_scalarize_away_bitmap = BITMAP_ALLOC (NULL);
   gcc_obstack_init (&name_obstack);
-  access_pool = create_alloc_pool ("SRA accesses", sizeof (struct access), 16);
-  link_pool = create_alloc_pool ("SRA links", sizeof (struct assign_link), 16);
   base_access_vec = pointer_map_create ();
   memset (&sra_stats, 0, sizeof (sra_stats));
   encountered_apply_args = false;
@@ -597,8 +589,6 @@ sra_deinitialize (void)
   BITMAP_FREE (candidate_bitmap);
   BITMAP_FREE (should_scalarize_away_bitmap);
   BITMAP_FREE (cannot_scalarize_away_bitmap);
-  free_alloc_pool (access_pool);
-  free_alloc_pool (link_pool);
   obstack_free (&name_obstack, NULL);
 
   pointer_map_traverse (base_access_vec, delete_base_accesses, NULL);
@@ -718,7 +708,7 @@ create_access_1 (tree base, HOST_WIDE_INT offset, HOST_WIDE_INT size)
   struct access *access;
   void **slot;
 
-  access = (struct access *) pool_alloc (access_pool);
+  access = (struct access *) pass_arena_alloc (sizeof (struct access));
   memset (access, 0, sizeof (struct access));
   access->base = base;
   access->offset = offset;
@@ -1056,7 +1046,8 @@ build_accesses_from_assign (gimple *stmt_ptr,
     {
       struct assign_link *link;
 
-      link = (struct assign_link *) pool_alloc (link_pool);
+      link = (struct assign_link *)
+	pass_arena_alloc (sizeof (struct assign_link));
       memset (link, 0, sizeof (struct assign_link));
 
       link->lacc = lacc;
@@ -1945,7 +1936,7 @@ create_artificial_child_access (struct access *parent, struct access *model,
 			     model->type, false))
     return NULL;
 
-  access = (struct access *) pool_alloc (access_pool);
+  access = (struct access *) pass_arena_alloc (sizeof (struct access));
   memset (access, 0, sizeof (struct access));
   access->base = parent->base;
   access->expr = expr;
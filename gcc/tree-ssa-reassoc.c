@@ -175,8 +175,6 @@ typedef struct operand_entry
   tree op;
 } *operand_entry_t;
 
-static alloc_pool operand_entry_pool;
-
 
 /* Starting rank number for a given basic block, so that we can rank
    operations using unmovable instructions in that BB based on the bb
@@ -345,7 +343,8 @@ sort_by_operand_rank (const void *pa, const void *pb)
 static void
 add_to_ops_vec (VEC(operand_entry_t, heap) **ops, tree op)
 {
-  operand_entry_t oe = (operand_entry_t) pool_alloc (operand_entry_pool);
+  operand_entry_t oe
+    = (operand_entry_t) pass_arena_alloc (sizeof (struct operand_entry));
 
   oe->op = op;
   oe->rank = get_rank (op);
@@ -1979,9 +1978,6 @@ init_reassoc (void)
 
   memset (&reassociate_stats, 0, sizeof (reassociate_stats));
 
-  operand_entry_pool = create_alloc_pool ("operand entry pool",
-					  sizeof (struct operand_entry), 30);
-
   /* Reverse RPO (Reverse Post Order) will give us something where
      deeper loops come later.  */
   pre_and_rev_post_order_compute (NULL, bbs, false);
@@ -2033,7 +2029,6 @@ fini_reassoc (void)
 			    reassociate_stats.rewritten);
 
   pointer_map_destroy (operand_rank);
-  free_alloc_pool (operand_entry_pool);
   free (bb_rank);
   VEC_free (tree, heap, broken_up_subtracts);
   free_dominance_info (CDI_POST_DOMINATORS);
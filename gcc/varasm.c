@@ -4805,8 +4805,102 @@ typedef struct {
   tree val;    /* Current element value.  */
   tree index;  /* Current element index.  */
 
+  /* Run of integer array elements printed with one directive.  */
+  const char *run_op;  /* Directive of the unterminated line, or NULL.  */
+  int run_len;         /* Number of values on that line.  */
+
 } oc_local_state;
 
+/* The most integer array elements printed on one assembler line.  */
+#define OUTPUT_CONSTRUCTOR_INTS_PER_LINE 8
+
+/* Helper for output_constructor.  If the current element of LOCAL is an
+   integer constant at the current position of an array that the default
+   asm_out.integer hook would print, return its value and store the
+   directive to use in *OP; otherwise return NULL_RTX.  */
+
+static rtx
+output_constructor_int_run_value (oc_local_state *local, const char **op)
+{
+  unsigned HOST_WIDE_INT fieldsize;
+  HOST_WIDE_INT fieldpos;
+  unsigned int align2;
+  rtx x;
+
+  if (local->field != NULL_TREE
+      || local->val == NULL_TREE
+      || TREE_CODE (local->val) != INTEGER_CST
+      || !INTEGRAL_TYPE_P (TREE_TYPE (local->val))
+      || local->byte_buffer_in_use
+      || targetm.asm_out.integer != default_assemble_integer
+      || (local->index != NULL_TREE
+	  && TREE_CODE (local->index) != INTEGER_CST))
+    return NULL_RTX;
+
+  fieldsize = int_size_in_bytes (TREE_TYPE (local->type));
+  if (fieldsize > UNITS_PER_WORD
+      || fieldsize != (unsigned HOST_WIDE_INT)
+		      int_size_in_bytes (TREE_TYPE (local->val)))
+    return NULL_RTX;
+
+  fieldpos = local->total_bytes;
+  if (local->index != NULL_TREE)
+    fieldpos = (tree_low_cst (TYPE_SIZE_UNIT (TREE_TYPE (local->val)), 1)
+		* ((tree_low_cst (local->index, 0)
+		    - tree_low_cst (local->min_index, 0))));
+  if (fieldpos != local->total_bytes)
+    return NULL_RTX;
+
+  align2 = min_align (local->align, BITS_PER_UNIT * fieldpos);
+  *op = integer_asm_op (fieldsize,
+			align2 >= MIN (fieldsize * BITS_PER_UNIT,
+				       BIGGEST_ALIGNMENT));
+  if (*op == NULL)
+    return NULL_RTX;
+
+  x = expand_expr (local->val, NULL_RTX, VOIDmode, EXPAND_INITIALIZER);
+  return CONST_INT_P (x) ? x : NULL_RTX;
+}
+
+/* Helper for output_constructor.  Terminate the line of the current run
+   of integer array elements in LOCAL, if any.  */
+
+static void
+output_constructor_end_run (oc_local_state *local)
+{
+  if (local->run_op)
+    {
+      fputc ('\n', asm_out_file);
+      local->run_op = NULL;
+    }
+}
+
+/* Helper for output_constructor.  Output the integer constant X of the
+   current array element in LOCAL with directive OP, continuing the line
+   of the previous element when it used the same directive.  Besides
+   making the assembly smaller, this saves the assembler a directive
+   lookup per element of large tables.  */
+
+static void
+output_constructor_int_run (oc_local_state *local, const char *op, rtx x)
+{
+  if (local->run_op == op
+      && local->run_len < OUTPUT_CONSTRUCTOR_INTS_PER_LINE)
+    {
+      fputc (',', asm_out_file);
+      local->run_len++;
+    }
+  else
+    {
+      output_constructor_end_run (local);
+      fputs (op, asm_out_file);
+      local->run_op = op;
+      local->run_len = 1;
+    }
+  output_addr_const (asm_out_file, x);
+  local->total_bytes += int_size_in_bytes (TREE_TYPE (local->type));
+}
+
 /* Helper for output_constructor.  From the current LOCAL state, output a
    RANGE_EXPR element.  */
 
@@ -5141,6 +5235,8 @@ output_constructor (tree exp, unsigned HOST_WIDE_INT size,
   local.type = TREE_TYPE (exp);
 
   local.last_relative_index = -1;
+  local.run_op = NULL;
+  local.run_len = 0;
 
   local.min_index = NULL_TREE;
   if (TREE_CODE (local.type) == ARRAY_TYPE
@@ -5166,6 +5262,9 @@ output_constructor (tree exp, unsigned HOST_WIDE_INT size,
        VEC_iterate (constructor_elt, CONSTRUCTOR_ELTS (exp), cnt, ce);
        cnt++, local.field = local.field ? TREE_CHAIN (local.field) : 0)
     {
+      const char *op;
+      rtx x;
+
       local.val = ce->value;
       local.index = NULL_TREE;
 
@@ -5195,6 +5294,15 @@ output_constructor (tree exp, unsigned HOST_WIDE_INT size,
 
       /* Output the current element, using the appropriate helper ...  */
 
+      /* For an integer array element that can join the current line.  */
+      if (!outer
+	  && (x = output_constructor_int_run_value (&local, &op)) != NULL_RTX)
+	{
+	  output_constructor_int_run (&local, op, x);
+	  continue;
+	}
+      output_constructor_end_run (&local);
+
       /* For an array slice not part of an outer bitfield.  */
       if (!outer
 	  && local.index != NULL_TREE
@@ -5212,6 +5320,7 @@ output_constructor (tree exp, unsigned HOST_WIDE_INT size,
       else
 	output_constructor_bitfield (&local, outer);
     }
+  output_constructor_end_run (&local);
 
   /* If we are not at toplevel, save the pending data for our caller.
      Otherwise output the pending data and padding zeros as needed. */
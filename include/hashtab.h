@@ -199,6 +199,275 @@ extern hashval_t iterative_hash (const void *, size_t, hashval_t);
 /* Shorthand for hashing something with an intrinsic size.  */
 #define iterative_hash_object(OB,INIT) iterative_hash (&OB, sizeof (OB), INIT)
 
+/* Type-specialized hash tables with hash tags.
+
+   DEFINE_HTAB_TAGGED (NAME, TYPE, KEY, EQ) defines `struct NAME', an
+   open-addressing table of pointers to TYPE, and static inline
+   functions NAME_create, NAME_delete, NAME_empty, NAME_find_with_hash,
+   NAME_find_slot_with_hash, NAME_clear_slot, NAME_traverse,
+   NAME_traverse_noresize, NAME_elements and NAME_collisions that work
+   like their htab_t counterparts.
+
+   Each slot stores the full hash value of its element next to the
+   element pointer.  A probe whose hash differs is therefore rejected
+   without dereferencing the element or calling EQ, and the table is
+   expanded without rehashing.  EQ (const TYPE *ENTRY, const KEY *KEY)
+   is called directly rather than through a pointer, so it can be a
+   macro or an inline function.  Callers always supply the hash, so no
+   hash function is needed.
+
+   The table size is a power of two and probing is triangular, which
+   visits every slot.  The memory comes from xcalloc and free, so these
+   tables must not hold the only reference to garbage collected
+   objects; the user must have declared xcalloc, free, memset and
+   abort, for example by including libiberty.h, stdlib.h and string.h.
+   Use it at file scope, followed by a semicolon.  */
+
+#define HTAB_TAGGED_EMPTY(TYPE)   ((TYPE *) HTAB_EMPTY_ENTRY)
+#define HTAB_TAGGED_DELETED(TYPE) ((TYPE *) HTAB_DELETED_ENTRY)
+
+/* The name of operation or type OP of the tagged table NAME.  */
+#define HTAB_TAGGED_OP(NAME, OP) NAME##_##OP
+
+#define DEFINE_HTAB_TAGGED(NAME, TYPE, KEY, EQ)				\
+struct HTAB_TAGGED_OP (NAME, slot)					\
+{									\
+  hashval_t hash;							\
+  TYPE *elt;								\
+};									\
+									\
+struct NAME								\
+{									\
+  struct HTAB_TAGGED_OP (NAME, slot) *entries;				\
+  size_t size;								\
+  size_t n_elements;							\
+  size_t n_deleted;							\
+  unsigned int searches;						\
+  unsigned int collisions;						\
+  unsigned int size_log2;						\
+};									\
+									\
+/* Return the first slot to probe for HASH: the top SIZE_LOG2 bits of	\
+   HASH times the golden ratio, so that poor low-order bits of HASH	\
+   do not cluster.  */							\
+static inline size_t							\
+HTAB_TAGGED_OP (NAME, index) (const struct NAME *htab, hashval_t hash)	\
+{									\
+  return ((hash * (hashval_t) 0x9e3779b9U) & 0xffffffffU)		\
+	 >> (32 - htab->size_log2);					\
+}									\
+									\
+static inline void							\
+HTAB_TAGGED_OP (NAME, alloc_entries) (struct NAME *htab, size_t size)	\
+{									\
+  unsigned int log2 = 3;						\
+									\
+  while (((size_t) 1 << log2) < size && log2 < 31)			\
+    log2++;								\
+  htab->size_log2 = log2;						\
+  htab->size = (size_t) 1 << log2;					\
+  htab->entries = (struct HTAB_TAGGED_OP (NAME, slot) *)		\
+    xcalloc (htab->size, sizeof (struct HTAB_TAGGED_OP (NAME, slot)));	\
+  htab->n_elements = 0;							\
+  htab->n_deleted = 0;							\
+}									\
+									\
+static inline struct NAME *						\
+HTAB_TAGGED_OP (NAME, create) (size_t size)				\
+{									\
+  struct NAME *htab = (struct NAME *) xcalloc (1, sizeof (struct NAME)); \
+  HTAB_TAGGED_OP (NAME, alloc_entries) (htab, size);			\
+  return htab;								\
+}									\
+									\
+static inline void							\
+HTAB_TAGGED_OP (NAME, delete) (struct NAME *htab)			\
+{									\
+  free (htab->entries);							\
+  free (htab);								\
+}									\
+									\
+static inline size_t							\
+HTAB_TAGGED_OP (NAME, elements) (const struct NAME *htab)		\
+{									\
+  return htab->n_elements - htab->n_deleted;				\
+}									\
+									\
+static inline double							\
+HTAB_TAGGED_OP (NAME, collisions) (const struct NAME *htab)		\
+{									\
+  if (htab->searches == 0)						\
+    return 0.0;								\
+  return (double) htab->collisions / (double) htab->searches;		\
+}									\
+									\
+/* Reallocate HTAB for about twice its live elements, or just drop	\
+   the deleted entries, and reinsert the elements by their stored	\
+   hashes.  */								\
+static inline void							\
+HTAB_TAGGED_OP (NAME, expand) (struct NAME *htab)			\
+{									\
+  struct HTAB_TAGGED_OP (NAME, slot) *oentries = htab->entries;		\
+  size_t osize = htab->size;						\
+  size_t elts = HTAB_TAGGED_OP (NAME, elements) (htab);			\
+  size_t i, index, mask, probe;						\
+									\
+  if (elts * 2 > osize || (elts * 8 < osize && osize > 32))		\
+    HTAB_TAGGED_OP (NAME, alloc_entries) (htab, elts * 2 + 1);		\
+  else									\
+    HTAB_TAGGED_OP (NAME, alloc_entries) (htab, osize);			\
+  htab->n_elements = elts;						\
+									\
+  mask = htab->size - 1;						\
+  for (i = 0; i < osize; i++)						\
+    if (oentries[i].elt != HTAB_TAGGED_EMPTY (TYPE)			\
+	&& oentries[i].elt != HTAB_TAGGED_DELETED (TYPE))		\
+      {									\
+	index = HTAB_TAGGED_OP (NAME, index) (htab, oentries[i].hash);	\
+	for (probe = 1;							\
+	     htab->entries[index].elt != HTAB_TAGGED_EMPTY (TYPE);	\
+	     probe++)							\
+	  index = (index + probe) & mask;				\
+	htab->entries[index] = oentries[i];				\
+      }									\
+  free (oentries);							\
+}									\
+									\
+/* Like htab_empty.  Large tables are shrunk rather than cleared.  */	\
+static inline void							\
+HTAB_TAGGED_OP (NAME, empty) (struct NAME *htab)			\
+{									\
+  size_t bytes = htab->size * sizeof (struct HTAB_TAGGED_OP (NAME, slot)); \
+									\
+  if (bytes > 1024 * 1024)						\
+    {									\
+      free (htab->entries);						\
+      HTAB_TAGGED_OP (NAME, alloc_entries)				\
+	(htab, 1024 / sizeof (struct HTAB_TAGGED_OP (NAME, slot)));	\
+    }									\
+  else									\
+    {									\
+      memset (htab->entries, 0, bytes);					\
+      htab->n_elements = 0;						\
+      htab->n_deleted = 0;						\
+    }									\
+}									\
+									\
+static inline TYPE *							\
+HTAB_TAGGED_OP (NAME, find_with_hash) (struct NAME *htab,		\
+				       const KEY *key, hashval_t hash)	\
+{									\
+  size_t mask = htab->size - 1;						\
+  size_t index = HTAB_TAGGED_OP (NAME, index) (htab, hash);		\
+  size_t probe = 1;							\
+									\
+  htab->searches++;							\
+  for (;;)								\
+    {									\
+      struct HTAB_TAGGED_OP (NAME, slot) *slot = &htab->entries[index];	\
+      TYPE *entry = slot->elt;						\
+									\
+      if (entry == HTAB_TAGGED_EMPTY (TYPE))				\
+	return entry;							\
+      if (slot->hash == hash						\
+	  && entry != HTAB_TAGGED_DELETED (TYPE)			\
+	  && EQ (entry, key))						\
+	return entry;							\
+      htab->collisions++;						\
+      index = (index + probe++) & mask;					\
+    }									\
+}									\
+									\
+/* Like htab_find_slot_with_hash.  When INSERT finds no matching entry	\
+   the returned slot is already tagged with HASH; the caller stores	\
+   the new element through it.  */					\
+static inline TYPE **							\
+HTAB_TAGGED_OP (NAME, find_slot_with_hash) (struct NAME *htab,		\
+					    const KEY *key, hashval_t hash, \
+					    enum insert_option insert)	\
+{									\
+  struct HTAB_TAGGED_OP (NAME, slot) *first_deleted_slot = NULL;	\
+  size_t mask, index, probe = 1;					\
+									\
+  if (insert == INSERT && htab->size * 3 <= htab->n_elements * 4)	\
+    HTAB_TAGGED_OP (NAME, expand) (htab);				\
+									\
+  mask = htab->size - 1;						\
+  index = HTAB_TAGGED_OP (NAME, index) (htab, hash);			\
+  htab->searches++;							\
+  for (;;)								\
+    {									\
+      struct HTAB_TAGGED_OP (NAME, slot) *slot = &htab->entries[index];	\
+      TYPE *entry = slot->elt;						\
+									\
+      if (entry == HTAB_TAGGED_EMPTY (TYPE))				\
+	{								\
+	  if (insert == NO_INSERT)					\
+	    return NULL;						\
+	  if (first_deleted_slot)					\
+	    {								\
+	      htab->n_deleted--;					\
+	      slot = first_deleted_slot;				\
+	      slot->elt = HTAB_TAGGED_EMPTY (TYPE);			\
+	    }								\
+	  else								\
+	    htab->n_elements++;						\
+	  slot->hash = hash;						\
+	  return &slot->elt;						\
+	}								\
+      if (entry == HTAB_TAGGED_DELETED (TYPE))				\
+	{								\
+	  if (!first_deleted_slot)					\
+	    first_deleted_slot = slot;					\
+	}								\
+      else if (slot->hash == hash && EQ (entry, key))			\
+	return &slot->elt;						\
+      htab->collisions++;						\
+      index = (index + probe++) & mask;					\
+    }									\
+}									\
+									\
+static inline void							\
+HTAB_TAGGED_OP (NAME, clear_slot) (struct NAME *htab, TYPE **slot)	\
+{									\
+  if (*slot == HTAB_TAGGED_EMPTY (TYPE)					\
+      || *slot == HTAB_TAGGED_DELETED (TYPE))				\
+    abort ();								\
+  *slot = HTAB_TAGGED_DELETED (TYPE);					\
+  htab->n_deleted++;							\
+}									\
+									\
+static inline void							\
+HTAB_TAGGED_OP (NAME, traverse_noresize) (struct NAME *htab,		\
+					  int (*callback) (TYPE **, void *), \
+					  void *info)			\
+{									\
+  size_t i;								\
+									\
+  for (i = 0; i < htab->size; i++)					\
+    {									\
+      TYPE **slot = &htab->entries[i].elt;				\
+									\
+      if (*slot != HTAB_TAGGED_EMPTY (TYPE)				\
+	  && *slot != HTAB_TAGGED_DELETED (TYPE)			\
+	  && !(*callback) (slot, info))					\
+	break;								\
+    }									\
+}									\
+									\
+static inline void							\
+HTAB_TAGGED_OP (NAME, traverse) (struct NAME *htab,			\
+				 int (*callback) (TYPE **, void *),	\
+				 void *info)				\
+{									\
+  size_t size = htab->size;						\
+									\
+  if (HTAB_TAGGED_OP (NAME, elements) (htab) * 8 < size && size > 32)	\
+    HTAB_TAGGED_OP (NAME, expand) (htab);				\
+  HTAB_TAGGED_OP (NAME, traverse_noresize) (htab, callback, info);	\
+}									\
+struct htab_tagged_swallow_trailing_semi
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -29,12 +29,104 @@
 #endif
 #include "libgomp.h"
 #include <sched.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
 #ifdef HAVE_PTHREAD_AFFINITY_NP
 
-static unsigned int affinity_counter;
+/* The places threads are bound to, gomp_places_list_len of them.  */
+static cpu_set_t *gomp_places;
+
+/* The location of a CPU in the topology.  */
+
+struct gomp_cpu_topology
+{
+  int package;
+  int core;
+  int cpu;
+};
+
+/* Return the topology id NAME of CPU read from sysfs, or -1.  */
+
+static int
+read_topology_id (int cpu, const char *name)
+{
+  char path[sizeof "/sys/devices/system/cpu/cpu/topology/"
+	    + 3 * sizeof (int) + 32];
+  FILE *f;
+  int id = -1;
+
+  sprintf (path, "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+  f = fopen (path, "r");
+  if (f != NULL)
+    {
+      if (fscanf (f, "%d", &id) != 1)
+	id = -1;
+      fclose (f);
+    }
+  return id;
+}
+
+static int
+compare_cpu_topology (const void *x, const void *y)
+{
+  const struct gomp_cpu_topology *a = x, *b = y;
+
+  if (a->package != b->package)
+    return a->package < b->package ? -1 : 1;
+  if (a->core != b->core)
+    return a->core < b->core ? -1 : 1;
+  return a->cpu < b->cpu ? -1 : a->cpu > b->cpu;
+}
+
+/* Make the places gomp_places_var asks for out of the CPUs in CPUSET:
+   one per hardware thread, core or package, ordered by package and core
+   so that consecutive places are close to each other.  Return the
+   number of places and store the number of CPUs in *CPUS.  */
+
+static unsigned long
+gomp_places_from_topology (cpu_set_t *cpuset, unsigned long *cpus)
+{
+  struct gomp_cpu_topology *topo;
+  unsigned long i, n = 0, nplaces = 0;
+  int cpu;
+
+  for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    if (CPU_ISSET (cpu, cpuset))
+      n++;
+  topo = gomp_malloc (n * sizeof (*topo));
+  n = 0;
+  for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    if (CPU_ISSET (cpu, cpuset))
+      {
+	topo[n].cpu = cpu;
+	topo[n].package = read_topology_id (cpu, "physical_package_id");
+	topo[n].core = read_topology_id (cpu, "core_id");
+	/* Without a topology, each CPU is a core of package 0.  */
+	if (topo[n].package < 0)
+	  topo[n].package = 0;
+	if (topo[n].core < 0)
+	  topo[n].core = cpu;
+	n++;
+      }
+  qsort (topo, n, sizeof (*topo), compare_cpu_topology);
+
+  gomp_places = gomp_malloc (n * sizeof (cpu_set_t));
+  for (i = 0; i < n; i++)
+    {
+      if (i == 0
+	  || gomp_places_var == GOMP_PLACES_THREADS
+	  || topo[i].package != topo[i - 1].package
+	  || (gomp_places_var == GOMP_PLACES_CORES
+	      && topo[i].core != topo[i - 1].core))
+	CPU_ZERO (&gomp_places[nplaces++]);
+      CPU_SET (topo[i].cpu, &gomp_places[nplaces - 1]);
+    }
+  free (topo);
+  *cpus = n;
+  return nplaces;
+}
 
 void
 gomp_init_affinity (void)
@@ -49,51 +141,71 @@ gomp_init_affinity (void)
       free (gomp_cpu_affinity);
       gomp_cpu_affinity = NULL;
       gomp_cpu_affinity_len = 0;
+      gomp_bind_var = GOMP_BIND_FALSE;
       return;
     }
 
-  CPU_ZERO (&cpusetnew);
-  for (widx = idx = 0; idx < gomp_cpu_affinity_len; idx++)
-    if (gomp_cpu_affinity[idx] < CPU_SETSIZE
-        && CPU_ISSET (gomp_cpu_affinity[idx], &cpuset))
-      {
-	if (! CPU_ISSET (gomp_cpu_affinity[idx], &cpusetnew))
+  if (gomp_cpu_affinity == NULL)
+    {
+      /* Places from the topology of the CPUs we may run on.  */
+      gomp_places_list_len = gomp_places_from_topology (&cpuset, &cpus);
+    }
+  else
+    {
+      /* Each CPU of GOMP_CPU_AFFINITY is a place.  */
+      CPU_ZERO (&cpusetnew);
+      for (widx = idx = 0; idx < gomp_cpu_affinity_len; idx++)
+	if (gomp_cpu_affinity[idx] < CPU_SETSIZE
+	    && CPU_ISSET (gomp_cpu_affinity[idx], &cpuset))
 	  {
-	    cpus++;
-	    CPU_SET (gomp_cpu_affinity[idx], &cpusetnew);
+	    if (! CPU_ISSET (gomp_cpu_affinity[idx], &cpusetnew))
+	      {
+		cpus++;
+		CPU_SET (gomp_cpu_affinity[idx], &cpusetnew);
+	      }
+	    gomp_cpu_affinity[widx++] = gomp_cpu_affinity[idx];
 	  }
-	gomp_cpu_affinity[widx++] = gomp_cpu_affinity[idx];
-      }
 
-  if (widx == 0)
+      gomp_cpu_affinity_len = widx;
+      if (widx != 0)
+	{
+	  gomp_places = gomp_malloc (widx * sizeof (cpu_set_t));
+	  for (idx = 0; idx < widx; idx++)
+	    {
+	      CPU_ZERO (&gomp_places[idx]);
+	      CPU_SET (gomp_cpu_affinity[idx], &gomp_places[idx]);
+	    }
+	  gomp_places_list_len = widx;
+	}
+    }
+
+  if (gomp_places_list_len == 0)
     {
       gomp_error ("no CPUs left for affinity setting");
       free (gomp_cpu_affinity);
       gomp_cpu_affinity = NULL;
       gomp_cpu_affinity_len = 0;
+      gomp_bind_var = GOMP_BIND_FALSE;
       return;
     }
 
-  gomp_cpu_affinity_len = widx;
   if (cpus < gomp_available_cpus)
     gomp_available_cpus = cpus;
-  CPU_ZERO (&cpuset);
-  CPU_SET (gomp_cpu_affinity[0], &cpuset);
-  pthread_setaffinity_np (pthread_self (), sizeof (cpuset), &cpuset);
-  affinity_counter = 1;
+  /* The initial thread starts on the first place.  */
+  gomp_bind_thread (0);
+}
+
+void
+gomp_init_thread_affinity (pthread_attr_t *attr, unsigned int place)
+{
+  pthread_attr_setaffinity_np (attr, sizeof (cpu_set_t), &gomp_places[place]);
 }
 
 void
-gomp_init_thread_affinity (pthread_attr_t *attr)
+gomp_bind_thread (unsigned int place)
 {
-  unsigned int cpu;
-  cpu_set_t cpuset;
-
-  cpu = __sync_fetch_and_add (&affinity_counter, 1);
-  cpu %= gomp_cpu_affinity_len;
-  CPU_ZERO (&cpuset);
-  CPU_SET (gomp_cpu_affinity[cpu], &cpuset);
-  pthread_attr_setaffinity_np (attr, sizeof (cpu_set_t), &cpuset);
+  pthread_setaffinity_np (pthread_self (), sizeof (cpu_set_t),
+			  &gomp_places[place]);
 }
 
 #else
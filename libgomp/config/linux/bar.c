@@ -27,8 +27,140 @@
    implementation uses atomic instructions and the futex syscall.  */
 
 #include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include "wait.h"
 
+/* With more threads than this contending for one counter, a tree
+   barrier arrives faster than a centralized one.  */
+#define GOMP_BARRIER_GROUP_MAX 8
+
+/* The group size of tree barriers, 0 before it has been chosen.  */
+static unsigned gomp_barrier_tree_group_size;
+/* Whether GOMP_BARRIER=auto uses tree barriers for teams of more than
+   one group: on machines with several packages, or large packages.  */
+static bool gomp_barrier_tree_auto;
+
+/* Choose the group size of tree barriers from the CPU topology in
+   sysfs, so that the threads of a group share a package as long as
+   they are bound to CPUs in order: the CPUs of a package are split
+   evenly into groups of at most GOMP_BARRIER_GROUP_MAX.  */
+
+static void
+gomp_barrier_init_topology (void)
+{
+  char name[sizeof "/sys/devices/system/cpu/cpu/topology/physical_package_id"
+	    + 3 * sizeof (unsigned)];
+  unsigned cpu, ngroups, per_package = 0, size;
+  int package0 = -1;
+  bool multi = false;
+
+  for (cpu = 0; ; cpu++)
+    {
+      FILE *f;
+      int package;
+
+      sprintf (name, "/sys/devices/system/cpu/cpu%u", cpu);
+      if (access (name, F_OK) != 0)
+	break;
+      sprintf (name, "/sys/devices/system/cpu/cpu%u/topology/"
+	       "physical_package_id", cpu);
+      f = fopen (name, "r");
+      /* Offline CPUs have no topology.  */
+      if (f == NULL)
+	continue;
+      if (fscanf (f, "%d", &package) == 1)
+	{
+	  if (package0 == -1)
+	    package0 = package;
+	  if (package == package0)
+	    per_package++;
+	  else
+	    multi = true;
+	}
+      fclose (f);
+    }
+
+  if (per_package == 0)
+    per_package = gomp_available_cpus;
+  if (gomp_barrier_group_size_var)
+    size = gomp_barrier_group_size_var;
+  else
+    {
+      ngroups = (per_package + GOMP_BARRIER_GROUP_MAX - 1)
+		/ GOMP_BARRIER_GROUP_MAX;
+      size = (per_package + ngroups - 1) / ngroups;
+      if (size < 2)
+	size = 2;
+    }
+  gomp_barrier_tree_auto = multi || per_package > GOMP_BARRIER_GROUP_MAX;
+  gomp_barrier_tree_group_size = size;
+}
+
+/* Initialize the barrier BAR of a team of COUNT threads, as a tree
+   barrier if GOMP_BARRIER says so, or if it is "auto" and the team
+   spans several groups on a large or multi-package machine.  */
+
+void
+gomp_team_barrier_init (gomp_barrier_t *bar, unsigned count)
+{
+  unsigned i, size, ngroups;
+
+  gomp_barrier_init (bar, count);
+  if (count <= 1 || gomp_barrier_var == GOMP_BARRIER_CENTRAL)
+    return;
+
+  /* Racing initializations compute the same values.  */
+  if (gomp_barrier_tree_group_size == 0)
+    gomp_barrier_init_topology ();
+  size = gomp_barrier_tree_group_size;
+  if (gomp_barrier_var == GOMP_BARRIER_AUTO
+      && (count <= size || !gomp_barrier_tree_auto))
+    return;
+
+  ngroups = (count + size - 1) / size;
+  /* Give each group a cache line of its own.  */
+  bar->groups_mem = gomp_malloc ((ngroups + 1)
+				 * sizeof (struct gomp_barrier_group));
+  bar->groups = (struct gomp_barrier_group *)
+    (((uintptr_t) bar->groups_mem + sizeof (struct gomp_barrier_group) - 1)
+     & -(uintptr_t) sizeof (struct gomp_barrier_group));
+  for (i = 0; i < ngroups; i++)
+    {
+      unsigned n = i == ngroups - 1 ? count - i * size : size;
+      bar->groups[i].awaited = n;
+      bar->groups[i].total = n;
+    }
+  bar->group_size = size;
+  bar->arrivals = ngroups;
+  bar->awaited = ngroups;
+}
+
+void
+gomp_team_barrier_destroy (gomp_barrier_t *bar)
+{
+  free (bar->groups_mem);
+  gomp_barrier_destroy (bar);
+}
+
+/* The arrival of the calling thread at the tree barrier BAR: only the
+   last thread of each group decrements AWAITED.  */
+
+gomp_barrier_state_t
+gomp_barrier_tree_wait_start (gomp_barrier_t *bar)
+{
+  struct gomp_barrier_group *group
+    = &bar->groups[gomp_thread ()->ts.team_id / bar->group_size];
+  unsigned int ret = bar->generation & ~3;
+
+  if (__sync_add_and_fetch (&group->awaited, -1) != 0)
+    return ret;
+  /* No thread of the group arrives again before the release.  */
+  group->awaited = group->total;
+  ret += __sync_add_and_fetch (&bar->awaited, -1) == 0;
+  return ret;
+}
 
 void
 gomp_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
@@ -36,17 +168,18 @@ gomp_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
   if (__builtin_expect ((state & 1) != 0, 0))
     {
       /* Next time we'll be awaiting TOTAL threads again.  */
-      bar->awaited = bar->total;
+      bar->awaited = bar->arrivals;
       atomic_write_barrier ();
       bar->generation += 4;
-      futex_wake ((int *) &bar->generation, INT_MAX);
+      do_wake ((int *) &bar->generation, INT_MAX, GOMP_WAIT_BARRIER);
     }
   else
     {
       unsigned int generation = state;
 
       do
-	do_wait ((int *) &bar->generation, generation);
+	do_wait ((int *) &bar->generation, generation,
+		 GOMP_WAIT_BARRIER);
       while (bar->generation == generation);
     }
 }
@@ -75,12 +208,14 @@ gomp_barrier_wait_last (gomp_barrier_t *bar)
 void
 gomp_team_barrier_wake (gomp_barrier_t *bar, int count)
 {
-  futex_wake ((int *) &bar->generation, count == 0 ? INT_MAX : count);
+  do_wake ((int *) &bar->generation, count == 0 ? INT_MAX : count,
+	   GOMP_WAIT_BARRIER);
 }
 
 void
 gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
 {
+  struct gomp_profile_wait w;
   unsigned int generation;
 
   if (__builtin_expect ((state & 1) != 0, 0))
@@ -88,7 +223,7 @@ gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
       /* Next time we'll be awaiting TOTAL threads again.  */
       struct gomp_thread *thr = gomp_thread ();
       struct gomp_team *team = thr->ts.team;
-      bar->awaited = bar->total;
+      bar->awaited = bar->arrivals;
       atomic_write_barrier ();
       if (__builtin_expect (team->task_count, 0))
 	{
@@ -98,21 +233,23 @@ gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
       else
 	{
 	  bar->generation = state + 3;
-	  futex_wake ((int *) &bar->generation, INT_MAX);
+	  do_wake ((int *) &bar->generation, INT_MAX, GOMP_WAIT_BARRIER);
 	  return;
 	}
     }
 
   generation = state;
+  gomp_profile_wait_start (&w);
   do
     {
-      do_wait ((int *) &bar->generation, generation);
+      do_wait ((int *) &bar->generation, generation, GOMP_WAIT_BARRIER);
       if (__builtin_expect (bar->generation & 1, 0))
 	gomp_barrier_handle_tasks (state);
       if ((bar->generation & 2))
 	generation |= 2;
     }
   while (bar->generation != state + 4);
+  gomp_profile_wait_end (&w, GOMP_PROFILE_BARRIER);
 }
 
 void
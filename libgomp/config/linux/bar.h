@@ -31,12 +31,32 @@
 
 #include "mutex.h"
 
+/* The arrival counter of a group of threads of a tree barrier.  Each
+   one has a cacheline of its own.  */
+
+struct gomp_barrier_group
+{
+  unsigned awaited;
+  unsigned total;
+  char pad[64 - 2 * sizeof (unsigned)];
+};
+
 typedef struct
 {
   /* Make sure total/generation is in a mostly read cacheline, while
      awaited in a separate cacheline.  */
   unsigned total __attribute__((aligned (64)));
   unsigned generation;
+  /* The number of arrivals AWAITED counts down from: TOTAL, or the
+     number of GROUPS for a tree barrier.  */
+  unsigned arrivals;
+  /* For a tree barrier, threads GROUP_SIZE * I to
+     GROUP_SIZE * (I + 1) - 1 of the team first arrive at GROUPS[I],
+     and only the last of each group at AWAITED.  NULL otherwise.  */
+  unsigned group_size;
+  struct gomp_barrier_group *groups;
+  /* The allocation GROUPS is the first cache line of.  */
+  void *groups_mem;
   unsigned awaited __attribute__((aligned (64)));
 } gomp_barrier_t;
 typedef unsigned int gomp_barrier_state_t;
@@ -44,20 +64,26 @@ typedef unsigned int gomp_barrier_state_t;
 static inline void gomp_barrier_init (gomp_barrier_t *bar, unsigned count)
 {
   bar->total = count;
+  bar->arrivals = count;
   bar->awaited = count;
   bar->generation = 0;
+  bar->groups = NULL;
+  bar->groups_mem = NULL;
 }
 
 static inline void gomp_barrier_reinit (gomp_barrier_t *bar, unsigned count)
 {
   __sync_fetch_and_add (&bar->awaited, count - bar->total);
   bar->total = count;
+  bar->arrivals = count;
 }
 
 static inline void gomp_barrier_destroy (gomp_barrier_t *bar)
 {
 }
 
+extern void gomp_team_barrier_init (gomp_barrier_t *, unsigned);
+extern void gomp_team_barrier_destroy (gomp_barrier_t *);
 extern void gomp_barrier_wait (gomp_barrier_t *);
 extern void gomp_barrier_wait_last (gomp_barrier_t *);
 extern void gomp_barrier_wait_end (gomp_barrier_t *, gomp_barrier_state_t);
@@ -65,11 +91,16 @@ extern void gomp_team_barrier_wait (gomp_barrier_t *);
 extern void gomp_team_barrier_wait_end (gomp_barrier_t *,
 					gomp_barrier_state_t);
 extern void gomp_team_barrier_wake (gomp_barrier_t *, int);
+extern gomp_barrier_state_t gomp_barrier_tree_wait_start (gomp_barrier_t *);
 
 static inline gomp_barrier_state_t
 gomp_barrier_wait_start (gomp_barrier_t *bar)
 {
-  unsigned int ret = bar->generation & ~3;
+  unsigned int ret;
+
+  if (__builtin_expect (bar->groups != NULL, 0))
+    return gomp_barrier_tree_wait_start (bar);
+  ret = bar->generation & ~3;
   /* Do we need any barrier here or is __sync_add_and_fetch acting
      as the needed LoadLoad barrier already?  */
   ret += __sync_add_and_fetch (&bar->awaited, -1) == 0;
@@ -82,6 +113,15 @@ gomp_barrier_last_thread (gomp_barrier_state_t state)
   return state & 1;
 }
 
+/* Whether deferred tasks are advertised to the waiting threads.  This
+   may be read without team->task_lock held, as a hint.  */
+
+static inline bool
+gomp_team_barrier_task_pending (gomp_barrier_t *bar)
+{
+  return (bar->generation & 1) != 0;
+}
+
 /* All the inlines below must be called with team->task_lock
    held.  */
 
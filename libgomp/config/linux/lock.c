@@ -196,7 +196,7 @@ gomp_set_nest_lock_25 (omp_nest_lock_25_t *lock)
 	  return;
 	}
 
-      do_wait (&lock->owner, otid);
+      do_wait (&lock->owner, otid, GOMP_WAIT_LOCK);
     }
 }
 
@@ -208,7 +208,7 @@ gomp_unset_nest_lock_25 (omp_nest_lock_25_t *lock)
   if (--lock->count == 0)
     {
       __sync_lock_release (&lock->owner);
-      futex_wake (&lock->owner, 1);
+      do_wake (&lock->owner, 1, GOMP_WAIT_LOCK);
     }
 }
 
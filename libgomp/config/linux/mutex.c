@@ -26,11 +26,88 @@
    mechanism for libgomp.  This type is private to the library.  This
    implementation uses atomic instructions and the futex syscall.  */
 
+#include <stdio.h>
 #include "wait.h"
 
+/* The lower bound of the adaptive spin budgets, and the sleep times
+   below which they grow and above which they shrink.  */
+#define GOMP_SPIN_MIN		1000
+#define GOMP_SPIN_GROW_NS	50000
+#define GOMP_SPIN_SHRINK_NS	2000000
+
 long int gomp_futex_wake = FUTEX_WAKE | FUTEX_PRIVATE_FLAG;
 long int gomp_futex_wait = FUTEX_WAIT | FUTEX_PRIVATE_FLAG;
 
+unsigned long gomp_wait_stats[GOMP_WAIT_SITES][GOMP_STATS];
+#ifdef HAVE_TLS
+__thread unsigned long gomp_spin_budget[GOMP_WAIT_SITES];
+#else
+unsigned long gomp_spin_budget[GOMP_WAIT_SITES];
+#endif
+
+/* Sleep while *ADDR is VAL, after COUNT spins at SITE.  With adaptive
+   spinning, a short sleep means that spinning a little longer would
+   have been cheaper, and a long one that the spins were wasted, so
+   grow or shrink the spin budget of SITE accordingly.  */
+
+void
+gomp_wait_sleep (int *addr, int val, enum gomp_wait_site site,
+		 unsigned long long count)
+{
+  unsigned long long t;
+  unsigned long budget;
+
+  if (__builtin_expect (gomp_stats_var, 0))
+    {
+      __sync_fetch_and_add (&gomp_wait_stats[site][GOMP_STAT_SPINS], count);
+      __sync_fetch_and_add (&gomp_wait_stats[site][GOMP_STAT_SLEEPS], 1);
+    }
+  if (!gomp_spin_adaptive || gomp_managed_threads > gomp_available_cpus)
+    {
+      futex_wait (addr, val);
+      return;
+    }
+
+  t = gomp_clock_ns ();
+  futex_wait (addr, val);
+  t = gomp_clock_ns () - t;
+
+  budget = gomp_spin_budget[site];
+  if (budget == 0)
+    budget = GOMP_SPIN_INITIAL;
+  if (t < GOMP_SPIN_GROW_NS)
+    budget *= 2;
+  else if (t > GOMP_SPIN_SHRINK_NS)
+    budget /= 2;
+  if (budget > gomp_spin_count_var)
+    budget = gomp_spin_count_var;
+  if (budget < GOMP_SPIN_MIN)
+    budget = GOMP_SPIN_MIN;
+  gomp_spin_budget[site] = budget;
+}
+
+/* Print the GOMP_STATS counters.  */
+
+static void __attribute__((destructor))
+gomp_report_wait_stats (void)
+{
+  static const char *const names[GOMP_WAIT_SITES]
+    = { "barrier", "mutex", "semaphore", "nest lock", "ptrlock" };
+  int i;
+
+  if (!gomp_stats_var)
+    return;
+
+  fprintf (stderr, "\nlibgomp: %-10s %14s %12s %12s %12s\n",
+	   "wait", "spins", "spun waits", "sleeps", "wakeups");
+  for (i = 0; i < GOMP_WAIT_SITES; i++)
+    fprintf (stderr, "libgomp: %-10s %14lu %12lu %12lu %12lu\n", names[i],
+	     gomp_wait_stats[i][GOMP_STAT_SPINS],
+	     gomp_wait_stats[i][GOMP_STAT_SPUN],
+	     gomp_wait_stats[i][GOMP_STAT_SLEEPS],
+	     gomp_wait_stats[i][GOMP_STAT_WAKEUPS]);
+}
+
 void
 gomp_mutex_lock_slow (gomp_mutex_t *mutex)
 {
@@ -38,7 +115,7 @@ gomp_mutex_lock_slow (gomp_mutex_t *mutex)
     {
       int oldval = __sync_val_compare_and_swap (mutex, 1, 2);
       if (oldval != 0)
-	do_wait (mutex, 2);
+	do_wait (mutex, 2, GOMP_WAIT_MUTEX);
     }
   while (!__sync_bool_compare_and_swap (mutex, 0, 2));
 }
@@ -46,5 +123,5 @@ gomp_mutex_lock_slow (gomp_mutex_t *mutex)
 void
 gomp_mutex_unlock_slow (gomp_mutex_t *mutex)
 {
-  futex_wake (mutex, 1);
+  do_wake (mutex, 1, GOMP_WAIT_MUTEX);
 }
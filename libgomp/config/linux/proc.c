@@ -93,7 +93,7 @@ get_num_procs (void)
 #ifdef HAVE_PTHREAD_AFFINITY_NP
   cpu_set_t cpuset;
 
-  if (gomp_cpu_affinity == NULL)
+  if (gomp_places_list_len == 0)
     {
       /* Count only the CPUs this process can use.  */
       if (pthread_getaffinity_np (pthread_self (), sizeof (cpuset),
@@ -106,11 +106,11 @@ get_num_procs (void)
   else
     {
       /* We can't use pthread_getaffinity_np in this case
-	 (we have changed it ourselves, it binds to just one CPU).
+	 (we have changed it ourselves, it binds to just one place).
 	 Count instead the number of different CPUs we are
 	 using.  gomp_init_affinity updated gomp_available_cpus to
-	 the number of CPUs in the GOMP_AFFINITY mask that we are
-	 allowed to use though.  */
+	 the number of CPUs in the places that we are allowed to
+	 use though.  */
       return gomp_available_cpus;
     }
 #endif
@@ -46,7 +46,7 @@ gomp_ptrlock_get_slow (gomp_ptrlock_t *ptrlock)
     intptr += (sizeof (*ptrlock) / sizeof (int)) - 1;
 #endif
   do
-    do_wait (intptr, 2);
+    do_wait (intptr, 2, GOMP_WAIT_PTRLOCK);
   while (*intptr == 2);
   __asm volatile ("" : : : "memory");
   return *ptrlock;
@@ -63,5 +63,5 @@ gomp_ptrlock_set_slow (gomp_ptrlock_t *ptrlock, void *ptr)
   if (sizeof (*ptrlock) > sizeof (int))
     intptr += (sizeof (*ptrlock) / sizeof (int)) - 1;
 #endif
-  futex_wake (intptr, INT_MAX);
+  do_wake (intptr, INT_MAX, GOMP_WAIT_PTRLOCK);
 }
@@ -40,7 +40,7 @@ gomp_sem_wait_slow (gomp_sem_t *sem)
 	  if (__sync_bool_compare_and_swap (sem, val, val - 1))
 	    return;
 	}
-      do_wait (sem, -1);
+      do_wait (sem, -1, GOMP_WAIT_SEM);
     }
 }
 
@@ -57,5 +57,5 @@ gomp_sem_post_slow (gomp_sem_t *sem)
     }
   while (old != tmp);
 
-  futex_wake (sem, wake);
+  do_wake (sem, wake, GOMP_WAIT_SEM);
 }
@@ -44,18 +44,78 @@ extern long int gomp_futex_wait, gomp_futex_wake;
 
 #include "futex.h"
 
-static inline void do_wait (int *addr, int val)
+/* The kinds of places that wait, each with a spin budget of its own.  */
+
+enum gomp_wait_site
+{
+  GOMP_WAIT_BARRIER,
+  GOMP_WAIT_MUTEX,
+  GOMP_WAIT_SEM,
+  GOMP_WAIT_LOCK,
+  GOMP_WAIT_PTRLOCK,
+  GOMP_WAIT_SITES
+};
+
+/* The GOMP_STATS counters of each site.  */
+
+enum gomp_wait_stat
+{
+  GOMP_STAT_SPINS,
+  GOMP_STAT_SPUN,
+  GOMP_STAT_SLEEPS,
+  GOMP_STAT_WAKEUPS,
+  GOMP_STATS
+};
+
+extern unsigned long gomp_wait_stats[GOMP_WAIT_SITES][GOMP_STATS];
+
+/* The number of spins before sleeping at each site, learned by
+   gomp_wait_sleep.  0 until the first sleep, which means that the site
+   spins GOMP_SPIN_INITIAL times, so that the first wait of a new thread
+   does not go straight to the futex.  */
+#define GOMP_SPIN_INITIAL	100000
+
+#ifdef HAVE_TLS
+extern __thread unsigned long gomp_spin_budget[GOMP_WAIT_SITES];
+#else
+extern unsigned long gomp_spin_budget[GOMP_WAIT_SITES];
+#endif
+
+extern void gomp_wait_sleep (int *, int, enum gomp_wait_site,
+			     unsigned long long);
+
+static inline void do_wait (int *addr, int val, enum gomp_wait_site site)
 {
   unsigned long long i, count = gomp_spin_count_var;
 
   if (__builtin_expect (gomp_managed_threads > gomp_available_cpus, 0))
     count = gomp_throttled_spin_count_var;
+  else if (gomp_spin_adaptive)
+    {
+      count = gomp_spin_budget[site];
+      if (__builtin_expect (count == 0, 0))
+	count = GOMP_SPIN_INITIAL;
+    }
   for (i = 0; i < count; i++)
     if (__builtin_expect (*addr != val, 0))
-      return;
+      {
+	if (__builtin_expect (gomp_stats_var, 0))
+	  {
+	    __sync_fetch_and_add (&gomp_wait_stats[site][GOMP_STAT_SPINS], i);
+	    __sync_fetch_and_add (&gomp_wait_stats[site][GOMP_STAT_SPUN], 1);
+	  }
+	return;
+      }
     else
       cpu_relax ();
-  futex_wait (addr, val);
+  gomp_wait_sleep (addr, val, site, count);
+}
+
+static inline void do_wake (int *addr, int count, enum gomp_wait_site site)
+{
+  if (__builtin_expect (gomp_stats_var, 0))
+    __sync_fetch_and_add (&gomp_wait_stats[site][GOMP_STAT_WAKEUPS], 1);
+  futex_wake (addr, count);
 }
 
 #ifdef HAVE_ATTRIBUTE_VISIBILITY
@@ -42,5 +42,16 @@ omp_get_wtick (void)
   return 1e-3;
 }
 
+/* Return a time stamp in nanoseconds, for timing short intervals within
+   the library.  */
+
+unsigned long long
+gomp_clock_ns (void)
+{
+  struct _timeb timebuf;
+  _ftime (&timebuf);
+  return timebuf.time * 1000000000ULL + timebuf.millitm * 1000000ULL;
+}
+
 ialias (omp_get_wtime)
 ialias (omp_get_wtick)
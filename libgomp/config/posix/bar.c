@@ -111,6 +111,7 @@ gomp_barrier_wait (gomp_barrier_t *barrier)
 void
 gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
 {
+  struct gomp_profile_wait w;
   unsigned int n;
 
   if (state & 1)
@@ -141,6 +142,7 @@ gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
   else
     {
       gomp_mutex_unlock (&bar->mutex1);
+      gomp_profile_wait_start (&w);
       do
 	{
 	  gomp_sem_wait (&bar->sem1);
@@ -148,6 +150,7 @@ gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
 	    gomp_barrier_handle_tasks (state);
 	}
       while (bar->generation != state + 4);
+      gomp_profile_wait_end (&w, GOMP_PROFILE_BARRIER);
 
 #ifdef HAVE_SYNC_BUILTINS
       n = __sync_add_and_fetch (&bar->arrived, -1);
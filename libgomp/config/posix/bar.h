@@ -57,6 +57,20 @@ extern void gomp_team_barrier_wait_end (gomp_barrier_t *,
 					gomp_barrier_state_t);
 extern void gomp_team_barrier_wake (gomp_barrier_t *, int);
 
+/* There is no tree barrier in this implementation.  */
+
+static inline void
+gomp_team_barrier_init (gomp_barrier_t *bar, unsigned count)
+{
+  gomp_barrier_init (bar, count);
+}
+
+static inline void
+gomp_team_barrier_destroy (gomp_barrier_t *bar)
+{
+  gomp_barrier_destroy (bar);
+}
+
 static inline gomp_barrier_state_t
 gomp_barrier_wait_start (gomp_barrier_t *bar)
 {
@@ -79,6 +93,15 @@ gomp_barrier_wait_last (gomp_barrier_t *bar)
   gomp_barrier_wait (bar);
 }
 
+/* Whether deferred tasks are advertised to the waiting threads.  This
+   may be read without team->task_lock held, as a hint.  */
+
+static inline bool
+gomp_team_barrier_task_pending (gomp_barrier_t *bar)
+{
+  return (bar->generation & 1) != 0;
+}
+
 /* All the inlines below must be called with team->task_lock
    held.  */
 
@@ -74,5 +74,25 @@ omp_get_wtick (void)
 #endif
 }
 
+/* Return a time stamp in nanoseconds, for timing short intervals within
+   the library.  */
+
+unsigned long long
+gomp_clock_ns (void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts;
+# ifdef CLOCK_MONOTONIC
+  if (clock_gettime (CLOCK_MONOTONIC, &ts) < 0)
+# endif
+    clock_gettime (CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+#endif
+}
+
 ialias (omp_get_wtime)
 ialias (omp_get_wtick)
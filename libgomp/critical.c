@@ -46,8 +46,12 @@ GOMP_critical_end (void)
 static gomp_mutex_t create_lock_lock;
 #endif
 
-void
-GOMP_critical_name_start (void **pptr)
+/* Return the lock of the named critical section whose pointer-sized
+   variable is *PPTR, creating it the first time any thread gets here.
+   Afterwards this is a plain read of *PPTR, without taking any lock.  */
+
+static inline gomp_mutex_t *
+critical_name_lock (void **pptr)
 {
   gomp_mutex_t *plock;
 
@@ -56,89 +60,151 @@ GOMP_critical_name_start (void **pptr)
   if (GOMP_MUTEX_INIT_0
       && sizeof (gomp_mutex_t) <= sizeof (void *)
       && __alignof (gomp_mutex_t) <= sizeof (void *))
-    plock = (gomp_mutex_t *)pptr;
+    return (gomp_mutex_t *)pptr;
 
   /* Otherwise we have to be prepared to malloc storage.  */
-  else
-    {
-      plock = *pptr;
+  plock = *pptr;
+  if (__builtin_expect (plock != NULL, 1))
+    return plock;
 
-      if (plock == NULL)
-	{
 #ifdef HAVE_SYNC_BUILTINS
-	  gomp_mutex_t *nlock = gomp_malloc (sizeof (gomp_mutex_t));
-	  gomp_mutex_init (nlock);
-
-	  plock = __sync_val_compare_and_swap (pptr, NULL, nlock);
-	  if (plock != NULL)
-	    {
-	      gomp_mutex_destroy (nlock);
-	      free (nlock);
-	    }
-	  else
-	    plock = nlock;
+  {
+    gomp_mutex_t *nlock = gomp_malloc (sizeof (gomp_mutex_t));
+    gomp_mutex_init (nlock);
+
+    plock = __sync_val_compare_and_swap (pptr, NULL, nlock);
+    if (plock != NULL)
+      {
+	gomp_mutex_destroy (nlock);
+	free (nlock);
+      }
+    else
+      plock = nlock;
+  }
 #else
-	  gomp_mutex_lock (&create_lock_lock);
-	  plock = *pptr;
-	  if (plock == NULL)
-	    {
-	      plock = gomp_malloc (sizeof (gomp_mutex_t));
-	      gomp_mutex_init (plock);
-	      __sync_synchronize ();
-	      *pptr = plock;
-	    }
-	  gomp_mutex_unlock (&create_lock_lock);
-#endif
-	}
+  gomp_mutex_lock (&create_lock_lock);
+  plock = *pptr;
+  if (plock == NULL)
+    {
+      plock = gomp_malloc (sizeof (gomp_mutex_t));
+      gomp_mutex_init (plock);
+      __sync_synchronize ();
+      *pptr = plock;
     }
+  gomp_mutex_unlock (&create_lock_lock);
+#endif
+  return plock;
+}
 
-  gomp_mutex_lock (plock);
+void
+GOMP_critical_name_start (void **pptr)
+{
+  gomp_mutex_lock (critical_name_lock (pptr));
 }
 
 void
 GOMP_critical_name_end (void **pptr)
 {
-  gomp_mutex_t *plock;
-
-  /* If a mutex fits within the space for a pointer, and is zero initialized,
-     then use the pointer space directly.  */
-  if (GOMP_MUTEX_INIT_0
-      && sizeof (gomp_mutex_t) <= sizeof (void *)
-      && __alignof (gomp_mutex_t) <= sizeof (void *))
-    plock = (gomp_mutex_t *)pptr;
-  else
-    plock = *pptr;
-
-  gomp_mutex_unlock (plock);
+  gomp_mutex_unlock (critical_name_lock (pptr));
 }
 
-/* This mutex is used when atomic operations don't exist for the target
+/* These mutexes are used when atomic operations don't exist for the target
    in the mode requested.  The result is not globally atomic, but works so
    long as all parallel references are within #pragma omp atomic directives.
    According to responses received from omp@openmp.org, appears to be within
    spec.  Which makes sense, since that's how several other compilers 
-   handle this situation as well.  */
+   handle this situation as well.
+
+   The locks are striped by the address of the object, so that unrelated
+   atomic updates from different loops need not contend on one lock.  The
+   same object always maps to the same stripe, and atomic sections never
+   nest, so taking one stripe at a time cannot deadlock.  */
 
-static gomp_mutex_t atomic_lock;
+#define ATOMIC_LOCK_STRIPES 64
+
+/* Each stripe sits in its own cache line.  */
+static struct
+{
+  gomp_mutex_t lock __attribute__((aligned (64)));
+} atomic_locks[ATOMIC_LOCK_STRIPES];
+
+/* Set once GOMP_atomic_start, which doesn't know the address, has been
+   called.  From then on every atomic section uses the first stripe.  It
+   only changes while GOMP_atomic_start holds all the other stripes, so a
+   thread holding one of those sees the same value throughout.  */
+static bool atomic_locks_merged;
+
+/* Return the lock of the atomic sections on the object at ADDR.  */
+
+static inline gomp_mutex_t *
+atomic_addr_lock (void *addr)
+{
+  unsigned long h = (unsigned long) addr >> 6;
+
+  if (__builtin_expect (atomic_locks_merged, 0))
+    return &atomic_locks[0].lock;
+  h ^= h >> 6;
+  return &atomic_locks[h & (ATOMIC_LOCK_STRIPES - 1)].lock;
+}
+
+void
+GOMP_atomic_addr_start (void *addr)
+{
+  gomp_mutex_t *lock = atomic_addr_lock (addr);
+
+  gomp_mutex_lock (lock);
+  /* Check again with the stripe held, see GOMP_atomic_start.  */
+  if (__builtin_expect (atomic_locks_merged, 0)
+      && lock != &atomic_locks[0].lock)
+    {
+      gomp_mutex_unlock (lock);
+      gomp_mutex_lock (&atomic_locks[0].lock);
+    }
+}
+
+void
+GOMP_atomic_addr_end (void *addr)
+{
+  gomp_mutex_unlock (atomic_addr_lock (addr));
+}
+
+/* Objects from older compilers don't pass the address, so these have to
+   exclude the atomic sections on any stripe.  Rather than taking all the
+   stripes each time, the first call merges them into the first one.  */
 
 void
 GOMP_atomic_start (void)
 {
-  gomp_mutex_lock (&atomic_lock);
+  if (__builtin_expect (!atomic_locks_merged, 0))
+    {
+      int i;
+
+      /* Set ATOMIC_LOCKS_MERGED only when no section holds any other
+	 stripe.  Those that take one afterwards see it set.  */
+      for (i = 1; i < ATOMIC_LOCK_STRIPES; i++)
+	gomp_mutex_lock (&atomic_locks[i].lock);
+      atomic_locks_merged = true;
+      for (i = ATOMIC_LOCK_STRIPES - 1; i >= 1; i--)
+	gomp_mutex_unlock (&atomic_locks[i].lock);
+    }
+  gomp_mutex_lock (&atomic_locks[0].lock);
 }
 
 void
 GOMP_atomic_end (void)
 {
-  gomp_mutex_unlock (&atomic_lock);
+  gomp_mutex_unlock (&atomic_locks[0].lock);
 }
 
 #if !GOMP_MUTEX_INIT_0
 static void __attribute__((constructor))
 initialize_critical (void)
 {
+  int i;
+
   gomp_mutex_init (&default_lock);
-  gomp_mutex_init (&atomic_lock);
+  for (i = 0; i < ATOMIC_LOCK_STRIPES; i++)
+    gomp_mutex_init (&atomic_locks[i].lock);
 #ifndef HAVE_SYNC_BUILTINS
   gomp_mutex_init (&create_lock_lock);
 #endif
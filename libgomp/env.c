@@ -59,6 +59,9 @@ struct gomp_task_icv gomp_global_icv = {
 
 unsigned short *gomp_cpu_affinity;
 size_t gomp_cpu_affinity_len;
+enum gomp_bind_kind gomp_bind_var = GOMP_BIND_FALSE;
+enum gomp_places_kind gomp_places_var = GOMP_PLACES_CORES;
+unsigned long gomp_places_list_len;
 unsigned long gomp_max_active_levels_var = INT_MAX;
 unsigned long gomp_thread_limit_var = ULONG_MAX;
 unsigned long gomp_remaining_threads_count;
@@ -67,6 +70,12 @@ gomp_mutex_t gomp_remaining_threads_lock;
 #endif
 unsigned long gomp_available_cpus = 1, gomp_managed_threads = 1;
 unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
+bool gomp_spin_adaptive, gomp_stats_var;
+unsigned long gomp_task_cutoff_var = 64;
+bool gomp_task_cutoff_adaptive = true;
+unsigned long gomp_nested_pool_max_var = 64;
+enum gomp_barrier_kind gomp_barrier_var = GOMP_BARRIER_AUTO;
+unsigned long gomp_barrier_group_size_var;
 
 /* Parse the OMP_SCHEDULE environment variable.  */
 
@@ -102,6 +111,11 @@ parse_schedule (void)
       gomp_global_icv.run_sched_var = GFS_AUTO;
       env += 4;
     }
+  else if (strncasecmp (env, "adaptive", 8) == 0)
+    {
+      gomp_global_icv.run_sched_var = GFS_ADAPTIVE;
+      env += 8;
+    }
   else
     goto unknown;
 
@@ -312,6 +326,154 @@ parse_spincount (const char *name, unsigned long long *pvalue)
   return false;
 }
 
+/* Parse the GOMP_TASK_CUTOFF environment variable: a number of queued
+   tasks per thread beyond which new tasks run immediately, optionally
+   preceded by "adaptive," to also run short tasks immediately.  */
+
+static void
+parse_task_cutoff (void)
+{
+  char *env, *end;
+  unsigned long value;
+  bool adaptive = false;
+
+  env = getenv ("GOMP_TASK_CUTOFF");
+  if (env == NULL)
+    return;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (strncasecmp (env, "adaptive", 8) == 0)
+    {
+      adaptive = true;
+      env += 8;
+      while (isspace ((unsigned char) *env))
+	++env;
+      if (*env == '\0')
+	{
+	  gomp_task_cutoff_adaptive = true;
+	  return;
+	}
+      if (*env++ != ',')
+	goto unknown;
+      while (isspace ((unsigned char) *env))
+	++env;
+    }
+  if (*env == '\0')
+    goto invalid;
+
+  errno = 0;
+  value = strtoul (env, &end, 10);
+  if (errno || end == env)
+    goto invalid;
+
+  while (isspace ((unsigned char) *end))
+    ++end;
+  if (*end != '\0')
+    goto invalid;
+
+  if (value > GOMP_TASK_DEQUE_SIZE)
+    value = GOMP_TASK_DEQUE_SIZE;
+  gomp_task_cutoff_var = value;
+  gomp_task_cutoff_adaptive = adaptive;
+  return;
+
+ unknown:
+  gomp_error ("Unknown value for environment variable GOMP_TASK_CUTOFF");
+  return;
+
+ invalid:
+  gomp_error ("Invalid value for environment variable GOMP_TASK_CUTOFF");
+}
+
+/* Parse the GOMP_BARRIER environment variable: "auto", "central" or
+   "tree", the latter optionally followed by ",N" to arrive in groups
+   of N threads.  */
+
+static void
+parse_barrier (void)
+{
+  char *env, *end;
+  unsigned long value;
+
+  env = getenv ("GOMP_BARRIER");
+  if (env == NULL)
+    return;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (strncasecmp (env, "auto", 4) == 0)
+    {
+      gomp_barrier_var = GOMP_BARRIER_AUTO;
+      env += 4;
+    }
+  else if (strncasecmp (env, "central", 7) == 0)
+    {
+      gomp_barrier_var = GOMP_BARRIER_CENTRAL;
+      env += 7;
+    }
+  else if (strncasecmp (env, "tree", 4) == 0)
+    {
+      gomp_barrier_var = GOMP_BARRIER_TREE;
+      env += 4;
+      while (isspace ((unsigned char) *env))
+	++env;
+      if (*env == ',')
+	{
+	  ++env;
+	  while (isspace ((unsigned char) *env))
+	    ++env;
+	  if (*env == '\0')
+	    goto invalid;
+
+	  errno = 0;
+	  value = strtoul (env, &end, 10);
+	  if (errno || end == env || value == 0 || value > UINT_MAX)
+	    goto invalid;
+	  gomp_barrier_group_size_var = value;
+	  env = end;
+	}
+    }
+  else
+    goto unknown;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (*env == '\0')
+    return;
+
+ unknown:
+  gomp_barrier_var = GOMP_BARRIER_AUTO;
+  gomp_barrier_group_size_var = 0;
+  gomp_error ("Unknown value for environment variable GOMP_BARRIER");
+  return;
+
+ invalid:
+  gomp_barrier_var = GOMP_BARRIER_AUTO;
+  gomp_barrier_group_size_var = 0;
+  gomp_error ("Invalid value for environment variable GOMP_BARRIER");
+}
+
+/* Parse the GOMP_PROFILE environment variable: report prints the
+   profile report at exit, anything else names a file for the trace as
+   well.  */
+
+static void
+parse_profile (void)
+{
+  const char *env;
+
+  env = getenv ("GOMP_PROFILE");
+  if (env == NULL || *env == '\0')
+    return;
+
+#ifdef LIBGOMP_PROFILE
+  gomp_profile_init (strcasecmp (env, "report") == 0 ? NULL : env);
+#else
+  gomp_error ("GOMP_PROFILE is not supported by this build of libgomp");
+#endif
+}
+
 /* Parse a boolean value for environment variable NAME and store the
    result in VALUE.  */
 
@@ -379,6 +541,90 @@ parse_wait_policy (void)
   return -1;
 }
 
+/* Parse the OMP_PROC_BIND environment variable and return true if it
+   was present and valid.  */
+
+static bool
+parse_proc_bind (void)
+{
+  static const struct
+  {
+    const char *name;
+    enum gomp_bind_kind kind;
+  } kinds[] =
+  {
+    { "false", GOMP_BIND_FALSE },
+    { "true", GOMP_BIND_CLOSE },
+    { "close", GOMP_BIND_CLOSE },
+    { "spread", GOMP_BIND_SPREAD },
+    { "master", GOMP_BIND_MASTER }
+  };
+  const char *env;
+  size_t i, len;
+
+  env = getenv ("OMP_PROC_BIND");
+  if (env == NULL)
+    return false;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  for (i = 0; i < sizeof (kinds) / sizeof (kinds[0]); i++)
+    {
+      len = strlen (kinds[i].name);
+      if (strncasecmp (env, kinds[i].name, len) == 0)
+	{
+	  env += len;
+	  while (isspace ((unsigned char) *env))
+	    ++env;
+	  if (*env != '\0')
+	    break;
+	  gomp_bind_var = kinds[i].kind;
+	  return true;
+	}
+    }
+  gomp_error ("Invalid value for environment variable OMP_PROC_BIND");
+  return false;
+}
+
+/* Parse the OMP_PLACES environment variable: "threads", "cores" or
+   "sockets".  */
+
+static void
+parse_places (void)
+{
+  const char *env;
+
+  env = getenv ("OMP_PLACES");
+  if (env == NULL)
+    return;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (strncasecmp (env, "threads", 7) == 0)
+    {
+      gomp_places_var = GOMP_PLACES_THREADS;
+      env += 7;
+    }
+  else if (strncasecmp (env, "cores", 5) == 0)
+    {
+      gomp_places_var = GOMP_PLACES_CORES;
+      env += 5;
+    }
+  else if (strncasecmp (env, "sockets", 7) == 0)
+    {
+      gomp_places_var = GOMP_PLACES_SOCKETS;
+      env += 7;
+    }
+  else
+    env = "X";
+  while (isspace ((unsigned char) *env))
+    ++env;
+  if (*env == '\0')
+    return;
+  gomp_places_var = GOMP_PLACES_CORES;
+  gomp_error ("Invalid value for environment variable OMP_PLACES");
+}
+
 /* Parse the GOMP_CPU_AFFINITY environment varible.  Return true if one was
    present and it was successfully parsed.  */
 
@@ -475,6 +721,7 @@ initialize_env (void)
 {
   unsigned long stacksize;
   int wait_policy;
+  bool bind_set;
 
   /* Do a compile time check that mkomp_h.pl did good job.  */
   omp_check_defines ();
@@ -495,11 +742,24 @@ initialize_env (void)
   if (!parse_unsigned_long ("OMP_NUM_THREADS", &gomp_global_icv.nthreads_var,
 			    false))
     gomp_global_icv.nthreads_var = gomp_available_cpus;
-  if (parse_affinity ())
+  parse_task_cutoff ();
+  parse_barrier ();
+  parse_unsigned_long ("GOMP_NESTED_POOL_MAX", &gomp_nested_pool_max_var,
+		       true);
+  bind_set = parse_proc_bind ();
+  parse_places ();
+  /* GOMP_CPU_AFFINITY lists the places, and binds threads close to
+     each other by default.  */
+  if (parse_affinity () && !bind_set)
+    gomp_bind_var = GOMP_BIND_CLOSE;
+  if (gomp_bind_var != GOMP_BIND_FALSE)
     gomp_init_affinity ();
   wait_policy = parse_wait_policy ();
   if (!parse_spincount ("GOMP_SPINCOUNT", &gomp_spin_count_var))
     {
+      /* Unless told otherwise, learn how long to spin at each kind of
+	 wait, up to the budget below.  */
+      gomp_spin_adaptive = wait_policy < 0;
       /* Using a rough estimation of 100000 spins per msec,
 	 use 5 min blocking for OMP_WAIT_POLICY=active,
 	 200 msec blocking when OMP_WAIT_POLICY is not specificed
@@ -519,6 +779,8 @@ initialize_env (void)
     gomp_throttled_spin_count_var = 100LL;
   if (gomp_throttled_spin_count_var > gomp_spin_count_var)
     gomp_throttled_spin_count_var = gomp_spin_count_var;
+  parse_boolean ("GOMP_STATS", &gomp_stats_var);
+  parse_profile ();
 
   /* Not strictly environment related, but ordering constructors is tricky.  */
   pthread_attr_init (&gomp_thread_attr);
@@ -615,7 +877,10 @@ void
 omp_get_schedule (omp_sched_t *kind, int *modifier)
 {
   struct gomp_task_icv *icv = gomp_icv (false);
-  *kind = icv->run_sched_var;
+  /* There is no omp_sched_t for the adaptive schedule, which is a flavor
+     of the dynamic one.  */
+  *kind = icv->run_sched_var == GFS_ADAPTIVE
+	  ? omp_sched_dynamic : icv->run_sched_var;
   *modifier = icv->run_sched_modifier;
 }
 
@@ -332,3 +332,141 @@ gomp_iter_guided_next (long *pstart, long *pend)
   return true;
 }
 #endif /* HAVE_SYNC_BUILTINS */
+
+
+/* Set up the per-thread ranges of the work share WS for NTHREADS threads
+   and N iterations in chunks of CHUNK_SIZE.  The chunks are split as
+   schedule(static) would split them, so that a loop whose threads all
+   progress at the same rate never steals.  */
+
+void
+gomp_iter_steal_init (struct gomp_work_share *ws, unsigned nthreads,
+		      unsigned long long n, unsigned long long chunk_size,
+		      bool adaptive)
+{
+  struct gomp_iter_steal *steal;
+  unsigned long long chunks, q, rem, next;
+  unsigned i;
+
+  if (chunk_size == 0)
+    chunk_size = 1;
+  chunks = n / chunk_size + (n % chunk_size != 0);
+  q = chunks / nthreads;
+  rem = chunks % nthreads;
+
+  steal = gomp_malloc (sizeof (*steal) + 63
+		       + nthreads * sizeof (struct gomp_iter_range));
+  steal->chunk_size = chunk_size;
+  steal->n = n;
+  steal->nthreads = nthreads;
+  steal->adaptive = adaptive;
+  steal->ranges = (struct gomp_iter_range *)
+		  (((uintptr_t) (steal + 1) + 63) & ~(uintptr_t) 63);
+
+  next = 0;
+  for (i = 0; i < nthreads; i++)
+    {
+      struct gomp_iter_range *r = &steal->ranges[i];
+
+      gomp_mutex_init (&r->lock);
+      r->next = next;
+      next += q + (i < rem);
+      r->end = next;
+    }
+
+  ws->steal = steal;
+}
+
+void
+gomp_iter_steal_fini (struct gomp_work_share *ws)
+{
+  struct gomp_iter_steal *steal = ws->steal;
+  unsigned i;
+
+  for (i = 0; i < steal->nthreads; i++)
+    gomp_mutex_destroy (&steal->ranges[i].lock);
+  free (steal);
+  ws->steal = NULL;
+}
+
+/* Hand out the next block of the zero-based iterations [*PSTART, *PEND)
+   from the ranges of the current work share.  The thread takes one chunk,
+   or half of what is left for GFS_ADAPTIVE, from its own range; once that
+   is empty it steals the back half of the first non-empty range it finds.
+   Only the owner ever refills a range, so a thread that sees every other
+   range empty may stop: whatever is left is its owners' to do.  */
+
+bool
+gomp_iter_steal_next (unsigned long long *pstart, unsigned long long *pend)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_iter_steal *steal = thr->ts.work_share->steal;
+  unsigned nthreads = steal->nthreads;
+  unsigned id = thr->ts.team_id;
+  struct gomp_iter_range *own = &steal->ranges[id];
+  unsigned long long start, end, take;
+
+  gomp_mutex_lock (&own->lock);
+  while (own->next == own->end)
+    {
+      unsigned i;
+
+      gomp_mutex_unlock (&own->lock);
+      take = end = 0;
+      for (i = 1; i < nthreads; i++)
+	{
+	  struct gomp_iter_range *victim
+	    = &steal->ranges[(id + i) % nthreads];
+
+	  /* An unlocked peek, which at worst skips a range whose owner
+	     is still busy with it.  */
+	  if (victim->next == victim->end)
+	    continue;
+
+	  gomp_mutex_lock (&victim->lock);
+	  take = (victim->end - victim->next + 1) / 2;
+	  victim->end -= take;
+	  end = victim->end + take;
+	  gomp_mutex_unlock (&victim->lock);
+	  if (take)
+	    break;
+	}
+      if (i == nthreads)
+	return false;
+
+      gomp_mutex_lock (&own->lock);
+      own->next = end - take;
+      own->end = end;
+    }
+
+  take = steal->adaptive ? (own->end - own->next + 1) / 2 : 1;
+  start = own->next;
+  own->next = start + take;
+  gomp_mutex_unlock (&own->lock);
+
+  /* The last chunk may be short.  */
+  *pstart = start * steal->chunk_size;
+  if ((steal->n - *pstart) / steal->chunk_size < take)
+    *pend = steal->n;
+  else
+    *pend = *pstart + take * steal->chunk_size;
+  return true;
+}
+
+/* This function implements the ADAPTIVE scheduling method, and the
+   DYNAMIC one where there are no sync builtins.  Arguments are as for
+   gomp_iter_static_next.  */
+
+bool
+gomp_iter_adaptive_next (long *pstart, long *pend)
+{
+  struct gomp_work_share *ws = gomp_thread ()->ts.work_share;
+  unsigned long long s, e;
+
+  if (!gomp_iter_steal_next (&s, &e))
+    return false;
+
+  *pstart = ws->next + (long) s * ws->incr;
+  *pend = ws->next + (long) e * ws->incr;
+  return true;
+}
@@ -174,7 +174,7 @@ gomp_iter_ull_dynamic_next_locked (gomp_ull *pstart, gomp_ull *pend)
 }
 
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
 /* Similar, but doesn't require the lock held, and uses compare-and-swap
    instead.  Note that the only memory value that changes is ws->next_ull.  */
 
@@ -247,7 +247,7 @@ gomp_iter_ull_dynamic_next (gomp_ull *pstart, gomp_ull *pend)
   *pend = nend;
   return true;
 }
-#endif /* HAVE_SYNC_BUILTINS */
+#endif /* HAVE_SYNC_BUILTINS_ULL */
 
 
 /* This function implements the GUIDED scheduling method.  Arguments are
@@ -287,7 +287,7 @@ gomp_iter_ull_guided_next_locked (gomp_ull *pstart, gomp_ull *pend)
   return true;
 }
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
 /* Similar, but doesn't require the lock held, and uses compare-and-swap
    instead.  Note that the only memory value that changes is ws->next_ull.  */
 
@@ -338,4 +338,23 @@ gomp_iter_ull_guided_next (gomp_ull *pstart, gomp_ull *pend)
   *pend = nend;
   return true;
 }
-#endif /* HAVE_SYNC_BUILTINS */
+#endif /* HAVE_SYNC_BUILTINS_ULL */
+
+
+/* This function implements the ADAPTIVE scheduling method, and the
+   DYNAMIC one where there is no 64-bit compare-and-swap.  Arguments are
+   as for gomp_iter_ull_static_next.  */
+
+bool
+gomp_iter_ull_adaptive_next (gomp_ull *pstart, gomp_ull *pend)
+{
+  struct gomp_work_share *ws = gomp_thread ()->ts.work_share;
+  gomp_ull s, e;
+
+  if (!gomp_iter_steal_next (&s, &e))
+    return false;
+
+  *pstart = ws->next_ull + s * ws->incr_ull;
+  *pend = ws->next_ull + e * ws->incr_ull;
+  return true;
+}
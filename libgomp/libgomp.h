@@ -49,6 +49,14 @@
 #include "bar.h"
 #include "ptrlock.h"
 
+/* The unsigned long long loops can use the lock-free iteration paths
+   wherever a 64-bit compare-and-swap is available, which is always
+   the case on LP64 targets with the sync builtins.  */
+#if defined HAVE_SYNC_BUILTINS \
+    && (defined __LP64__ || defined __GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+# define HAVE_SYNC_BUILTINS_ULL 1
+#endif
+
 
 /* This structure contains the data to control one work-sharing construct,
    either a LOOP (FOR/DO) or a SECTIONS.  */
@@ -59,7 +67,48 @@ enum gomp_schedule_type
   GFS_STATIC,
   GFS_DYNAMIC,
   GFS_GUIDED,
-  GFS_AUTO
+  GFS_AUTO,
+  GFS_ADAPTIVE
+};
+
+/* Per-thread iteration ranges for GFS_ADAPTIVE loops, and for dynamic
+   loops on targets without the sync builtins.  The iteration space is
+   cut into chunks which are split statically among the threads up front;
+   a thread takes chunks from its own range and, once that is empty,
+   steals half of what remains in another thread's.  Chunk numbers are
+   zero-based and each range sits in its own cache line.  */
+
+struct gomp_iter_range
+{
+  union {
+    struct {
+      /* This lock protects NEXT and END.  A thread holds at most its own
+	 lock and that of one victim, and never both at once.  */
+      gomp_mutex_t lock;
+
+      /* The chunks [NEXT, END) are still to be handed out.  */
+      unsigned long long next;
+      unsigned long long end;
+    };
+    char pad[64];
+  };
+};
+
+struct gomp_iter_steal
+{
+  /* The number of iterations in a chunk and in the whole loop.  */
+  unsigned long long chunk_size;
+  unsigned long long n;
+
+  /* The number of ranges, one per thread of the team.  */
+  unsigned nthreads;
+
+  /* True for GFS_ADAPTIVE: a thread takes half of its remaining range at
+     once rather than a single chunk.  */
+  bool adaptive;
+
+  /* NTHREADS ranges, aligned to a cache line.  */
+  struct gomp_iter_range *ranges;
 };
 
 struct gomp_work_share
@@ -93,27 +142,25 @@ struct gomp_work_share
     };
   };
 
-  /* This is a circular queue that details which threads will be allowed
-     into the ordered region and in which order.  When a thread allocates
-     iterations on which it is going to work, it also registers itself at
-     the end of the array.  When a thread reaches the ordered region, it
-     checks to see if it is the one at the head of the queue.  If not, it
-     blocks on its RELEASE semaphore.  */
+  /* Each block of iterations of an ordered loop gets a ticket, in the
+     order of the iterations, and the blocks take their turn in the
+     ordered region in the order of the tickets.  This is a ring, indexed
+     by ticket modulo ORDERED_MASK + 1, of the team_id plus one of the
+     thread that has the ticket, 0 if no thread has it yet, or
+     GOMP_ORDERED_DONE if the thread went on without waiting for its
+     turn.  */
   unsigned *ordered_team_ids;
+  unsigned ordered_mask;
 
-  /* This is the number of threads that have registered themselves in
-     the circular queue ordered_team_ids.  */
-  unsigned ordered_num_used;
+  /* This is the ticket whose turn it is.  */
+  unsigned ordered_serving;
 
-  /* This is the team_id of the currently acknowledged owner of the ordered
-     section, or -1u if the ordered section has not been acknowledged by
-     any thread.  This is distinguished from the thread that is *allowed*
-     to take the section next.  */
-  unsigned ordered_owner;
+  /* This is the next ticket for dynamic and guided schedules.  */
+  unsigned ordered_tickets;
 
-  /* This is the index into the circular queue ordered_team_ids of the
-     current thread that's allowed into the ordered reason.  */
-  unsigned ordered_cur;
+  /* True for the structs of the team's ring of work shares that are not
+     in use.  */
+  bool ring_free;
 
   /* This is a chain of allocated gomp_work_share blocks, valid only
      in the first gomp_work_share struct in the block.  */
@@ -154,6 +201,10 @@ struct gomp_work_share
     struct gomp_work_share *next_free;
   };
 
+  /* The per-thread iteration ranges of a GFS_ADAPTIVE loop or of a
+     dynamic loop without the sync builtins, NULL otherwise.  */
+  struct gomp_iter_steal *steal;
+
   /* If only few threads are in the team, ordered_team_ids can point
      to this array which fills the padding at the end of this struct.  */
   unsigned inline_ordered_team_ids[0];
@@ -201,6 +252,30 @@ struct gomp_team_state
      is 1, etc.  This is unused when the compiler knows in advance that
      the loop is statically scheduled.  */
   unsigned long static_trip;
+
+  /* The place partition of the thread: the places the threads of the
+     teams it starts are bound to.  A zero LEN means all places.  */
+  unsigned place_partition_off;
+  unsigned place_partition_len;
+
+  /* In an ordered loop, the ticket of the block of iterations this
+     thread works on and the number of ordered regions it may still run
+     for them.  HELD is true until the thread has passed its turn on,
+     OWNED once it has had its turn.  */
+  unsigned ordered_ticket;
+  unsigned long ordered_left;
+  bool ordered_held;
+  bool ordered_owned;
+
+#ifdef LIBGOMP_PROFILE
+  /* For GOMP_PROFILE, when the thread entered its parallel region and
+     its current work share, and its barrier and task lock wait times
+     when it entered the region.  */
+  unsigned long long prof_start;
+  unsigned long long prof_ws_start;
+  unsigned long long prof_barrier;
+  unsigned long long prof_task_lock;
+#endif
 };
 
 /* These are the OpenMP 3.0 Internal Control Variables described in
@@ -225,7 +300,23 @@ extern gomp_mutex_t gomp_remaining_threads_lock;
 #endif
 extern unsigned long gomp_max_active_levels_var;
 extern unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
+extern bool gomp_spin_adaptive, gomp_stats_var;
 extern unsigned long gomp_available_cpus, gomp_managed_threads;
+extern unsigned long gomp_task_cutoff_var;
+extern bool gomp_task_cutoff_adaptive;
+extern unsigned long gomp_nested_pool_max_var;
+
+/* The kinds of team barriers GOMP_BARRIER selects.  */
+
+enum gomp_barrier_kind
+{
+  GOMP_BARRIER_AUTO,
+  GOMP_BARRIER_CENTRAL,
+  GOMP_BARRIER_TREE
+};
+
+extern enum gomp_barrier_kind gomp_barrier_var;
+extern unsigned long gomp_barrier_group_size_var;
 
 enum gomp_task_kind
 {
@@ -235,23 +326,94 @@ enum gomp_task_kind
   GOMP_TASK_TIED
 };
 
+/* This structure counts the children of a task that have not finished
+   yet, for GOMP_taskwait.  */
+
+struct gomp_task_count
+{
+  /* Twice the number of references to this count: one held by its task
+     until the task finishes, and one by each unfinished child.  Bit 0
+     is set while the task sleeps in GOMP_taskwait.  */
+  int refs;
+  /* The task descriptor to free once the last reference is dropped,
+     or NULL.  */
+  struct gomp_task *mem;
+  gomp_sem_t taskwait_sem;
+};
+
 /* This structure describes a "task" to be run by a thread.  */
 
 struct gomp_task
 {
   struct gomp_task *parent;
-  struct gomp_task *children;
-  struct gomp_task *next_child;
-  struct gomp_task *prev_child;
-  struct gomp_task *next_queue;
-  struct gomp_task *prev_queue;
+  /* The count of the children of this task, or NULL if it has not
+     created any deferred task yet.  */
+  struct gomp_task_count *children;
+  /* The count of the children of the task that created this one, if
+     this task is deferred.  */
+  struct gomp_task_count *parent_children;
+  /* The bottom of the deque of the thread running this task when it
+     started.  The tasks pushed above it are its descendants.  */
+  long deque_mark;
   struct gomp_task_icv icv;
   void (*fn) (void *);
   void *fn_data;
   enum gomp_task_kind kind;
-  bool in_taskwait;
   bool in_tied_task;
-  gomp_sem_t taskwait_sem;
+  /* The size class of a heap task descriptor, GOMP_TASK_SIZE_CLASSES if
+     it is not recycled.  */
+  unsigned char size_class;
+  /* Storage for CHILDREN, unless the task lives on the stack.  */
+  struct gomp_task_count own_children;
+};
+
+/* The number of deferred tasks a deque can hold; a power of two.  A
+   thread whose deque is full runs the tasks it creates immediately.  */
+#define GOMP_TASK_DEQUE_SIZE 256
+
+/* Heap task descriptors are recycled per thread in size classes; class
+   N has room for GOMP_TASK_MIN_ARGS << N bytes of arguments, and each
+   thread keeps at most GOMP_TASK_FREE_MAX free descriptors per class.  */
+#define GOMP_TASK_SIZE_CLASSES 6
+#define GOMP_TASK_MIN_ARGS 32
+#define GOMP_TASK_FREE_MAX 64
+
+/* The adaptive cutoff runs a task immediately, even though its thread
+   has fewer than gomp_task_cutoff_var tasks queued, if at least
+   GOMP_TASK_GRAIN_DEPTH are and the deferred tasks with the same
+   function took less than GOMP_TASK_GRAIN_NS on average.  One in
+   GOMP_TASK_GRAIN_PERIOD deferred tasks a thread runs is timed.  */
+#define GOMP_TASK_GRAIN_DEPTH 2
+#define GOMP_TASK_GRAIN_NS 1000
+#define GOMP_TASK_GRAIN_PERIOD 8
+#define GOMP_TASK_GRAIN_SLOTS 16
+
+/* This structure records the average duration of the deferred tasks
+   with a given function that a thread ran.  */
+
+struct gomp_task_grain
+{
+  void (*fn) (void *);
+  unsigned avg_ns;
+};
+
+/* This structure is the deque of deferred tasks of a team member.  The
+   owner pushes and pops tasks at the bottom, the other members of the
+   team steal them from the top (Chase and Lev, "Dynamic Circular
+   Work-Stealing Deque").  */
+
+struct gomp_task_deque
+{
+  /* Index of the oldest task, the next one to be stolen.  */
+  volatile long top;
+  /* Index one past the newest task.  */
+  volatile long bottom;
+  /* Circular buffer of GOMP_TASK_DEQUE_SIZE tasks, allocated by the
+     first push.  */
+  struct gomp_task **tasks;
+#ifndef HAVE_SYNC_BUILTINS
+  gomp_mutex_t lock;
+#endif
 };
 
 /* This structure describes a "team" of threads.  These are the threads
@@ -267,6 +429,10 @@ struct gomp_team
      as a block last time.  */
   unsigned work_share_chunk;
 
+  /* This is the index in WORK_SHARES of the next work share to try for a
+     new work sharing construct.  */
+  unsigned work_share_ring_next;
+
   /* This is the saved team state that applied to a master thread before
      the current thread was created.  */
   struct gomp_team_state prev_ts;
@@ -305,14 +471,24 @@ struct gomp_team
   /* This barrier is used for most synchronization of the team.  */
   gomp_barrier_t barrier;
 
-  /* Initial work shares, to avoid allocating any gomp_work_share
-     structs in the common case.  */
+  /* A ring of work shares which new work sharing constructs take in
+     turn, to avoid allocating any gomp_work_share structs or taking any
+     locks in the common case.  Only when a thread runs so far ahead of
+     the others that the next one is still in use do they come from
+     WORK_SHARE_LIST_ALLOC, WORK_SHARE_LIST_FREE or malloc.  */
   struct gomp_work_share work_shares[8];
 
+  /* Protects the task state bits of BARRIER.  */
   gomp_mutex_t task_lock;
-  struct gomp_task *task_queue;
+  /* The number of deferred tasks that have not finished yet.  */
   int task_count;
-  int task_running_count;
+  /* Array of the task deques of the threads, indexed by team_id.  */
+  struct gomp_task_deque *task_deques;
+
+#ifdef LIBGOMP_PROFILE
+  /* The GOMP_PROFILE data of the region, or NULL if not profiling.  */
+  struct gomp_team_profile *prof;
+#endif
 
   /* This array contains structures for implicit tasks.  */
   struct gomp_task implicit_task[];
@@ -339,6 +515,23 @@ struct gomp_thread
 
   /* user pthread thread pool */
   struct gomp_thread_pool *thread_pool;
+
+  /* The place the thread is bound to, plus one; 0 if unbound.  */
+  unsigned int place;
+
+  /* Free heap task descriptors by size class, chained through their
+     PARENT fields.  */
+  struct gomp_task *task_free_list[GOMP_TASK_SIZE_CLASSES];
+  unsigned task_free_count[GOMP_TASK_SIZE_CLASSES];
+
+  /* Task durations for the adaptive cutoff, hashed by function.  */
+  struct gomp_task_grain task_grain[GOMP_TASK_GRAIN_SLOTS];
+  unsigned task_grain_tick;
+
+#ifdef LIBGOMP_PROFILE
+  /* The GOMP_PROFILE data of the thread, allocated on its first event.  */
+  struct gomp_profile *prof;
+#endif
 };
 
 
@@ -394,12 +587,36 @@ extern pthread_attr_t gomp_thread_attr;
 extern unsigned short *gomp_cpu_affinity;
 extern size_t gomp_cpu_affinity_len;
 
+/* The thread binding policies of OMP_PROC_BIND.  */
+
+enum gomp_bind_kind
+{
+  GOMP_BIND_FALSE,
+  GOMP_BIND_CLOSE,
+  GOMP_BIND_SPREAD,
+  GOMP_BIND_MASTER
+};
+
+/* The kinds of places of OMP_PLACES.  */
+
+enum gomp_places_kind
+{
+  GOMP_PLACES_CORES,
+  GOMP_PLACES_THREADS,
+  GOMP_PLACES_SOCKETS
+};
+
+extern enum gomp_bind_kind gomp_bind_var;
+extern enum gomp_places_kind gomp_places_var;
+extern unsigned long gomp_places_list_len;
+
 /* Function prototypes.  */
 
 /* affinity.c */
 
 extern void gomp_init_affinity (void);
-extern void gomp_init_thread_affinity (pthread_attr_t *);
+extern void gomp_init_thread_affinity (pthread_attr_t *, unsigned int);
+extern void gomp_bind_thread (unsigned int);
 
 /* alloc.c */
 
@@ -423,6 +640,13 @@ extern void gomp_fatal (const char *, ...)
 extern int gomp_iter_static_next (long *, long *);
 extern bool gomp_iter_dynamic_next_locked (long *, long *);
 extern bool gomp_iter_guided_next_locked (long *, long *);
+extern void gomp_iter_steal_init (struct gomp_work_share *, unsigned,
+				  unsigned long long, unsigned long long,
+				  bool);
+extern void gomp_iter_steal_fini (struct gomp_work_share *);
+extern bool gomp_iter_steal_next (unsigned long long *,
+				  unsigned long long *);
+extern bool gomp_iter_adaptive_next (long *, long *);
 
 #ifdef HAVE_SYNC_BUILTINS
 extern bool gomp_iter_dynamic_next (long *, long *);
@@ -437,8 +661,10 @@ extern bool gomp_iter_ull_dynamic_next_locked (unsigned long long *,
 					       unsigned long long *);
 extern bool gomp_iter_ull_guided_next_locked (unsigned long long *,
 					      unsigned long long *);
+extern bool gomp_iter_ull_adaptive_next (unsigned long long *,
+					 unsigned long long *);
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
 extern bool gomp_iter_ull_dynamic_next (unsigned long long *,
 					unsigned long long *);
 extern bool gomp_iter_ull_guided_next (unsigned long long *,
@@ -447,11 +673,9 @@ extern bool gomp_iter_ull_guided_next (unsigned long long *,
 
 /* ordered.c */
 
-extern void gomp_ordered_first (void);
+extern void gomp_ordered_first (unsigned long);
+extern void gomp_ordered_static_first (unsigned, unsigned long);
 extern void gomp_ordered_last (void);
-extern void gomp_ordered_next (void);
-extern void gomp_ordered_static_init (void);
-extern void gomp_ordered_static_next (void);
 extern void gomp_ordered_sync (void);
 
 /* parallel.c */
@@ -469,11 +693,18 @@ extern void gomp_init_task (struct gomp_task *, struct gomp_task *,
 			    struct gomp_task_icv *);
 extern void gomp_end_task (void);
 extern void gomp_barrier_handle_tasks (gomp_barrier_state_t);
+extern void gomp_release_task_count (struct gomp_task_count *);
+extern void gomp_free_task (struct gomp_task *);
+extern void gomp_free_thread_tasks (struct gomp_thread *);
+
+/* Drop the reference TASK holds to the count of its children.  This may
+   free TASK itself, if it was allocated on the heap.  */
 
 static void inline
 gomp_finish_task (struct gomp_task *task)
 {
-  gomp_sem_destroy (&task->taskwait_sem);
+  if (task->children)
+    gomp_release_task_count (task->children);
 }
 
 /* team.c */
@@ -483,6 +714,119 @@ extern void gomp_team_start (void (*) (void *), void *, unsigned,
 			     struct gomp_team *);
 extern void gomp_team_end (void);
 
+/* time.c (in config/) */
+
+extern unsigned long long gomp_clock_ns (void);
+
+/* profile.c */
+
+/* The kinds of events GOMP_PROFILE times.  */
+
+enum gomp_profile_kind
+{
+  GOMP_PROFILE_PARALLEL,
+  GOMP_PROFILE_WORK_SHARE,
+  GOMP_PROFILE_BARRIER,
+  GOMP_PROFILE_TASK,
+  GOMP_PROFILE_TASK_LOCK,
+  GOMP_PROFILE_KINDS
+};
+
+/* A wait being timed: when it started, 0 if not profiling, and the time
+   the thread had spent running tasks by then.  */
+
+struct gomp_profile_wait
+{
+  unsigned long long start;
+  unsigned long long task;
+};
+
+#ifdef LIBGOMP_PROFILE
+/* An event in the trace buffer of a thread.  ID is the function of the
+   parallel region or task.  */
+
+struct gomp_profile_event
+{
+  unsigned long long start;
+  unsigned long long end;
+  void *id;
+  enum gomp_profile_kind kind;
+};
+
+/* The GOMP_PROFILE data of a thread.  The data of all threads ever
+   created are chained through NEXT, and taken over by new threads once
+   the thread that had them exits.  */
+
+struct gomp_profile
+{
+  struct gomp_profile *next;
+  bool idle;
+
+  /* The number of the thread in the trace.  */
+  unsigned serial;
+
+  /* The number of events of each kind and their total time.  */
+  unsigned long count[GOMP_PROFILE_KINDS];
+  unsigned long long time[GOMP_PROFILE_KINDS];
+
+  /* The events not yet written to the trace file, NULL if there is no
+     trace file.  */
+  struct gomp_profile_event *events;
+  unsigned nevents;
+};
+
+extern bool gomp_profile_var;
+
+extern void gomp_profile_init (const char *);
+extern struct gomp_profile *gomp_profile_new_thread (struct gomp_thread *);
+extern void gomp_profile_thread_end (struct gomp_thread *);
+extern void gomp_profile_task (struct gomp_thread *, unsigned long long,
+			       void *);
+extern void gomp_profile_wait_end_1 (struct gomp_profile_wait *,
+				     enum gomp_profile_kind);
+extern void gomp_profile_team_start (struct gomp_team *, void (*) (void *));
+extern void gomp_profile_team_end (struct gomp_team *);
+extern void gomp_profile_region_enter (struct gomp_thread *);
+extern void gomp_profile_region_exit (struct gomp_thread *);
+extern void gomp_profile_work_share_end (struct gomp_thread *);
+
+static inline struct gomp_profile *
+gomp_profile_thread (struct gomp_thread *thr)
+{
+  if (__builtin_expect (thr->prof == NULL, 0))
+    return gomp_profile_new_thread (thr);
+  return thr->prof;
+}
+#endif
+
+/* Time a wait of the current thread for GOMP_PROFILE, not counting the
+   tasks it runs meanwhile.  */
+
+static inline void
+gomp_profile_wait_start (struct gomp_profile_wait *w)
+{
+  w->start = 0;
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (gomp_profile_var, 0))
+    {
+      struct gomp_profile *prof = gomp_profile_thread (gomp_thread ());
+
+      w->task = prof->time[GOMP_PROFILE_TASK];
+      w->start = gomp_clock_ns ();
+    }
+#endif
+}
+
+static inline void
+gomp_profile_wait_end (struct gomp_profile_wait *w,
+		       enum gomp_profile_kind kind)
+{
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (w->start != 0, 0))
+    gomp_profile_wait_end_1 (w, kind);
+#endif
+}
+
 /* work.c */
 
 extern void gomp_init_work_share (struct gomp_work_share *, bool, unsigned);
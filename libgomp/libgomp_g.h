@@ -42,6 +42,8 @@ extern void GOMP_critical_name_start (void **);
 extern void GOMP_critical_name_end (void **);
 extern void GOMP_atomic_start (void);
 extern void GOMP_atomic_end (void);
+extern void GOMP_atomic_addr_start (void *);
+extern void GOMP_atomic_addr_end (void *);
 
 /* loop.c */
 
@@ -77,6 +77,21 @@ gomp_loop_init (struct gomp_work_share *ws, long start, long end, long incr,
     }
 }
 
+/* Split the iterations of the loop just set up in WS into per-thread
+   ranges for NTHREADS threads, for GFS_ADAPTIVE or, if ADAPTIVE is
+   false, for a GFS_DYNAMIC loop on a target without the sync builtins.  */
+
+static void
+gomp_loop_steal_init (struct gomp_work_share *ws, unsigned nthreads,
+		      long chunk_size, bool adaptive)
+{
+  long s = ws->incr + (ws->incr > 0 ? -1 : 1);
+  unsigned long n = (ws->end - ws->next + s) / ws->incr;
+
+  gomp_iter_steal_init (ws, nthreads, n, chunk_size > 0 ? chunk_size : 1,
+			adaptive);
+}
+
 /* The *_start routines are called when first encountering a loop construct
    that is not bound directly to a parallel construct.  The first thread 
    that arrives will create the work-share construct; subsequent threads
@@ -121,15 +136,18 @@ gomp_loop_dynamic_start (long start, long end, long incr, long chunk_size,
     {
       gomp_loop_init (thr->ts.work_share, start, end, incr,
 		      GFS_DYNAMIC, chunk_size);
+#ifndef HAVE_SYNC_BUILTINS
+      gomp_loop_steal_init (thr->ts.work_share,
+			    thr->ts.team ? thr->ts.team->nthreads : 1,
+			    chunk_size, false);
+#endif
       gomp_work_share_init_done ();
     }
 
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_dynamic_next (istart, iend);
 #else
-  gomp_mutex_lock (&thr->ts.work_share->lock);
-  ret = gomp_iter_dynamic_next_locked (istart, iend);
-  gomp_mutex_unlock (&thr->ts.work_share->lock);
+  ret = gomp_iter_adaptive_next (istart, iend);
 #endif
 
   return ret;
@@ -160,6 +178,29 @@ gomp_loop_guided_start (long start, long end, long incr, long chunk_size,
   return ret;
 }
 
+/* GFS_ADAPTIVE loops start out as schedule(static) would, each thread
+   working through its own share, and even out by stealing.  The
+   compiler never emits them, so only the runtime schedule gets here.  */
+
+static bool
+gomp_loop_adaptive_start (long start, long end, long incr, long chunk_size,
+			  long *istart, long *iend)
+{
+  struct gomp_thread *thr = gomp_thread ();
+
+  if (gomp_work_share_start (false))
+    {
+      gomp_loop_init (thr->ts.work_share, start, end, incr,
+		      GFS_ADAPTIVE, chunk_size);
+      gomp_loop_steal_init (thr->ts.work_share,
+			    thr->ts.team ? thr->ts.team->nthreads : 1,
+			    chunk_size, true);
+      gomp_work_share_init_done ();
+    }
+
+  return gomp_iter_adaptive_next (istart, iend);
+}
+
 bool
 GOMP_loop_runtime_start (long start, long end, long incr,
 			 long *istart, long *iend)
@@ -180,6 +221,10 @@ GOMP_loop_runtime_start (long start, long end, long incr,
       /* For now map to schedule(static), later on we could play with feedback
 	 driven choice.  */
       return gomp_loop_static_start (start, end, incr, 0, istart, iend);
+    case GFS_ADAPTIVE:
+      return gomp_loop_adaptive_start (start, end, incr,
+				       icv->run_sched_modifier,
+				       istart, iend);
     default:
       abort ();
     }
@@ -188,22 +233,53 @@ GOMP_loop_runtime_start (long start, long end, long incr,
 /* The *_ordered_*_start routines are similar.  The only difference is that
    this work-share construct is initialized to expect an ORDERED section.  */
 
+/* Return the number of iterations in [START, END) of the loop of WS.  */
+
+static inline unsigned long
+gomp_loop_count (struct gomp_work_share *ws, long start, long end)
+{
+  long s = ws->incr + (ws->incr > 0 ? -1 : 1);
+
+  return (end - start + s) / ws->incr;
+}
+
+/* Give the current thread the ticket for its block [START, END) of a
+   static loop, the number of the block in the loop.  */
+
+static void
+gomp_loop_ordered_static_first (long start, long end)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_work_share *ws = thr->ts.work_share;
+  unsigned ticket = thr->ts.team_id;
+
+  if (ws->chunk_size)
+    ticket = gomp_loop_count (ws, ws->next, start) / ws->chunk_size;
+  gomp_ordered_static_first (ticket, gomp_loop_count (ws, start, end));
+}
+
 static bool
 gomp_loop_ordered_static_start (long start, long end, long incr,
 				long chunk_size, long *istart, long *iend)
 {
   struct gomp_thread *thr = gomp_thread ();
+  int test;
 
   thr->ts.static_trip = 0;
   if (gomp_work_share_start (true))
     {
       gomp_loop_init (thr->ts.work_share, start, end, incr,
 		      GFS_STATIC, chunk_size);
-      gomp_ordered_static_init ();
       gomp_work_share_init_done ();
     }
 
-  return !gomp_iter_static_next (istart, iend);
+  gomp_mutex_lock (&thr->ts.work_share->lock);
+  test = gomp_iter_static_next (istart, iend);
+  if (test == 0)
+    gomp_loop_ordered_static_first (*istart, *iend);
+  gomp_mutex_unlock (&thr->ts.work_share->lock);
+
+  return test == 0;
 }
 
 static bool
@@ -225,7 +301,7 @@ gomp_loop_ordered_dynamic_start (long start, long end, long incr,
 
   ret = gomp_iter_dynamic_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_first ();
+    gomp_ordered_first (gomp_loop_count (thr->ts.work_share, *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -250,7 +326,7 @@ gomp_loop_ordered_guided_start (long start, long end, long incr,
 
   ret = gomp_iter_guided_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_first ();
+    gomp_ordered_first (gomp_loop_count (thr->ts.work_share, *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -280,6 +356,12 @@ GOMP_loop_ordered_runtime_start (long start, long end, long incr,
 	 driven choice.  */
       return gomp_loop_ordered_static_start (start, end, incr,
 					     0, istart, iend);
+    case GFS_ADAPTIVE:
+      /* Stealing buys nothing when the chunks have to be entered in
+	 order anyway.  */
+      return gomp_loop_ordered_dynamic_start (start, end, incr,
+					      icv->run_sched_modifier,
+					      istart, iend);
     default:
       abort ();
     }
@@ -309,10 +391,7 @@ gomp_loop_dynamic_next (long *istart, long *iend)
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_dynamic_next (istart, iend);
 #else
-  struct gomp_thread *thr = gomp_thread ();
-  gomp_mutex_lock (&thr->ts.work_share->lock);
-  ret = gomp_iter_dynamic_next_locked (istart, iend);
-  gomp_mutex_unlock (&thr->ts.work_share->lock);
+  ret = gomp_iter_adaptive_next (istart, iend);
 #endif
 
   return ret;
@@ -349,6 +428,8 @@ GOMP_loop_runtime_next (long *istart, long *iend)
       return gomp_loop_dynamic_next (istart, iend);
     case GFS_GUIDED:
       return gomp_loop_guided_next (istart, iend);
+    case GFS_ADAPTIVE:
+      return gomp_iter_adaptive_next (istart, iend);
     default:
       abort ();
     }
@@ -367,11 +448,11 @@ gomp_loop_ordered_static_next (long *istart, long *iend)
   struct gomp_thread *thr = gomp_thread ();
   int test;
 
-  gomp_ordered_sync ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_ordered_last ();
   test = gomp_iter_static_next (istart, iend);
-  if (test >= 0)
-    gomp_ordered_static_next ();
+  if (test == 0)
+    gomp_loop_ordered_static_first (*istart, *iend);
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return test == 0;
@@ -383,13 +464,11 @@ gomp_loop_ordered_dynamic_next (long *istart, long *iend)
   struct gomp_thread *thr = gomp_thread ();
   bool ret;
 
-  gomp_ordered_sync ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_ordered_last ();
   ret = gomp_iter_dynamic_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_next ();
-  else
-    gomp_ordered_last ();
+    gomp_ordered_first (gomp_loop_count (thr->ts.work_share, *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -401,13 +480,11 @@ gomp_loop_ordered_guided_next (long *istart, long *iend)
   struct gomp_thread *thr = gomp_thread ();
   bool ret;
 
-  gomp_ordered_sync ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_ordered_last ();
   ret = gomp_iter_guided_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_next ();
-  else
-    gomp_ordered_last ();
+    gomp_ordered_first (gomp_loop_count (thr->ts.work_share, *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -446,6 +523,13 @@ gomp_parallel_loop_start (void (*fn) (void *), void *data,
   num_threads = gomp_resolve_num_threads (num_threads, 0);
   team = gomp_new_team (num_threads);
   gomp_loop_init (&team->work_shares[0], start, end, incr, sched, chunk_size);
+#ifdef HAVE_SYNC_BUILTINS
+  if (sched == GFS_ADAPTIVE)
+#else
+  if (sched == GFS_ADAPTIVE || sched == GFS_DYNAMIC)
+#endif
+    gomp_loop_steal_init (&team->work_shares[0], num_threads, chunk_size,
+			  sched == GFS_ADAPTIVE);
   gomp_team_start (fn, data, num_threads, team);
 }
 
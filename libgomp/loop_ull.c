@@ -49,7 +49,7 @@ gomp_loop_ull_init (struct gomp_work_share *ws, bool up, gomp_ull start,
     {
       ws->chunk_size_ull *= incr;
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
       {
 	/* For dynamic scheduling prepare things to make each iteration
 	   faster.  */
@@ -79,6 +79,25 @@ gomp_loop_ull_init (struct gomp_work_share *ws, bool up, gomp_ull start,
     ws->mode |= 2;
 }
 
+/* Split the iterations of the loop just set up in WS into per-thread
+   ranges, as gomp_loop_steal_init does for the long loops.  */
+
+static void
+gomp_loop_ull_steal_init (struct gomp_work_share *ws, gomp_ull chunk_size,
+			  bool adaptive)
+{
+  struct gomp_team *team = gomp_thread ()->ts.team;
+  gomp_ull n;
+
+  if ((ws->mode & 2) == 0)
+    n = (ws->end_ull - ws->next_ull + ws->incr_ull - 1) / ws->incr_ull;
+  else
+    n = (ws->next_ull - ws->end_ull - ws->incr_ull - 1) / -ws->incr_ull;
+
+  gomp_iter_steal_init (ws, team ? team->nthreads : 1, n,
+			chunk_size ? chunk_size : 1, adaptive);
+}
+
 /* The *_start routines are called when first encountering a loop construct
    that is not bound directly to a parallel construct.  The first thread
    that arrives will create the work-share construct; subsequent threads
@@ -125,15 +144,16 @@ gomp_loop_ull_dynamic_start (bool up, gomp_ull start, gomp_ull end,
     {
       gomp_loop_ull_init (thr->ts.work_share, up, start, end, incr,
 			  GFS_DYNAMIC, chunk_size);
+#ifndef HAVE_SYNC_BUILTINS_ULL
+      gomp_loop_ull_steal_init (thr->ts.work_share, chunk_size, false);
+#endif
       gomp_work_share_init_done ();
     }
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
   ret = gomp_iter_ull_dynamic_next (istart, iend);
 #else
-  gomp_mutex_lock (&thr->ts.work_share->lock);
-  ret = gomp_iter_ull_dynamic_next_locked (istart, iend);
-  gomp_mutex_unlock (&thr->ts.work_share->lock);
+  ret = gomp_iter_ull_adaptive_next (istart, iend);
 #endif
 
   return ret;
@@ -154,7 +174,7 @@ gomp_loop_ull_guided_start (bool up, gomp_ull start, gomp_ull end,
       gomp_work_share_init_done ();
     }
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
   ret = gomp_iter_ull_guided_next (istart, iend);
 #else
   gomp_mutex_lock (&thr->ts.work_share->lock);
@@ -165,6 +185,24 @@ gomp_loop_ull_guided_start (bool up, gomp_ull start, gomp_ull end,
   return ret;
 }
 
+static bool
+gomp_loop_ull_adaptive_start (bool up, gomp_ull start, gomp_ull end,
+			      gomp_ull incr, gomp_ull chunk_size,
+			      gomp_ull *istart, gomp_ull *iend)
+{
+  struct gomp_thread *thr = gomp_thread ();
+
+  if (gomp_work_share_start (false))
+    {
+      gomp_loop_ull_init (thr->ts.work_share, up, start, end, incr,
+			  GFS_ADAPTIVE, chunk_size);
+      gomp_loop_ull_steal_init (thr->ts.work_share, chunk_size, true);
+      gomp_work_share_init_done ();
+    }
+
+  return gomp_iter_ull_adaptive_next (istart, iend);
+}
+
 bool
 GOMP_loop_ull_runtime_start (bool up, gomp_ull start, gomp_ull end,
 			     gomp_ull incr, gomp_ull *istart, gomp_ull *iend)
@@ -189,6 +227,10 @@ GOMP_loop_ull_runtime_start (bool up, gomp_ull start, gomp_ull end,
 	 driven choice.  */
       return gomp_loop_ull_static_start (up, start, end, incr,
 					 0, istart, iend);
+    case GFS_ADAPTIVE:
+      return gomp_loop_ull_adaptive_start (up, start, end, incr,
+					   icv->run_sched_modifier,
+					   istart, iend);
     default:
       abort ();
     }
@@ -197,23 +239,60 @@ GOMP_loop_ull_runtime_start (bool up, gomp_ull start, gomp_ull end,
 /* The *_ordered_*_start routines are similar.  The only difference is that
    this work-share construct is initialized to expect an ORDERED section.  */
 
+/* Return the number of iterations in [START, END) of the loop of WS, or
+   ULONG_MAX if there are more than that.  */
+
+static inline unsigned long
+gomp_loop_ull_count (struct gomp_work_share *ws, gomp_ull start, gomp_ull end)
+{
+  gomp_ull n;
+
+  if ((ws->mode & 2) == 0)
+    n = (end - start + ws->incr_ull - 1) / ws->incr_ull;
+  else
+    n = (start - end - ws->incr_ull - 1) / -ws->incr_ull;
+  return n > ULONG_MAX ? ULONG_MAX : n;
+}
+
+/* Give the current thread the ticket for its block [START, END) of a
+   static loop, the number of the block in the loop.  */
+
+static void
+gomp_loop_ull_ordered_static_first (gomp_ull start, gomp_ull end)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_work_share *ws = thr->ts.work_share;
+  unsigned ticket = thr->ts.team_id;
+
+  if (ws->chunk_size_ull)
+    ticket = gomp_loop_ull_count (ws, ws->next_ull, start)
+	     / ws->chunk_size_ull;
+  gomp_ordered_static_first (ticket, gomp_loop_ull_count (ws, start, end));
+}
+
 static bool
 gomp_loop_ull_ordered_static_start (bool up, gomp_ull start, gomp_ull end,
 				    gomp_ull incr, gomp_ull chunk_size,
 				    gomp_ull *istart, gomp_ull *iend)
 {
   struct gomp_thread *thr = gomp_thread ();
+  int test;
 
   thr->ts.static_trip = 0;
   if (gomp_work_share_start (true))
     {
       gomp_loop_ull_init (thr->ts.work_share, up, start, end, incr,
 			  GFS_STATIC, chunk_size);
-      gomp_ordered_static_init ();
       gomp_work_share_init_done ();
     }
 
-  return !gomp_iter_ull_static_next (istart, iend);
+  gomp_mutex_lock (&thr->ts.work_share->lock);
+  test = gomp_iter_ull_static_next (istart, iend);
+  if (test == 0)
+    gomp_loop_ull_ordered_static_first (*istart, *iend);
+  gomp_mutex_unlock (&thr->ts.work_share->lock);
+
+  return test == 0;
 }
 
 static bool
@@ -236,7 +315,8 @@ gomp_loop_ull_ordered_dynamic_start (bool up, gomp_ull start, gomp_ull end,
 
   ret = gomp_iter_ull_dynamic_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_first ();
+    gomp_ordered_first (gomp_loop_ull_count (thr->ts.work_share,
+					     *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -262,7 +342,8 @@ gomp_loop_ull_ordered_guided_start (bool up, gomp_ull start, gomp_ull end,
 
   ret = gomp_iter_ull_guided_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_first ();
+    gomp_ordered_first (gomp_loop_ull_count (thr->ts.work_share,
+					     *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -293,6 +374,12 @@ GOMP_loop_ull_ordered_runtime_start (bool up, gomp_ull start, gomp_ull end,
 	 driven choice.  */
       return gomp_loop_ull_ordered_static_start (up, start, end, incr,
 						 0, istart, iend);
+    case GFS_ADAPTIVE:
+      /* Stealing buys nothing when the chunks have to be entered in
+	 order anyway.  */
+      return gomp_loop_ull_ordered_dynamic_start (up, start, end, incr,
+						  icv->run_sched_modifier,
+						  istart, iend);
     default:
       abort ();
     }
@@ -319,13 +406,10 @@ gomp_loop_ull_dynamic_next (gomp_ull *istart, gomp_ull *iend)
 {
   bool ret;
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
   ret = gomp_iter_ull_dynamic_next (istart, iend);
 #else
-  struct gomp_thread *thr = gomp_thread ();
-  gomp_mutex_lock (&thr->ts.work_share->lock);
-  ret = gomp_iter_ull_dynamic_next_locked (istart, iend);
-  gomp_mutex_unlock (&thr->ts.work_share->lock);
+  ret = gomp_iter_ull_adaptive_next (istart, iend);
 #endif
 
   return ret;
@@ -336,7 +420,7 @@ gomp_loop_ull_guided_next (gomp_ull *istart, gomp_ull *iend)
 {
   bool ret;
 
-#if defined HAVE_SYNC_BUILTINS && defined __LP64__
+#ifdef HAVE_SYNC_BUILTINS_ULL
   ret = gomp_iter_ull_guided_next (istart, iend);
 #else
   struct gomp_thread *thr = gomp_thread ();
@@ -362,6 +446,8 @@ GOMP_loop_ull_runtime_next (gomp_ull *istart, gomp_ull *iend)
       return gomp_loop_ull_dynamic_next (istart, iend);
     case GFS_GUIDED:
       return gomp_loop_ull_guided_next (istart, iend);
+    case GFS_ADAPTIVE:
+      return gomp_iter_ull_adaptive_next (istart, iend);
     default:
       abort ();
     }
@@ -380,11 +466,11 @@ gomp_loop_ull_ordered_static_next (gomp_ull *istart, gomp_ull *iend)
   struct gomp_thread *thr = gomp_thread ();
   int test;
 
-  gomp_ordered_sync ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_ordered_last ();
   test = gomp_iter_ull_static_next (istart, iend);
-  if (test >= 0)
-    gomp_ordered_static_next ();
+  if (test == 0)
+    gomp_loop_ull_ordered_static_first (*istart, *iend);
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return test == 0;
@@ -396,13 +482,12 @@ gomp_loop_ull_ordered_dynamic_next (gomp_ull *istart, gomp_ull *iend)
   struct gomp_thread *thr = gomp_thread ();
   bool ret;
 
-  gomp_ordered_sync ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_ordered_last ();
   ret = gomp_iter_ull_dynamic_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_next ();
-  else
-    gomp_ordered_last ();
+    gomp_ordered_first (gomp_loop_ull_count (thr->ts.work_share,
+					     *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -414,13 +499,12 @@ gomp_loop_ull_ordered_guided_next (gomp_ull *istart, gomp_ull *iend)
   struct gomp_thread *thr = gomp_thread ();
   bool ret;
 
-  gomp_ordered_sync ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
+  gomp_ordered_last ();
   ret = gomp_iter_ull_guided_next_locked (istart, iend);
   if (ret)
-    gomp_ordered_next ();
-  else
-    gomp_ordered_last ();
+    gomp_ordered_first (gomp_loop_ull_count (thr->ts.work_share,
+					     *istart, *iend));
   gomp_mutex_unlock (&thr->ts.work_share->lock);
 
   return ret;
@@ -27,126 +27,83 @@
 #include "libgomp.h"
 
 
-/* This function is called when first allocating an iteration block.  That
-   is, the thread is not currently on the queue.  The work-share lock must
-   be held on entry.  */
-
-void
-gomp_ordered_first (void)
+/* Each block of iterations a thread gets from an ordered loop comes with
+   a ticket, and the ticket ws->ordered_serving may run its ordered
+   regions.  A thread learns that it is its turn by a post to its release
+   semaphore, made by whoever moves ordered_serving to its ticket.  Once
+   a block has run as many ordered regions as it has iterations, its
+   thread passes the turn on right away.  A thread done with a block
+   whose turn has not come yet leaves the ticket marked GOMP_ORDERED_DONE
+   so that the turn skips it, and goes on with its next block; that is
+   how threads run ahead.  The ring ws->ordered_team_ids has room for one
+   ticket per thread and for as many done tickets as there are threads,
+   so a thread that would get further ahead than that waits for its turn
+   instead.  */
+
+#define GOMP_ORDERED_DONE (~0U)
+
+/* Pass the turn on to the next ticket not marked done, and wake its
+   thread if it has one yet.  The work-share lock must be held.  */
+
+static void
+gomp_ordered_advance (struct gomp_team *team, struct gomp_work_share *ws)
 {
-  struct gomp_thread *thr = gomp_thread ();
-  struct gomp_team *team = thr->ts.team;
-  struct gomp_work_share *ws = thr->ts.work_share;
-  unsigned index;
-
-  /* Work share constructs can be orphaned.  */
-  if (team == NULL || team->nthreads == 1)
-    return;
-
-  index = ws->ordered_cur + ws->ordered_num_used;
-  if (index >= team->nthreads)
-    index -= team->nthreads;
-  ws->ordered_team_ids[index] = thr->ts.team_id;
-
-  /* If this is the first and only thread in the queue, then there is
-     no one to release us when we get to our ordered section.  Post to
-     our own release queue now so that we won't block later.  */
-  if (ws->ordered_num_used++ == 0)
-    gomp_sem_post (team->ordered_release[thr->ts.team_id]);
+  unsigned *ids = ws->ordered_team_ids;
+  unsigned mask = ws->ordered_mask;
+  unsigned t = ws->ordered_serving;
+  unsigned id;
+
+  ids[t & mask] = 0;
+  while ((id = ids[++t & mask]) == GOMP_ORDERED_DONE)
+    ids[t & mask] = 0;
+  ws->ordered_serving = t;
+  if (id != 0)
+    gomp_sem_post (team->ordered_release[id - 1]);
 }
 
-/* This function is called when completing the last iteration block.  That
-   is, there are no more iterations to perform and so the thread should be
-   removed from the queue entirely.  Because of the way ORDERED blocks are
-   managed, it follows that we currently own access to the ORDERED block,
-   and should now pass it on to the next thread.  The work-share lock must
-   be held on entry.  */
+/* Give the current thread TICKET for a block of COUNT iterations.  The
+   work-share lock must be held.  */
 
-void
-gomp_ordered_last (void)
+static void
+gomp_ordered_take (struct gomp_thread *thr, unsigned ticket,
+		   unsigned long count)
 {
-  struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
   struct gomp_work_share *ws = thr->ts.work_share;
-  unsigned next_id;
-
-  /* Work share constructs can be orphaned.  */
-  if (team == NULL || team->nthreads == 1)
-    return;
 
-  /* We're no longer the owner.  */
-  ws->ordered_owner = -1;
+  thr->ts.ordered_ticket = ticket;
+  thr->ts.ordered_left = count;
+  thr->ts.ordered_held = true;
+  thr->ts.ordered_owned = false;
+  ws->ordered_team_ids[ticket & ws->ordered_mask] = thr->ts.team_id + 1;
 
-  /* If we're not the last thread in the queue, then wake the next.  */
-  if (--ws->ordered_num_used > 0)
-    {
-      unsigned next = ws->ordered_cur + 1;
-      if (next == team->nthreads)
-	next = 0;
-      ws->ordered_cur = next;
-
-      next_id = ws->ordered_team_ids[next];
-      gomp_sem_post (team->ordered_release[next_id]);
-    }
+  /* Nobody else will tell us that it is our turn already.  */
+  if (ticket == ws->ordered_serving)
+    gomp_sem_post (team->ordered_release[thr->ts.team_id]);
 }
 
-
-/* This function is called when allocating a subsequent allocation block.
-   That is, we're done with the current iteration block and we're allocating
-   another.  This is the logical combination of a call to gomp_ordered_last
-   followed by a call to gomp_ordered_first.  The work-share lock must be
-   held on entry. */
+/* This function is called when a dynamic or guided loop hands out a
+   block of COUNT iterations, which gets the next ticket.  The work-share
+   lock must be held on entry.  */
 
 void
-gomp_ordered_next (void)
+gomp_ordered_first (unsigned long count)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
-  struct gomp_work_share *ws = thr->ts.work_share;
-  unsigned index, next_id;
 
   /* Work share constructs can be orphaned.  */
   if (team == NULL || team->nthreads == 1)
     return;
 
-  /* We're no longer the owner.  */
-  ws->ordered_owner = -1;
-
-  /* If there's only one thread in the queue, that must be us.  */
-  if (ws->ordered_num_used == 1)
-    {
-      /* We have a similar situation as in gomp_ordered_first
-	 where we need to post to our own release semaphore.  */
-      gomp_sem_post (team->ordered_release[thr->ts.team_id]);
-      return;
-    }
-
-  /* If the queue is entirely full, then we move ourself to the end of 
-     the queue merely by incrementing ordered_cur.  Only if it's not 
-     full do we have to write our id.  */
-  if (ws->ordered_num_used < team->nthreads)
-    {
-      index = ws->ordered_cur + ws->ordered_num_used;
-      if (index >= team->nthreads)
-	index -= team->nthreads;
-      ws->ordered_team_ids[index] = thr->ts.team_id;
-    }
-
-  index = ws->ordered_cur + 1;
-  if (index == team->nthreads)
-    index = 0;
-  ws->ordered_cur = index;
-
-  next_id = ws->ordered_team_ids[index];
-  gomp_sem_post (team->ordered_release[next_id]);
+  gomp_ordered_take (thr, thr->ts.work_share->ordered_tickets++, count);
 }
 
-
-/* This function is called when a statically scheduled loop is first
-   being created.  */
+/* Likewise for a static loop, where the caller knows the TICKET of the
+   block from its position in the loop.  */
 
 void
-gomp_ordered_static_init (void)
+gomp_ordered_static_first (unsigned ticket, unsigned long count)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
@@ -154,71 +111,73 @@ gomp_ordered_static_init (void)
   if (team == NULL || team->nthreads == 1)
     return;
 
-  gomp_sem_post (team->ordered_release[0]);
+  gomp_ordered_take (thr, ticket, count);
 }
 
-/* This function is called when a statically scheduled loop is moving to
-   the next allocation block.  Static schedules are not first come first
-   served like the others, so we're to move to the numerically next thread,
-   not the next thread on a list.  The work-share lock should *not* be held
-   on entry.  */
+/* This function is called when the thread is done with its block of
+   iterations, before it asks for the next one.  If the block has not
+   passed its turn on yet, either do so or mark the ticket done.  The
+   work-share lock must be held on entry; it is dropped while waiting for
+   the turn.  */
 
 void
-gomp_ordered_static_next (void)
+gomp_ordered_last (void)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
   struct gomp_work_share *ws = thr->ts.work_share;
-  unsigned id = thr->ts.team_id;
+  unsigned ticket = thr->ts.ordered_ticket;
 
-  if (team == NULL || team->nthreads == 1)
+  if (team == NULL || team->nthreads == 1 || !thr->ts.ordered_held)
     return;
 
-  ws->ordered_owner = -1;
+  thr->ts.ordered_held = false;
+  if (ticket != ws->ordered_serving)
+    {
+      if (ticket - ws->ordered_serving
+	  < ws->ordered_mask + 1 - team->nthreads)
+	{
+	  ws->ordered_team_ids[ticket & ws->ordered_mask] = GOMP_ORDERED_DONE;
+	  return;
+	}
+
+      /* Too far ahead.  */
+      gomp_mutex_unlock (&ws->lock);
+      gomp_sem_wait (team->ordered_release[thr->ts.team_id]);
+      gomp_mutex_lock (&ws->lock);
+    }
+  else if (!thr->ts.ordered_owned)
+    /* Take the post that gave us the turn, so that it doesn't let
+       us into an ordered region out of turn later.  */
+    gomp_sem_wait (team->ordered_release[thr->ts.team_id]);
 
-  /* This thread currently owns the lock.  Increment the owner.  */
-  if (++id == team->nthreads)
-    id = 0;
-  ws->ordered_team_ids[0] = id;
-  gomp_sem_post (team->ordered_release[id]);
+  gomp_ordered_advance (team, ws);
 }
 
 /* This function is called when we need to assert that the thread owns the
-   ordered section.  Due to the problem of posted-but-not-waited semaphores,
-   this needs to happen before completing a loop iteration.  */
+   ordered section.  */
 
 void
 gomp_ordered_sync (void)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
-  struct gomp_work_share *ws = thr->ts.work_share;
 
   /* Work share constructs can be orphaned.  But this clearly means that
      we are the only thread, and so we automatically own the section.  */
   if (team == NULL || team->nthreads == 1)
     return;
 
-  /* ??? I believe it to be safe to access this data without taking the
-     ws->lock.  The only presumed race condition is with the previous
-     thread on the queue incrementing ordered_cur such that it points
-     to us, concurrently with our check below.  But our team_id is
-     already present in the queue, and the other thread will always
-     post to our release semaphore.  So the two cases are that we will
-     either win the race an momentarily block on the semaphore, or lose
-     the race and find the semaphore already unlocked and so not block.
-     Either way we get correct results.  */
-
-  if (ws->ordered_owner != thr->ts.team_id)
+  if (!thr->ts.ordered_owned)
     {
       gomp_sem_wait (team->ordered_release[thr->ts.team_id]);
-      ws->ordered_owner = thr->ts.team_id;
+      thr->ts.ordered_owned = true;
     }
 }
 
 /* This function is called by user code when encountering the start of an
-   ORDERED block.  We must check to see if the current thread is at the
-   head of the queue, and if not, block.  */
+   ORDERED block.  We must check to see if it is the current thread's
+   turn, and if not, block.  */
 
 #ifdef HAVE_ATTRIBUTE_ALIAS
 extern void GOMP_ordered_start (void)
@@ -232,15 +191,26 @@ GOMP_ordered_start (void)
 #endif
 
 /* This function is called by user code when encountering the end of an
-   ORDERED block.  With the current ORDERED implementation there's nothing
-   for us to do.
-
-   However, the current implementation has a flaw in that it does not allow
-   the next thread into the ORDERED section immediately after the current
-   thread exits the ORDERED section in its last iteration.  The existance
-   of this function allows the implementation to change.  */
+   ORDERED block.  Each iteration runs at most one ordered region, so
+   once the block of iterations has run as many as it has iterations,
+   the next block may have its turn without waiting for this thread to
+   ask for more work.  */
 
 void
 GOMP_ordered_end (void)
 {
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_team *team = thr->ts.team;
+  struct gomp_work_share *ws = thr->ts.work_share;
+
+  if (team == NULL || team->nthreads == 1)
+    return;
+
+  if (--thr->ts.ordered_left == 0 && thr->ts.ordered_held)
+    {
+      gomp_mutex_lock (&ws->lock);
+      thr->ts.ordered_held = false;
+      gomp_ordered_advance (team, ws);
+      gomp_mutex_unlock (&ws->lock);
+    }
 }
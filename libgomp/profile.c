@@ -0,0 +1,452 @@
+/* Copyright (C) 2010 Free Software Foundation, Inc.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file handles GOMP_PROFILE.  It times parallel regions, work
+   shares, barrier waits, deferred tasks and waits for the task lock,
+   optionally writes each of them to a trace file, and reports at exit
+   how evenly the threads of each parallel region were loaded.  */
+
+#include "libgomp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef LIBGOMP_PROFILE
+
+/* The number of events a thread buffers before writing them to the
+   trace file.  */
+#define GOMP_PROFILE_EVENTS	1024
+
+/* The number of parallel region functions the report tells apart.  The
+   regions of any further functions are reported together.  */
+#define GOMP_PROFILE_REGIONS	256
+
+/* The times of a thread in its parallel region: working, waiting at
+   barriers and waiting for the task lock.  */
+
+struct gomp_profile_times
+{
+  unsigned long long busy;
+  unsigned long long barrier;
+  unsigned long long task_lock;
+};
+
+struct gomp_team_profile
+{
+  void (*fn) (void *);
+  unsigned long long start;
+
+  /* The times of each thread, indexed by team_id.  */
+  struct gomp_profile_times threads[];
+};
+
+/* The totals of the regions of a function for the report.  BUSY,
+   BARRIER and TASK_LOCK add up the averages over the threads of each
+   region, and BUSY_MAX the times of the busiest thread.  */
+
+struct gomp_profile_region
+{
+  void (*fn) (void *);
+  unsigned long calls;
+  unsigned long threads;
+  unsigned long long wall;
+  unsigned long long busy;
+  unsigned long long busy_max;
+  unsigned long long barrier;
+  unsigned long long task_lock;
+};
+
+bool gomp_profile_var;
+
+static const char *const gomp_profile_names[GOMP_PROFILE_KINDS]
+  = { "parallel", "workshare", "barrier", "task", "tasklock" };
+
+/* This lock protects all of the below.  */
+static gomp_mutex_t gomp_profile_lock;
+static struct gomp_profile *gomp_profile_threads;
+static unsigned gomp_profile_nthreads;
+static struct gomp_profile_region gomp_profile_regions[GOMP_PROFILE_REGIONS];
+static FILE *gomp_profile_file;
+
+/* The times in the trace are relative to this.  */
+static unsigned long long gomp_profile_epoch;
+
+/* Start profiling, writing the trace to FILE unless it is NULL.  */
+
+void
+gomp_profile_init (const char *file)
+{
+  gomp_mutex_init (&gomp_profile_lock);
+  gomp_profile_epoch = gomp_clock_ns ();
+  if (file != NULL)
+    {
+      gomp_profile_file = fopen (file, "w");
+      if (gomp_profile_file == NULL)
+	gomp_error ("Could not open the GOMP_PROFILE trace file %s", file);
+      else
+	fputs ("# thread event start_ns end_ns function\n",
+	       gomp_profile_file);
+    }
+  gomp_profile_var = true;
+}
+
+/* Write the buffered events of PROF to the trace file.  The profile lock
+   must be held.  */
+
+static void
+gomp_profile_flush (struct gomp_profile *prof)
+{
+  unsigned i;
+
+  for (i = 0; i < prof->nevents; i++)
+    {
+      struct gomp_profile_event *ev = &prof->events[i];
+
+      fprintf (gomp_profile_file, "%u %s %llu %llu %p\n", prof->serial,
+	       gomp_profile_names[ev->kind], ev->start - gomp_profile_epoch,
+	       ev->end - gomp_profile_epoch, ev->id);
+    }
+  prof->nevents = 0;
+}
+
+/* Give THR the profile data of a thread that has exited, or new ones.  */
+
+struct gomp_profile *
+gomp_profile_new_thread (struct gomp_thread *thr)
+{
+  struct gomp_profile *prof;
+
+  gomp_mutex_lock (&gomp_profile_lock);
+  for (prof = gomp_profile_threads; prof != NULL; prof = prof->next)
+    if (prof->idle)
+      break;
+  if (prof == NULL)
+    {
+      prof = gomp_malloc (sizeof (*prof));
+      memset (prof, '\0', sizeof (*prof));
+      prof->serial = gomp_profile_nthreads++;
+      if (gomp_profile_file != NULL)
+	prof->events = gomp_malloc (GOMP_PROFILE_EVENTS
+				    * sizeof (prof->events[0]));
+      prof->next = gomp_profile_threads;
+      gomp_profile_threads = prof;
+    }
+  prof->idle = false;
+  gomp_mutex_unlock (&gomp_profile_lock);
+
+  thr->prof = prof;
+  return prof;
+}
+
+/* Called when THR exits.  */
+
+void
+gomp_profile_thread_end (struct gomp_thread *thr)
+{
+  struct gomp_profile *prof = thr->prof;
+
+  if (prof == NULL)
+    return;
+  gomp_mutex_lock (&gomp_profile_lock);
+  if (prof->events != NULL)
+    gomp_profile_flush (prof);
+  prof->idle = true;
+  gomp_mutex_unlock (&gomp_profile_lock);
+  thr->prof = NULL;
+}
+
+/* Count NS nanoseconds of an event of KIND of PROF from START to END,
+   and buffer it for the trace.  */
+
+static void
+gomp_profile_add (struct gomp_profile *prof, enum gomp_profile_kind kind,
+		  unsigned long long start, unsigned long long end,
+		  unsigned long long ns, void *id)
+{
+  struct gomp_profile_event *ev;
+
+  prof->count[kind]++;
+  prof->time[kind] += ns;
+  if (prof->events == NULL)
+    return;
+
+  ev = &prof->events[prof->nevents++];
+  ev->start = start;
+  ev->end = end;
+  ev->id = id;
+  ev->kind = kind;
+  if (prof->nevents == GOMP_PROFILE_EVENTS)
+    {
+      gomp_mutex_lock (&gomp_profile_lock);
+      gomp_profile_flush (prof);
+      gomp_mutex_unlock (&gomp_profile_lock);
+    }
+}
+
+/* Return the function of the parallel region of THR, or NULL.  */
+
+static inline void *
+gomp_profile_region_fn (struct gomp_thread *thr)
+{
+  struct gomp_team *team = thr->ts.team;
+
+  if (team == NULL || team->prof == NULL)
+    return NULL;
+  return (void *) team->prof->fn;
+}
+
+/* Record an event of KIND of THR from START to END.  */
+
+static void
+gomp_profile_record (struct gomp_thread *thr, enum gomp_profile_kind kind,
+		     unsigned long long start, unsigned long long end,
+		     void *id)
+{
+  gomp_profile_add (gomp_profile_thread (thr), kind, start, end,
+		    end - start, id);
+}
+
+/* Record that THR ran the task function FN from START until now.  */
+
+void
+gomp_profile_task (struct gomp_thread *thr, unsigned long long start,
+		   void *fn)
+{
+  struct gomp_team *team = thr->ts.team;
+  unsigned long long end = gomp_clock_ns ();
+
+  gomp_profile_record (thr, GOMP_PROFILE_TASK, start, end, fn);
+
+  /* A thread that has left the parallel region runs tasks in the barrier
+     at its end, which only completes once they are all done, so the
+     master sees this when it adds up the times.  */
+  if (team != NULL && team->prof != NULL && thr->ts.prof_start == 0)
+    team->prof->threads[thr->ts.team_id].busy += end - start;
+}
+
+/* The slow path of gomp_profile_wait_end.  */
+
+void
+gomp_profile_wait_end_1 (struct gomp_profile_wait *w,
+			 enum gomp_profile_kind kind)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_profile *prof = thr->prof;
+  unsigned long long end = gomp_clock_ns ();
+  unsigned long long ns = end - w->start;
+  unsigned long long task = prof->time[GOMP_PROFILE_TASK] - w->task;
+
+  /* The tasks the thread ran while it waited count as work.  */
+  ns = ns > task ? ns - task : 0;
+  gomp_profile_add (prof, kind, w->start, end, ns,
+		    gomp_profile_region_fn (thr));
+}
+
+/* Called by the master thread when it starts TEAM to run FN.  */
+
+void
+gomp_profile_team_start (struct gomp_team *team, void (*fn) (void *))
+{
+  struct gomp_team_profile *tp;
+
+  tp = gomp_malloc (sizeof (*tp) + team->nthreads * sizeof (tp->threads[0]));
+  tp->fn = fn;
+  tp->start = gomp_clock_ns ();
+  team->prof = tp;
+}
+
+/* Called by each thread of a team right before it runs the function of
+   the parallel region.  */
+
+void
+gomp_profile_region_enter (struct gomp_thread *thr)
+{
+  struct gomp_profile *prof = gomp_profile_thread (thr);
+
+  thr->ts.prof_start = gomp_clock_ns ();
+  thr->ts.prof_ws_start = thr->ts.prof_start;
+  thr->ts.prof_barrier = prof->time[GOMP_PROFILE_BARRIER];
+  thr->ts.prof_task_lock = prof->time[GOMP_PROFILE_TASK_LOCK];
+}
+
+/* Called by each thread of a team right after the function of the
+   parallel region returns, to tell the master how long the thread
+   worked and waited.  The tasks the thread runs in the barrier at the
+   end of the region are added by gomp_profile_task.  */
+
+void
+gomp_profile_region_exit (struct gomp_thread *thr)
+{
+  struct gomp_team_profile *tp = thr->ts.team->prof;
+  struct gomp_profile *prof = gomp_profile_thread (thr);
+  struct gomp_profile_times *t = &tp->threads[thr->ts.team_id];
+  unsigned long long end = gomp_clock_ns ();
+  unsigned long long ns = end - thr->ts.prof_start;
+
+  t->barrier = prof->time[GOMP_PROFILE_BARRIER] - thr->ts.prof_barrier;
+  t->task_lock = prof->time[GOMP_PROFILE_TASK_LOCK] - thr->ts.prof_task_lock;
+  t->busy = ns > t->barrier + t->task_lock
+	    ? ns - t->barrier - t->task_lock : 0;
+  gomp_profile_add (prof, GOMP_PROFILE_PARALLEL, thr->ts.prof_start, end, ns,
+		    (void *) tp->fn);
+  thr->ts.prof_start = 0;
+}
+
+/* Return the report totals for FN.  The profile lock must be held.  */
+
+static struct gomp_profile_region *
+gomp_profile_region (void (*fn) (void *))
+{
+  unsigned long h = (unsigned long) fn;
+  unsigned i, n = GOMP_PROFILE_REGIONS - 1;
+  struct gomp_profile_region *r;
+
+  h ^= h >> 7;
+  for (i = 0; i < n; i++)
+    {
+      r = &gomp_profile_regions[(h + i) % n];
+      if (r->fn == fn)
+	return r;
+      if (r->fn == NULL)
+	{
+	  r->fn = fn;
+	  return r;
+	}
+    }
+  /* The last entry collects the functions that did not fit.  */
+  return &gomp_profile_regions[n];
+}
+
+/* Called by the master thread of TEAM once all the threads have left the
+   parallel region, to add up their times.  */
+
+void
+gomp_profile_team_end (struct gomp_team *team)
+{
+  struct gomp_team_profile *tp = team->prof;
+  struct gomp_profile_region *r;
+  unsigned long long busy = 0, busy_max = 0, barrier = 0, task_lock = 0;
+  unsigned long long wall = gomp_clock_ns () - tp->start;
+  unsigned i, n = team->nthreads;
+
+  for (i = 0; i < n; i++)
+    {
+      busy += tp->threads[i].busy;
+      if (tp->threads[i].busy > busy_max)
+	busy_max = tp->threads[i].busy;
+      barrier += tp->threads[i].barrier;
+      task_lock += tp->threads[i].task_lock;
+    }
+
+  gomp_mutex_lock (&gomp_profile_lock);
+  r = gomp_profile_region (tp->fn);
+  r->calls++;
+  r->threads += n;
+  r->wall += wall;
+  r->busy += busy / n;
+  r->busy_max += busy_max;
+  r->barrier += barrier / n;
+  r->task_lock += task_lock / n;
+  gomp_mutex_unlock (&gomp_profile_lock);
+
+  team->prof = NULL;
+  free (tp);
+}
+
+/* Called by each thread at the end of a work share.  */
+
+void
+gomp_profile_work_share_end (struct gomp_thread *thr)
+{
+  gomp_profile_record (thr, GOMP_PROFILE_WORK_SHARE, thr->ts.prof_ws_start,
+		       gomp_clock_ns (), gomp_profile_region_fn (thr));
+}
+
+static int
+gomp_profile_region_cmp (const void *a, const void *b)
+{
+  const struct gomp_profile_region *ra = a, *rb = b;
+
+  if (ra->wall != rb->wall)
+    return ra->wall < rb->wall ? 1 : -1;
+  return 0;
+}
+
+/* Write out the rest of the trace and print the report.  */
+
+static void __attribute__((destructor))
+gomp_profile_report (void)
+{
+  unsigned long count[GOMP_PROFILE_KINDS];
+  unsigned long long time[GOMP_PROFILE_KINDS];
+  struct gomp_profile *prof;
+  unsigned i;
+
+  if (!gomp_profile_var)
+    return;
+
+  gomp_mutex_lock (&gomp_profile_lock);
+  memset (count, '\0', sizeof (count));
+  memset (time, '\0', sizeof (time));
+  for (prof = gomp_profile_threads; prof != NULL; prof = prof->next)
+    {
+      if (prof->events != NULL)
+	gomp_profile_flush (prof);
+      for (i = 0; i < GOMP_PROFILE_KINDS; i++)
+	{
+	  count[i] += prof->count[i];
+	  time[i] += prof->time[i];
+	}
+    }
+  if (gomp_profile_file != NULL)
+    fclose (gomp_profile_file);
+  gomp_profile_file = NULL;
+
+  qsort (gomp_profile_regions, GOMP_PROFILE_REGIONS,
+	 sizeof (gomp_profile_regions[0]), gomp_profile_region_cmp);
+  fprintf (stderr, "\nlibgomp: %-18s %8s %7s %11s %11s %9s %11s %11s\n",
+	   "parallel region", "calls", "threads", "wall ms", "busy ms",
+	   "imbalance", "barrier ms", "lock ms");
+  for (i = 0; i < GOMP_PROFILE_REGIONS; i++)
+    {
+      struct gomp_profile_region *r = &gomp_profile_regions[i];
+
+      if (r->calls == 0)
+	continue;
+      fprintf (stderr, "libgomp: %-18p %8lu %7.1f %11.3f %11.3f %8.1f%% "
+	       "%11.3f %11.3f\n", (void *) r->fn, r->calls,
+	       (double) r->threads / r->calls, r->wall / 1e6, r->busy / 1e6,
+	       r->busy_max
+	       ? 100.0 * (r->busy_max - r->busy) / r->busy_max : 0.0,
+	       r->barrier / 1e6, r->task_lock / 1e6);
+    }
+
+  fprintf (stderr, "libgomp: %-18s %8s %11s\n", "event", "count",
+	   "total ms");
+  for (i = 0; i < GOMP_PROFILE_KINDS; i++)
+    fprintf (stderr, "libgomp: %-18s %8lu %11.3f\n", gomp_profile_names[i],
+	     count[i], time[i] / 1e6);
+  gomp_mutex_unlock (&gomp_profile_lock);
+}
+
+#endif /* LIBGOMP_PROFILE */
@@ -30,6 +30,337 @@
 #include <string.h>
 
 
+#ifndef HAVE_SYNC_BUILTINS
+/* Protects the reference counts of task counts and the task counts of
+   the teams.  */
+static gomp_mutex_t task_count_lock;
+
+#if !GOMP_MUTEX_INIT_0
+static void __attribute__((constructor))
+initialize_task (void)
+{
+  gomp_mutex_init (&task_count_lock);
+}
+#endif
+#endif
+
+/* Add VAL to *PTR atomically and return the new value.  */
+
+static inline int
+gomp_task_add (int *ptr, int val)
+{
+#ifdef HAVE_SYNC_BUILTINS
+  return __sync_add_and_fetch (ptr, val);
+#else
+  int ret;
+
+  gomp_mutex_lock (&task_count_lock);
+  ret = *ptr += val;
+  gomp_mutex_unlock (&task_count_lock);
+  return ret;
+#endif
+}
+
+/* Store NEWVAL to *PTR if it still holds OLDVAL, atomically.  */
+
+static inline bool
+gomp_task_cas (int *ptr, int oldval, int newval)
+{
+#ifdef HAVE_SYNC_BUILTINS
+  return __sync_bool_compare_and_swap (ptr, oldval, newval);
+#else
+  bool ret;
+
+  gomp_mutex_lock (&task_count_lock);
+  ret = *ptr == oldval;
+  if (ret)
+    *ptr = newval;
+  gomp_mutex_unlock (&task_count_lock);
+  return ret;
+#endif
+}
+
+/* Push TASK at the bottom of the deque D of the current thread, which
+   must not be full.  */
+
+static inline void
+gomp_task_deque_push (struct gomp_task_deque *d, struct gomp_task *task)
+{
+#ifdef HAVE_SYNC_BUILTINS
+  long b = d->bottom;
+
+  if (__builtin_expect (d->tasks == NULL, 0))
+    d->tasks = gomp_malloc (GOMP_TASK_DEQUE_SIZE * sizeof (d->tasks[0]));
+  d->tasks[b & (GOMP_TASK_DEQUE_SIZE - 1)] = task;
+  /* Only the owner writes BOTTOM, but the full barrier of the atomic
+     add also publishes the task before BOTTOM to the thieves, and
+     BOTTOM before the check in gomp_task_advertise.  */
+  __sync_fetch_and_add (&d->bottom, 1);
+#else
+  gomp_mutex_lock (&d->lock);
+  if (d->tasks == NULL)
+    d->tasks = gomp_malloc (GOMP_TASK_DEQUE_SIZE * sizeof (d->tasks[0]));
+  d->tasks[d->bottom & (GOMP_TASK_DEQUE_SIZE - 1)] = task;
+  d->bottom++;
+  gomp_mutex_unlock (&d->lock);
+#endif
+}
+
+/* Pop the newest task from the deque D of the current thread, if it
+   was pushed at index MARK or above.  Return NULL if there is none.  */
+
+static inline struct gomp_task *
+gomp_task_deque_pop (struct gomp_task_deque *d, long mark)
+{
+  struct gomp_task *task;
+#ifdef HAVE_SYNC_BUILTINS
+  long b = d->bottom - 1;
+  long t;
+
+  if (b < mark)
+    return NULL;
+  /* Claim the slot before looking whether a thief got there first.  */
+  __sync_fetch_and_add (&d->bottom, -1);
+  t = d->top;
+  if (t > b)
+    {
+      d->bottom = b + 1;
+      return NULL;
+    }
+  task = d->tasks[b & (GOMP_TASK_DEQUE_SIZE - 1)];
+  if (t == b)
+    {
+      /* This is the last task, which a thief may be taking as well.  */
+      if (!__sync_bool_compare_and_swap (&d->top, t, t + 1))
+	task = NULL;
+      d->bottom = b + 1;
+    }
+#else
+  gomp_mutex_lock (&d->lock);
+  if (d->bottom > d->top && d->bottom > mark)
+    task = d->tasks[--d->bottom & (GOMP_TASK_DEQUE_SIZE - 1)];
+  else
+    task = NULL;
+  gomp_mutex_unlock (&d->lock);
+#endif
+  return task;
+}
+
+/* Steal the oldest task from the deque D of another thread.  Return
+   NULL if D is empty.  */
+
+static inline struct gomp_task *
+gomp_task_deque_steal (struct gomp_task_deque *d)
+{
+  struct gomp_task *task;
+#ifdef HAVE_SYNC_BUILTINS
+  long t, b;
+
+  do
+    {
+      t = d->top;
+      __sync_synchronize ();
+      b = d->bottom;
+      if (t >= b)
+	return NULL;
+      __sync_synchronize ();
+      task = d->tasks[t & (GOMP_TASK_DEQUE_SIZE - 1)];
+    }
+  while (!__sync_bool_compare_and_swap (&d->top, t, t + 1));
+#else
+  gomp_mutex_lock (&d->lock);
+  if (d->top < d->bottom)
+    task = d->tasks[d->top++ & (GOMP_TASK_DEQUE_SIZE - 1)];
+  else
+    task = NULL;
+  gomp_mutex_unlock (&d->lock);
+#endif
+  return task;
+}
+
+/* Lock the task lock of TEAM, timing the wait for GOMP_PROFILE.  */
+
+static inline void
+gomp_task_lock (struct gomp_team *team)
+{
+  struct gomp_profile_wait w;
+
+  gomp_profile_wait_start (&w);
+  gomp_mutex_lock (&team->task_lock);
+  gomp_profile_wait_end (&w, GOMP_PROFILE_TASK_LOCK);
+}
+
+/* Return true if any deque of TEAM holds a task.  */
+
+static bool
+gomp_task_any_queued (struct gomp_team *team)
+{
+  unsigned i;
+
+  for (i = 0; i < team->nthreads; i++)
+    if (team->task_deques[i].top < team->task_deques[i].bottom)
+      return true;
+  return false;
+}
+
+/* Find a task for the thread with TEAM_ID to run while it waits in the
+   team barrier: the newest one of its own deque, otherwise the oldest
+   one of the deque of another thread.  Wake another waiting thread if
+   the latter still holds tasks, so that sleeping threads join in one
+   after the other.  */
+
+static struct gomp_task *
+gomp_task_find (struct gomp_team *team, unsigned team_id)
+{
+  struct gomp_task *task;
+  struct gomp_task_deque *d;
+  unsigned i, n = team->nthreads;
+
+  task = gomp_task_deque_pop (&team->task_deques[team_id], 0);
+  for (i = 1; task == NULL && i < n; i++)
+    {
+      d = &team->task_deques[(team_id + i) % n];
+      task = gomp_task_deque_steal (d);
+      if (task && d->top < d->bottom)
+	gomp_team_barrier_wake (&team->barrier, 1);
+    }
+  return task;
+}
+
+/* Tell the threads waiting in the barrier of TEAM that there are tasks
+   to run, after a push to a deque.  */
+
+static inline void
+gomp_task_advertise (struct gomp_team *team)
+{
+  bool do_wake;
+
+#ifdef HAVE_SYNC_BUILTINS
+  /* The push has a full barrier, which pairs with the one in
+     gomp_barrier_handle_tasks: either the thread clearing the flag sees
+     the push, or we see the flag clear.  */
+  if (gomp_team_barrier_task_pending (&team->barrier))
+    return;
+#endif
+  gomp_task_lock (team);
+  do_wake = !gomp_team_barrier_task_pending (&team->barrier);
+  if (do_wake)
+    gomp_team_barrier_set_task_pending (&team->barrier);
+  gomp_mutex_unlock (&team->task_lock);
+  if (do_wake)
+    gomp_team_barrier_wake (&team->barrier, 1);
+}
+
+/* Return a heap task descriptor with room for ARG_SPACE bytes of
+   arguments, recycling one THR freed if possible.  */
+
+static struct gomp_task *
+gomp_alloc_task (struct gomp_thread *thr, size_t arg_space)
+{
+  struct gomp_task *task;
+  int size_class = 0;
+
+  while (size_class < GOMP_TASK_SIZE_CLASSES
+	 && arg_space > (size_t) GOMP_TASK_MIN_ARGS << size_class)
+    size_class++;
+  if (size_class == GOMP_TASK_SIZE_CLASSES)
+    task = gomp_malloc (sizeof (*task) + arg_space);
+  else if (thr->task_free_list[size_class])
+    {
+      task = thr->task_free_list[size_class];
+      thr->task_free_list[size_class] = task->parent;
+      thr->task_free_count[size_class]--;
+    }
+  else
+    task = gomp_malloc (sizeof (*task)
+			+ (GOMP_TASK_MIN_ARGS << size_class));
+  task->size_class = size_class;
+  return task;
+}
+
+/* Free the heap task descriptor TASK, keeping it for reuse by the
+   current thread unless it already has enough of its size.  */
+
+void
+gomp_free_task (struct gomp_task *task)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  int size_class = task->size_class;
+
+  if (size_class < GOMP_TASK_SIZE_CLASSES
+      && thr->task_free_count[size_class] < GOMP_TASK_FREE_MAX)
+    {
+      task->parent = thr->task_free_list[size_class];
+      thr->task_free_list[size_class] = task;
+      thr->task_free_count[size_class]++;
+    }
+  else
+    free (task);
+}
+
+/* Free the task descriptors THR keeps for reuse, before it exits.  */
+
+void
+gomp_free_thread_tasks (struct gomp_thread *thr)
+{
+  struct gomp_task *task;
+  int i;
+
+  for (i = 0; i < GOMP_TASK_SIZE_CLASSES; i++)
+    {
+      while ((task = thr->task_free_list[i]) != NULL)
+	{
+	  thr->task_free_list[i] = task->parent;
+	  free (task);
+	}
+      thr->task_free_count[i] = 0;
+    }
+}
+
+/* Return true if a task with function FN that THR creates should run
+   immediately rather than be deferred: if the deque D of THR already
+   holds gomp_task_cutoff_var tasks, or with the adaptive cutoff, if D
+   holds a few and tasks with FN have been too short to be worth
+   queueing.  */
+
+static inline bool
+gomp_task_cutoff (struct gomp_thread *thr, struct gomp_task_deque *d,
+		  void (*fn) (void *))
+{
+  unsigned long depth = d->bottom - d->top;
+  struct gomp_task_grain *grain;
+
+  if (depth >= gomp_task_cutoff_var)
+    return true;
+  if (!gomp_task_cutoff_adaptive || depth < GOMP_TASK_GRAIN_DEPTH)
+    return false;
+  grain = &thr->task_grain[((uintptr_t) fn >> 4)
+			   & (GOMP_TASK_GRAIN_SLOTS - 1)];
+  return grain->fn == fn && grain->avg_ns < GOMP_TASK_GRAIN_NS;
+}
+
+/* Record that a deferred task with function FN took NS nanoseconds to
+   run on THR.  */
+
+static void
+gomp_task_record_grain (struct gomp_thread *thr, void (*fn) (void *),
+			unsigned long long ns)
+{
+  struct gomp_task_grain *grain;
+
+  grain = &thr->task_grain[((uintptr_t) fn >> 4)
+			   & (GOMP_TASK_GRAIN_SLOTS - 1)];
+  if (ns > ~0U)
+    ns = ~0U;
+  if (grain->fn != fn)
+    {
+      grain->fn = fn;
+      grain->avg_ns = ns;
+    }
+  else
+    grain->avg_ns += ((long long) ns - (long long) grain->avg_ns) / 8;
+}
+
 /* Create a new task data structure.  */
 
 void
@@ -39,10 +370,60 @@ gomp_init_task (struct gomp_task *task, struct gomp_task *parent_task,
   task->parent = parent_task;
   task->icv = *prev_icv;
   task->kind = GOMP_TASK_IMPLICIT;
-  task->in_taskwait = false;
   task->in_tied_task = false;
   task->children = NULL;
-  gomp_sem_init (&task->taskwait_sem, 0);
+  task->parent_children = NULL;
+  task->deque_mark = 0;
+}
+
+/* Give TASK a count of its children, holding one reference for TASK.
+   The count lives in TASK unless TASK is on the stack, in which case it
+   lives in a heap task descriptor of its own.  */
+
+static void
+gomp_new_task_count (struct gomp_thread *thr, struct gomp_task *task)
+{
+  struct gomp_task_count *count;
+
+  if (task->kind == GOMP_TASK_IMPLICIT)
+    {
+      count = &task->own_children;
+      count->mem = NULL;
+    }
+  else if (task->kind == GOMP_TASK_TIED)
+    {
+      count = &task->own_children;
+      count->mem = task;
+    }
+  else
+    {
+      struct gomp_task *holder = gomp_alloc_task (thr, 0);
+      count = &holder->own_children;
+      count->mem = holder;
+    }
+  count->refs = 2;
+  gomp_sem_init (&count->taskwait_sem, 0);
+  task->children = count;
+}
+
+/* Drop a reference to COUNT, freeing it with the memory it belongs to
+   after the last one.  */
+
+void
+gomp_release_task_count (struct gomp_task_count *count)
+{
+  int refs = gomp_task_add (&count->refs, -2);
+
+  if (refs == 0)
+    {
+      gomp_sem_destroy (&count->taskwait_sem);
+      if (count->mem)
+	gomp_free_task (count->mem);
+    }
+  else if (refs == 3)
+    /* The last child has finished and the parent sleeps in
+       GOMP_taskwait.  */
+    gomp_sem_post (&count->taskwait_sem);
 }
 
 /* Clean up a task, after completing it.  */
@@ -57,18 +438,45 @@ gomp_end_task (void)
   thr->task = task->parent;
 }
 
-static inline void
-gomp_clear_parent (struct gomp_task *children)
+/* Run the deferred task CHILD_TASK that THR took from a deque, then free
+   it and tell its parent.  */
+
+static void
+gomp_task_run (struct gomp_thread *thr, struct gomp_task *child_task)
 {
-  struct gomp_task *task = children;
-
-  if (task)
-    do
-      {
-	task->parent = NULL;
-	task = task->next_child;
-      }
-    while (task != children);
+  struct gomp_task *task = thr->task;
+  struct gomp_task_count *parent_children = child_task->parent_children;
+#ifdef LIBGOMP_PROFILE
+  unsigned long long prof_start = 0;
+
+  if (__builtin_expect (gomp_profile_var, 0))
+    prof_start = gomp_clock_ns ();
+#endif
+
+  child_task->kind = GOMP_TASK_TIED;
+  child_task->deque_mark
+    = thr->ts.team->task_deques[thr->ts.team_id].bottom;
+  thr->task = child_task;
+  if (gomp_task_cutoff_adaptive
+      && ++thr->task_grain_tick % GOMP_TASK_GRAIN_PERIOD == 0)
+    {
+      unsigned long long start = gomp_clock_ns ();
+      child_task->fn (child_task->fn_data);
+      gomp_task_record_grain (thr, child_task->fn,
+			      gomp_clock_ns () - start);
+    }
+  else
+    child_task->fn (child_task->fn_data);
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (prof_start != 0, 0))
+    gomp_profile_task (thr, prof_start, (void *) child_task->fn);
+#endif
+  thr->task = task;
+  if (child_task->children)
+    gomp_finish_task (child_task);
+  else
+    gomp_free_task (child_task);
+  gomp_release_task_count (parent_children);
 }
 
 /* Called when encountering an explicit task directive.  If IF_CLAUSE is
@@ -95,7 +503,7 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 #endif
 
   if (!if_clause || team == NULL
-      || team->task_count > 64 * team->nthreads)
+      || gomp_task_cutoff (thr, &team->task_deques[thr->ts.team_id], fn))
     {
       struct gomp_task task;
 
@@ -103,6 +511,8 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       task.kind = GOMP_TASK_IFFALSE;
       if (thr->task)
 	task.in_tied_task = thr->task->in_tied_task;
+      if (team)
+	task.deque_mark = team->task_deques[thr->ts.team_id].bottom;
       thr->task = &task;
       if (__builtin_expect (cpyfn != NULL, 0))
 	{
@@ -114,12 +524,6 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	}
       else
 	fn (data);
-      if (task.children)
-	{
-	  gomp_mutex_lock (&team->task_lock);
-	  gomp_clear_parent (task.children);
-	  gomp_mutex_unlock (&team->task_lock);
-	}
       gomp_end_task ();
     }
   else
@@ -127,9 +531,8 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       struct gomp_task *task;
       struct gomp_task *parent = thr->task;
       char *arg;
-      bool do_wake;
 
-      task = gomp_malloc (sizeof (*task) + arg_size + arg_align - 1);
+      task = gomp_alloc_task (thr, arg_size + arg_align - 1);
       arg = (char *) (((uintptr_t) (task + 1) + arg_align - 1)
 		      & ~(uintptr_t) (arg_align - 1));
       gomp_init_task (task, parent, gomp_icv (false));
@@ -145,40 +548,13 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       task->fn = fn;
       task->fn_data = arg;
       task->in_tied_task = true;
-      gomp_mutex_lock (&team->task_lock);
-      if (parent->children)
-	{
-	  task->next_child = parent->children;
-	  task->prev_child = parent->children->prev_child;
-	  task->next_child->prev_child = task;
-	  task->prev_child->next_child = task;
-	}
-      else
-	{
-	  task->next_child = task;
-	  task->prev_child = task;
-	}
-      parent->children = task;
-      if (team->task_queue)
-	{
-	  task->next_queue = team->task_queue;
-	  task->prev_queue = team->task_queue->prev_queue;
-	  task->next_queue->prev_queue = task;
-	  task->prev_queue->next_queue = task;
-	}
-      else
-	{
-	  task->next_queue = task;
-	  task->prev_queue = task;
-	  team->task_queue = task;
-	}
-      ++team->task_count;
-      gomp_team_barrier_set_task_pending (&team->barrier);
-      do_wake = team->task_running_count + !parent->in_tied_task
-		< team->nthreads;
-      gomp_mutex_unlock (&team->task_lock);
-      if (do_wake)
-	gomp_team_barrier_wake (&team->barrier, 1);
+      if (parent->children == NULL)
+	gomp_new_task_count (thr, parent);
+      gomp_task_add (&parent->children->refs, 2);
+      task->parent_children = parent->children;
+      gomp_task_add (&team->task_count, 1);
+      gomp_task_deque_push (&team->task_deques[thr->ts.team_id], task);
+      gomp_task_advertise (team);
     }
 }
 
@@ -187,11 +563,9 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
-  struct gomp_task *task = thr->task;
-  struct gomp_task *child_task = NULL;
-  struct gomp_task *to_free = NULL;
+  struct gomp_task *child_task;
 
-  gomp_mutex_lock (&team->task_lock);
+  gomp_task_lock (team);
   if (gomp_barrier_last_thread (state))
     {
       if (team->task_count == 0)
@@ -203,74 +577,39 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 	}
       gomp_team_barrier_set_waiting_for_tasks (&team->barrier);
     }
+  gomp_mutex_unlock (&team->task_lock);
 
   while (1)
     {
-      if (team->task_queue != NULL)
-	{
-	  struct gomp_task *parent;
-
-	  child_task = team->task_queue;
-	  parent = child_task->parent;
-	  if (parent && parent->children == child_task)
-	    parent->children = child_task->next_child;
-	  child_task->prev_queue->next_queue = child_task->next_queue;
-	  child_task->next_queue->prev_queue = child_task->prev_queue;
-	  if (child_task->next_queue != child_task)
-	    team->task_queue = child_task->next_queue;
-	  else
-	    team->task_queue = NULL;
-	  child_task->kind = GOMP_TASK_TIED;
-	  team->task_running_count++;
-	  if (team->task_count == team->task_running_count)
-	    gomp_team_barrier_clear_task_pending (&team->barrier);
-	}
-      gomp_mutex_unlock (&team->task_lock);
-      if (to_free)
-	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
-	  to_free = NULL;
-	}
-      if (child_task)
+      child_task = gomp_task_find (team, thr->ts.team_id);
+      if (child_task == NULL)
 	{
-	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
-	  thr->task = task;
+	  /* Stop the other waiting threads from looking for tasks, then
+	     look once more in case a task was pushed meanwhile without
+	     setting the flag again.  */
+	  gomp_task_lock (team);
+	  gomp_team_barrier_clear_task_pending (&team->barrier);
+	  gomp_mutex_unlock (&team->task_lock);
+#ifdef HAVE_SYNC_BUILTINS
+	  __sync_synchronize ();
+#endif
+	  if (!gomp_task_any_queued (team))
+	    return;
+	  continue;
 	}
-      else
-	return;
-      gomp_mutex_lock (&team->task_lock);
-      if (child_task)
+      gomp_task_run (thr, child_task);
+      if (gomp_task_add (&team->task_count, -1) == 0)
 	{
-	  struct gomp_task *parent = child_task->parent;
-	  if (parent)
-	    {
-	      child_task->prev_child->next_child = child_task->next_child;
-	      child_task->next_child->prev_child = child_task->prev_child;
-	      if (parent->children == child_task)
-		{
-		  if (child_task->next_child != child_task)
-		    parent->children = child_task->next_child;
-		  else
-		    {
-		      parent->children = NULL;
-		      if (parent->in_taskwait)
-			gomp_sem_post (&parent->taskwait_sem);
-		    }
-		}
-	    }
-	  gomp_clear_parent (child_task->children);
-	  to_free = child_task;
-	  child_task = NULL;
-	  team->task_running_count--;
-	  if (--team->task_count == 0
+	  gomp_task_lock (team);
+	  if (team->task_count == 0
 	      && gomp_team_barrier_waiting_for_tasks (&team->barrier))
 	    {
 	      gomp_team_barrier_done (&team->barrier, state);
 	      gomp_mutex_unlock (&team->task_lock);
 	      gomp_team_barrier_wake (&team->barrier, 0);
 	    }
+	  else
+	    gomp_mutex_unlock (&team->task_lock);
 	}
     }
 }
@@ -283,82 +622,31 @@ GOMP_taskwait (void)
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
   struct gomp_task *task = thr->task;
-  struct gomp_task *child_task = NULL;
-  struct gomp_task *to_free = NULL;
+  struct gomp_task_count *count;
+  struct gomp_task *child_task;
+  int refs;
 
   if (task == NULL || task->children == NULL)
     return;
-  gomp_mutex_lock (&team->task_lock);
-  while (1)
+  count = task->children;
+  /* Only the tasks pushed since TASK started are its descendants, so
+     this never runs a task a tied task may not be suspended for.  */
+  while ((refs = *(volatile int *) &count->refs) != 2)
     {
-      if (task->children == NULL)
-	{
-	  gomp_mutex_unlock (&team->task_lock);
-	  if (to_free)
-	    {
-	      gomp_finish_task (to_free);
-	      free (to_free);
-	    }
-	  return;
-	}
-      if (task->children->kind == GOMP_TASK_WAITING)
-	{
-	  child_task = task->children;
-	  task->children = child_task->next_child;
-	  child_task->prev_queue->next_queue = child_task->next_queue;
-	  child_task->next_queue->prev_queue = child_task->prev_queue;
-	  if (team->task_queue == child_task)
-	    {
-	      if (child_task->next_queue != child_task)
-		team->task_queue = child_task->next_queue;
-	      else
-		team->task_queue = NULL;
-	    }
-	  child_task->kind = GOMP_TASK_TIED;
-	  team->task_running_count++;
-	  if (team->task_count == team->task_running_count)
-	    gomp_team_barrier_clear_task_pending (&team->barrier);
-	}
-      else
-	/* All tasks we are waiting for are already running
-	   in other threads.  Wait for them.  */
-	task->in_taskwait = true;
-      gomp_mutex_unlock (&team->task_lock);
-      if (to_free)
-	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
-	  to_free = NULL;
-	}
+      child_task
+	= gomp_task_deque_pop (&team->task_deques[thr->ts.team_id],
+			       task->deque_mark);
       if (child_task)
 	{
-	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
-	  thr->task = task;
-	}
-      else
-	{
-	  gomp_sem_wait (&task->taskwait_sem);
-	  task->in_taskwait = false;
-	  return;
+	  gomp_task_run (thr, child_task);
+	  gomp_task_add (&team->task_count, -1);
 	}
-      gomp_mutex_lock (&team->task_lock);
-      if (child_task)
+      else if (gomp_task_cas (&count->refs, refs, refs | 1))
 	{
-	  child_task->prev_child->next_child = child_task->next_child;
-	  child_task->next_child->prev_child = child_task->prev_child;
-	  if (task->children == child_task)
-	    {
-	      if (child_task->next_child != child_task)
-		task->children = child_task->next_child;
-	      else
-		task->children = NULL;
-	    }
-	  gomp_clear_parent (child_task->children);
-	  to_free = child_task;
-	  child_task = NULL;
-	  team->task_count--;
-	  team->task_running_count--;
+	  /* All the tasks we are waiting for are already running
+	     in other threads.  Wait for them.  */
+	  gomp_sem_wait (&count->taskwait_sem);
+	  gomp_task_add (&count->refs, -1);
 	}
     }
 }
@@ -53,10 +53,70 @@ struct gomp_thread_start_data
   struct gomp_team_state ts;
   struct gomp_task *task;
   struct gomp_thread_pool *thread_pool;
+  unsigned int place;
   bool nested;
 };
 
 
+/* Threads of nested teams park in a pool for the nesting level of the
+   team they leave, up to gomp_nested_pool_max_var of them per level, and
+   the next nested team at that level takes them from there.  Levels
+   deeper than GOMP_NESTED_POOL_LEVELS share the last pool.  */
+
+#define GOMP_NESTED_POOL_LEVELS 8
+
+/* An idle nested thread, which lives on the stack of that thread.  */
+
+struct gomp_nested_idle
+{
+  struct gomp_thread *thr;
+  struct gomp_nested_idle *next;
+  /* The thread sleeps on this until a team takes it, or forever.  */
+  gomp_sem_t dock;
+};
+
+static struct gomp_nested_pool
+{
+  gomp_mutex_t lock;
+  struct gomp_nested_idle *idle;
+  unsigned long count;
+} gomp_nested_pools[GOMP_NESTED_POOL_LEVELS];
+
+static inline struct gomp_nested_pool *
+gomp_nested_pool (unsigned level)
+{
+  /* Level 1 teams are never nested.  */
+  level -= 2;
+  if (level >= GOMP_NESTED_POOL_LEVELS)
+    level = GOMP_NESTED_POOL_LEVELS - 1;
+  return &gomp_nested_pools[level];
+}
+
+/* Park THR, which has just left a nested team, until gomp_team_start
+   hands it to another team.  Return false if the pool is full and the
+   thread should exit instead.  */
+
+static bool
+gomp_nested_park (struct gomp_thread *thr, struct gomp_nested_idle *idle)
+{
+  struct gomp_nested_pool *npool = gomp_nested_pool (thr->ts.level);
+
+  gomp_mutex_lock (&npool->lock);
+  if (npool->count >= gomp_nested_pool_max_var)
+    {
+      gomp_mutex_unlock (&npool->lock);
+      return false;
+    }
+  idle->next = npool->idle;
+  npool->idle = idle;
+  npool->count++;
+  gomp_mutex_unlock (&npool->lock);
+
+  gomp_sem_wait (&idle->dock);
+  return true;
+}
+
+
 /* This function is a pthread_create entry point.  This contains the idle
    loop in which a thread waits to be called up to become part of a team.  */
 
@@ -68,6 +128,7 @@ gomp_thread_start (void *xdata)
   struct gomp_thread_pool *pool;
   void (*local_fn) (void *);
   void *local_data;
+  unsigned int place;
 
 #ifdef HAVE_TLS
   thr = &gomp_tls_data;
@@ -84,23 +145,60 @@ gomp_thread_start (void *xdata)
   thr->thread_pool = data->thread_pool;
   thr->ts = data->ts;
   thr->task = data->task;
+  thr->place = data->place;
+#ifdef LIBGOMP_PROFILE
+  thr->prof = NULL;
+#endif
 
   thr->ts.team->ordered_release[thr->ts.team_id] = &thr->release;
 
   /* Make thread pool local. */
   pool = thr->thread_pool;
+  place = thr->place;
 
   if (data->nested)
     {
-      struct gomp_team *team = thr->ts.team;
-      struct gomp_task *task = thr->task;
+      struct gomp_nested_idle idle;
 
-      gomp_barrier_wait (&team->barrier);
+      idle.thr = thr;
+      gomp_sem_init (&idle.dock, 0);
+      do
+	{
+	  struct gomp_team *team = thr->ts.team;
+	  struct gomp_task *task = thr->task;
+
+	  gomp_barrier_wait (&team->barrier);
 
-      local_fn (local_data);
-      gomp_team_barrier_wait (&team->barrier);
-      gomp_finish_task (task);
-      gomp_barrier_wait_last (&team->barrier);
+#ifdef LIBGOMP_PROFILE
+	  if (__builtin_expect (team->prof != NULL, 0))
+	    {
+	      gomp_profile_region_enter (thr);
+	      local_fn (local_data);
+	      gomp_profile_region_exit (thr);
+	    }
+	  else
+#endif
+	    local_fn (local_data);
+	  gomp_team_barrier_wait (&team->barrier);
+	  gomp_finish_task (task);
+	  gomp_barrier_wait_last (&team->barrier);
+
+	  /* TEAM may be gone by now.  */
+	  if (!gomp_nested_park (thr, &idle))
+	    break;
+
+	  local_fn = thr->fn;
+	  local_data = thr->data;
+	  thr->fn = NULL;
+	  if (__builtin_expect (thr->place != place, 0))
+	    {
+	      place = thr->place;
+	      if (place)
+		gomp_bind_thread (place - 1);
+	    }
+	}
+      while (1);
+      gomp_sem_destroy (&idle.dock);
     }
   else
     {
@@ -112,7 +210,16 @@ gomp_thread_start (void *xdata)
 	  struct gomp_team *team = thr->ts.team;
 	  struct gomp_task *task = thr->task;
 
-	  local_fn (local_data);
+#ifdef LIBGOMP_PROFILE
+	  if (__builtin_expect (team->prof != NULL, 0))
+	    {
+	      gomp_profile_region_enter (thr);
+	      local_fn (local_data);
+	      gomp_profile_region_exit (thr);
+	    }
+	  else
+#endif
+	    local_fn (local_data);
 	  gomp_team_barrier_wait (&team->barrier);
 	  gomp_finish_task (task);
 
@@ -121,10 +228,22 @@ gomp_thread_start (void *xdata)
 	  local_fn = thr->fn;
 	  local_data = thr->data;
 	  thr->fn = NULL;
+
+	  /* The new team may want this thread on another place.  */
+	  if (__builtin_expect (thr->place != place, 0) && local_fn)
+	    {
+	      place = thr->place;
+	      if (place)
+		gomp_bind_thread (place - 1);
+	    }
 	}
       while (local_fn);
     }
 
+#ifdef LIBGOMP_PROFILE
+  gomp_profile_thread_end (thr);
+#endif
+  gomp_free_thread_tasks (thr);
   gomp_sem_destroy (&thr->release);
   return NULL;
 }
@@ -140,7 +259,8 @@ gomp_new_team (unsigned nthreads)
   int i;
 
   size = sizeof (*team) + nthreads * (sizeof (team->ordered_release[0])
-				      + sizeof (team->implicit_task[0]));
+				      + sizeof (team->implicit_task[0])
+				      + sizeof (team->task_deques[0]));
   team = gomp_malloc (size);
 
   team->work_share_chunk = 8;
@@ -151,23 +271,35 @@ gomp_new_team (unsigned nthreads)
 #endif
   gomp_init_work_share (&team->work_shares[0], false, nthreads);
   team->work_shares[0].next_alloc = NULL;
+  team->work_shares[0].ring_free = false;
+  for (i = 1; i < 8; i++)
+    team->work_shares[i].ring_free = true;
+  team->work_share_ring_next = 1;
   team->work_share_list_free = NULL;
-  team->work_share_list_alloc = &team->work_shares[1];
-  for (i = 1; i < 7; i++)
-    team->work_shares[i].next_free = &team->work_shares[i + 1];
-  team->work_shares[i].next_free = NULL;
+  team->work_share_list_alloc = NULL;
 
   team->nthreads = nthreads;
-  gomp_barrier_init (&team->barrier, nthreads);
+  gomp_team_barrier_init (&team->barrier, nthreads);
 
   gomp_sem_init (&team->master_release, 0);
   team->ordered_release = (void *) &team->implicit_task[nthreads];
   team->ordered_release[0] = &team->master_release;
 
   gomp_mutex_init (&team->task_lock);
-  team->task_queue = NULL;
   team->task_count = 0;
-  team->task_running_count = 0;
+#ifdef LIBGOMP_PROFILE
+  team->prof = NULL;
+#endif
+  team->task_deques = (void *) &team->ordered_release[nthreads];
+  for (i = 0; i < nthreads; i++)
+    {
+      team->task_deques[i].top = 0;
+      team->task_deques[i].bottom = 0;
+      team->task_deques[i].tasks = NULL;
+#ifndef HAVE_SYNC_BUILTINS
+      gomp_mutex_init (&team->task_deques[i].lock);
+#endif
+    }
 
   return team;
 }
@@ -178,7 +310,16 @@ gomp_new_team (unsigned nthreads)
 static void
 free_team (struct gomp_team *team)
 {
-  gomp_barrier_destroy (&team->barrier);
+  unsigned i;
+
+  for (i = 0; i < team->nthreads; i++)
+    {
+      free (team->task_deques[i].tasks);
+#ifndef HAVE_SYNC_BUILTINS
+      gomp_mutex_destroy (&team->task_deques[i].lock);
+#endif
+    }
+  gomp_team_barrier_destroy (&team->barrier);
   gomp_mutex_destroy (&team->task_lock);
   free (team);
 }
@@ -202,6 +343,7 @@ gomp_free_pool_helper (void *thread_pool)
   struct gomp_thread_pool *pool
     = (struct gomp_thread_pool *) thread_pool;
   gomp_barrier_wait_last (&pool->threads_dock);
+  gomp_free_thread_tasks (gomp_thread ());
   gomp_sem_destroy (&gomp_thread ()->release);
   pthread_exit (NULL);
 }
@@ -244,6 +386,100 @@ gomp_free_thread (void *arg __attribute__((unused)))
       gomp_end_task ();
       free (task);
     }
+  gomp_free_thread_tasks (thr);
+}
+
+/* Return the place for thread I of a team of NTHREADS threads, plus
+   one, according to gomp_bind_var, and store its place partition in TS.
+   The master of the team is bound to MASTER_PLACE (plus one, or 0 if
+   it is unbound) and its place partition is the one of PARENT.  */
+
+static unsigned int
+gomp_team_place (const struct gomp_team_state *parent,
+		 unsigned int master_place, unsigned i, unsigned nthreads,
+		 struct gomp_team_state *ts)
+{
+  unsigned off = parent->place_partition_off;
+  unsigned len = parent->place_partition_len;
+  unsigned p, k, first, last;
+
+  if (len == 0)
+    {
+      off = 0;
+      len = gomp_places_list_len;
+    }
+  ts->place_partition_off = off;
+  ts->place_partition_len = len;
+
+  /* P is relative to the partition.  */
+  p = master_place ? master_place - 1 : off;
+  p = p >= off && p - off < len ? p - off : 0;
+
+  switch (gomp_bind_var)
+    {
+    case GOMP_BIND_SPREAD:
+      if (nthreads <= len)
+	{
+	  /* Split the partition into NTHREADS subpartitions.  Thread I
+	     gets the I-th one from that of the master, and its first
+	     place unless it is the master.  */
+	  k = ((p + 1) * nthreads - 1) / len;
+	  k = (k + i) % nthreads;
+	  first = (unsigned long) k * len / nthreads;
+	  last = (unsigned long) (k + 1) * len / nthreads;
+	  ts->place_partition_off = off + first;
+	  ts->place_partition_len = last - first;
+	  if (i != 0)
+	    p = first;
+	  break;
+	}
+      /* FALLTHRU */
+    case GOMP_BIND_CLOSE:
+      /* Consecutive places, several threads per place if need be.  */
+      if (nthreads <= len)
+	p = (p + i) % len;
+      else
+	p = (p + (unsigned long) i * len / nthreads) % len;
+      if (gomp_bind_var == GOMP_BIND_SPREAD)
+	{
+	  ts->place_partition_off = off + p;
+	  ts->place_partition_len = 1;
+	}
+      break;
+    default:
+      break;
+    }
+  return off + p + 1;
+}
+
+/* Make the idle thread NTHR thread I of the NTHREADS threads of TEAM,
+   which the current thread THR starts to run FN (DATA).  TASK is the
+   parent of the implicit tasks and ICV their ICVs.  */
+
+static void
+gomp_team_take_thread (struct gomp_thread *thr, struct gomp_thread *nthr,
+		       struct gomp_team *team, unsigned i, unsigned nthreads,
+		       void (*fn) (void *), void *data,
+		       struct gomp_task *task, struct gomp_task_icv *icv)
+{
+  nthr->ts.team = team;
+  nthr->ts.work_share = &team->work_shares[0];
+  nthr->ts.last_work_share = NULL;
+  nthr->ts.team_id = i;
+  nthr->ts.level = team->prev_ts.level + 1;
+  nthr->ts.active_level = thr->ts.active_level;
+#ifdef HAVE_SYNC_BUILTINS
+  nthr->ts.single_count = 0;
+#endif
+  nthr->ts.static_trip = 0;
+  nthr->task = &team->implicit_task[i];
+  gomp_init_task (nthr->task, task, icv);
+  nthr->fn = fn;
+  nthr->data = data;
+  if (__builtin_expect (gomp_places_list_len != 0, 0))
+    nthr->place = gomp_team_place (&team->prev_ts, thr->place, i,
+				   nthreads, &nthr->ts);
+  team->ordered_release[i] = &nthr->release;
 }
 
 /* Launch a team.  */
@@ -253,7 +489,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
 		 struct gomp_team *team)
 {
   struct gomp_thread_start_data *start_data;
-  struct gomp_thread *thr, *nthr;
+  struct gomp_thread *thr;
   struct gomp_task *task;
   struct gomp_task_icv *icv;
   bool nested;
@@ -290,17 +526,29 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   thr->ts.static_trip = 0;
   thr->task = &team->implicit_task[0];
   gomp_init_task (thr->task, task, icv);
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (gomp_profile_var, 0))
+    gomp_profile_team_start (team, fn);
+#endif
 
   if (nthreads == 1)
-    return;
+    {
+#ifdef LIBGOMP_PROFILE
+      if (__builtin_expect (gomp_profile_var, 0))
+	gomp_profile_region_enter (thr);
+#endif
+      return;
+    }
+
+  if (__builtin_expect (gomp_places_list_len != 0, 0))
+    gomp_team_place (&team->prev_ts, thr->place, 0, nthreads, &thr->ts);
 
   i = 1;
 
-  /* We only allow the reuse of idle threads for non-nested PARALLEL
-     regions.  This appears to be implied by the semantics of
-     threadprivate variables, but perhaps that's reading too much into
-     things.  Certainly it does prevent any locking problems, since
-     only the initial program thread will modify gomp_threads.  */
+  /* The threads of non-nested PARALLEL regions are kept in the pool of
+     the initial thread, and only that thread modifies it.  Threads of
+     nested regions have no threadprivate values anyone may rely on, so
+     they are kept in pools per nesting level instead, see below.  */
   if (!nested)
     {
       old_threads_used = pool->threads_used;
@@ -328,24 +576,8 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
 
       /* Release existing idle threads.  */
       for (; i < n; ++i)
-	{
-	  nthr = pool->threads[i];
-	  nthr->ts.team = team;
-	  nthr->ts.work_share = &team->work_shares[0];
-	  nthr->ts.last_work_share = NULL;
-	  nthr->ts.team_id = i;
-	  nthr->ts.level = team->prev_ts.level + 1;
-	  nthr->ts.active_level = thr->ts.active_level;
-#ifdef HAVE_SYNC_BUILTINS
-	  nthr->ts.single_count = 0;
-#endif
-	  nthr->ts.static_trip = 0;
-	  nthr->task = &team->implicit_task[i];
-	  gomp_init_task (nthr->task, task, icv);
-	  nthr->fn = fn;
-	  nthr->data = data;
-	  team->ordered_release[i] = &nthr->release;
-	}
+	gomp_team_take_thread (thr, pool->threads[i], team, i, nthreads,
+			       fn, data, task, icv);
 
       if (i == nthreads)
 	goto do_release;
@@ -379,8 +611,36 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
 #endif
     }
 
+  /* Take what idle threads there are for a nested team.  */
+  if (nested && gomp_nested_pool_max_var)
+    {
+      struct gomp_nested_pool *npool = gomp_nested_pool (thr->ts.level);
+      struct gomp_nested_idle *idle;
+
+      gomp_mutex_lock (&npool->lock);
+      idle = npool->idle;
+      for (n = i; n < nthreads && npool->idle != NULL; n++)
+	npool->idle = npool->idle->next;
+      npool->count -= n - i;
+      gomp_mutex_unlock (&npool->lock);
+
+      for (; i < n; ++i)
+	{
+	  /* IDLE is gone once its thread has been woken.  */
+	  struct gomp_nested_idle *next = idle->next;
+
+	  gomp_team_take_thread (thr, idle->thr, team, i, nthreads,
+				 fn, data, task, icv);
+	  gomp_sem_post (&idle->dock);
+	  idle = next;
+	}
+
+      if (i == nthreads)
+	goto do_release;
+    }
+
   attr = &gomp_thread_attr;
-  if (__builtin_expect (gomp_cpu_affinity != NULL, 0))
+  if (__builtin_expect (gomp_places_list_len != 0, 0))
     {
       size_t stacksize;
       pthread_attr_init (&thread_attr);
@@ -415,16 +675,23 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       gomp_init_task (start_data->task, task, icv);
       start_data->thread_pool = pool;
       start_data->nested = nested;
+      start_data->place = 0;
+      start_data->ts.place_partition_off = 0;
+      start_data->ts.place_partition_len = 0;
 
-      if (gomp_cpu_affinity != NULL)
-	gomp_init_thread_affinity (attr);
+      if (gomp_places_list_len != 0)
+	{
+	  start_data->place = gomp_team_place (&team->prev_ts, thr->place, i,
+					       nthreads, &start_data->ts);
+	  gomp_init_thread_affinity (attr, start_data->place - 1);
+	}
 
       err = pthread_create (&pt, attr, gomp_thread_start, start_data);
       if (err != 0)
 	gomp_fatal ("Thread creation failed: %s", strerror (err));
     }
 
-  if (__builtin_expect (gomp_cpu_affinity != NULL, 0))
+  if (__builtin_expect (gomp_places_list_len != 0, 0))
     pthread_attr_destroy (&thread_attr);
 
  do_release:
@@ -448,6 +715,11 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       gomp_mutex_unlock (&gomp_remaining_threads_lock);
 #endif
     }
+
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (gomp_profile_var, 0))
+    gomp_profile_region_enter (thr);
+#endif
 }
 
 
@@ -460,14 +732,22 @@ gomp_team_end (void)
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
 
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (team->prof != NULL, 0))
+    gomp_profile_region_exit (thr);
+#endif
+
   /* This barrier handles all pending explicit threads.  */
   gomp_team_barrier_wait (&team->barrier);
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (team->prof != NULL, 0))
+    gomp_profile_team_end (team);
+#endif
   gomp_fini_work_share (thr->ts.work_share);
 
   gomp_end_task ();
-  thr->ts = team->prev_ts;
 
-  if (__builtin_expect (thr->ts.team != NULL, 0))
+  if (__builtin_expect (team->prev_ts.team != NULL, 0))
     {
 #ifdef HAVE_SYNC_BUILTINS
       __sync_fetch_and_add (&gomp_managed_threads, 1L - team->nthreads);
@@ -477,9 +757,11 @@ gomp_team_end (void)
       gomp_mutex_unlock (&gomp_remaining_threads_lock);
 #endif
       /* This barrier has gomp_barrier_wait_last counterparts
-	 and ensures the team can be safely destroyed.  */
+	 and ensures the team can be safely destroyed.  It is still
+	 waited for as thread 0 of TEAM, for the tree barrier.  */
       gomp_barrier_wait (&team->barrier);
     }
+  thr->ts = team->prev_ts;
 
   if (__builtin_expect (team->work_shares[0].next_alloc != NULL, 0))
     {
@@ -516,6 +798,7 @@ static void __attribute__((constructor))
 initialize_team (void)
 {
   struct gomp_thread *thr;
+  int i;
 
 #ifndef HAVE_TLS
   static struct gomp_thread initial_thread_tls_data;
@@ -527,6 +810,9 @@ initialize_team (void)
   if (pthread_key_create (&gomp_thread_destructor, gomp_free_thread) != 0)
     gomp_fatal ("could not create thread pool destructor.");
 
+  for (i = 0; i < GOMP_NESTED_POOL_LEVELS; i++)
+    gomp_mutex_init (&gomp_nested_pools[i].lock);
+
 #ifdef HAVE_TLS
   thr = &gomp_tls_data;
 #else
@@ -0,0 +1,69 @@
+/* Atomic updates of long doubles, which need the lock fallback, from
+   loops updating different variables and from a reduction with several
+   list items.  Check the results and time the loops.  Pass a scale
+   argument to time larger loops, e.g. ./atomic-11.exe 10  */
+
+/* { dg-do run } */
+/* { dg-options "-O2 -fopenmp" } */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int n = 20000;
+static long double a, b[8];
+
+int
+main (int argc, char **argv)
+{
+  long double r1 = 0, r2 = 0;
+  double t;
+  int i, j;
+
+  if (argc > 1)
+    n *= atoi (argv[1]);
+
+  t = omp_get_wtime ();
+#pragma omp parallel for
+  for (i = 0; i < n; i++)
+    {
+#pragma omp atomic
+      a += 1;
+    }
+  printf ("%-20s %9.3f us\n", "one object", (omp_get_wtime () - t) * 1e6 / n);
+
+  t = omp_get_wtime ();
+#pragma omp parallel private (j)
+  {
+#pragma omp for nowait
+    for (i = 0; i < n; i++)
+      for (j = 0; j < 8; j += 2)
+	{
+#pragma omp atomic
+	  b[j] += 1;
+	}
+#pragma omp for nowait
+    for (i = 0; i < n; i++)
+      for (j = 1; j < 8; j += 2)
+	{
+#pragma omp atomic
+	  b[j] += 2;
+	}
+  }
+  printf ("%-20s %9.3f us\n", "eight objects",
+	  (omp_get_wtime () - t) * 1e6 / n);
+
+#pragma omp parallel for reduction (+:r1, r2)
+  for (i = 0; i < n; i++)
+    {
+      r1 += 1;
+      r2 += 2;
+    }
+
+  if (a != n || r1 != n || r2 != 2 * n)
+    abort ();
+  for (j = 0; j < 8; j++)
+    if (b[j] != (j & 1 ? 2 * n : n))
+      abort ();
+  return 0;
+}
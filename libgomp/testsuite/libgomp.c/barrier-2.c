@@ -0,0 +1,154 @@
+/* Synchronization overheads in the style of the EPCC syncbench: each
+   construct is timed around a short delay and the time of the delay
+   alone subtracted.  Barriers also check that no thread gets through
+   a barrier before all have arrived.  Compare the barrier kinds with
+   e.g. GOMP_BARRIER=central ./barrier-2.exe 100
+   and  GOMP_BARRIER=tree ./barrier-2.exe 100  */
+
+/* { dg-do run } */
+/* { dg-options "-O2 -fopenmp" } */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DELAY 100
+
+static int reps = 200;
+static volatile int sink;
+static double reference;
+
+static void
+delay (int n)
+{
+  int i, a = 0;
+
+  for (i = 0; i < n; i++)
+    a += i;
+  if (a < 0)
+    sink = a;
+}
+
+static void
+report (const char *name, double t)
+{
+  printf ("%-16s %9.3f us\n", name, (t - reference) * 1e6 / reps);
+}
+
+int
+main (int argc, char **argv)
+{
+  int i, arrived = 0, errors = 0, sum;
+  omp_lock_t lock;
+  double t;
+
+  if (argc > 1)
+    reps *= atoi (argv[1]);
+  omp_init_lock (&lock);
+
+  t = omp_get_wtime ();
+  for (i = 0; i < reps; i++)
+    delay (DELAY);
+  reference = omp_get_wtime () - t;
+  printf ("%d threads, %d repetitions\n", omp_get_max_threads (), reps);
+
+  t = omp_get_wtime ();
+  for (i = 0; i < reps; i++)
+    {
+      #pragma omp parallel
+	delay (DELAY);
+    }
+  report ("parallel", omp_get_wtime () - t);
+
+  t = omp_get_wtime ();
+  #pragma omp parallel private (i) reduction (+:errors)
+    {
+      int n = omp_get_num_threads ();
+
+      for (i = 0; i < reps; i++)
+	{
+	  delay (DELAY);
+	  #pragma omp atomic
+	    arrived++;
+	  #pragma omp barrier
+	  if (arrived != (i + 1) * n)
+	    errors++;
+	  #pragma omp barrier
+	}
+    }
+  /* Two barriers per repetition.  */
+  report ("barrier", (omp_get_wtime () - t + reference) / 2);
+  if (errors)
+    {
+      fprintf (stderr, "%d threads got through a barrier early\n", errors);
+      abort ();
+    }
+
+  t = omp_get_wtime ();
+  #pragma omp parallel private (i)
+    for (i = 0; i < reps; i++)
+      {
+	#pragma omp single
+	  delay (DELAY);
+      }
+  report ("single", omp_get_wtime () - t);
+
+  t = omp_get_wtime ();
+  #pragma omp parallel private (i)
+    for (i = 0; i < reps; i++)
+      {
+	int j;
+	#pragma omp for
+	  for (j = 0; j < omp_get_num_threads (); j++)
+	    delay (DELAY);
+      }
+  report ("for", omp_get_wtime () - t);
+
+  t = omp_get_wtime ();
+  for (i = 0; i < reps; i++)
+    {
+      int j;
+      #pragma omp parallel for
+	for (j = 0; j < omp_get_max_threads (); j++)
+	  delay (DELAY);
+    }
+  report ("parallel for", omp_get_wtime () - t);
+
+  sum = 0;
+  t = omp_get_wtime ();
+  for (i = 0; i < reps; i++)
+    {
+      #pragma omp parallel reduction (+:sum)
+	{
+	  delay (DELAY);
+	  sum++;
+	}
+    }
+  report ("reduction", omp_get_wtime () - t);
+
+  sum = 0;
+  t = omp_get_wtime ();
+  #pragma omp parallel private (i)
+    for (i = 0; i < reps / omp_get_num_threads (); i++)
+      {
+	#pragma omp critical
+	  {
+	    delay (DELAY);
+	    sum++;
+	  }
+      }
+  report ("critical", omp_get_wtime () - t);
+
+  t = omp_get_wtime ();
+  #pragma omp parallel private (i)
+    for (i = 0; i < reps / omp_get_num_threads (); i++)
+      {
+	omp_set_lock (&lock);
+	delay (DELAY);
+	omp_unset_lock (&lock);
+      }
+  report ("lock/unlock", omp_get_wtime () - t);
+
+  omp_destroy_lock (&lock);
+  return 0;
+}
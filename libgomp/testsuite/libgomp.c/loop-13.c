@@ -0,0 +1,127 @@
+/* Check that loops with uneven iteration costs hand out every iteration
+   exactly once, for long and unsigned long long loops running up and
+   down.  The schedule(runtime) loops are run once with the schedule of
+   OMP_SCHEDULE and once for each of omp_set_schedule's.  Only
+   OMP_SCHEDULE selects the adaptive schedule, so without it the test
+   runs itself again with OMP_SCHEDULE=adaptive,2.  */
+
+/* { dg-do run } */
+/* { dg-options "-O2 -fopenmp" } */
+
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define N 1000
+
+static int cnt[N];
+static volatile int sink;
+
+static void
+work (int i)
+{
+  int j, a = 0;
+
+  /* Make the first iterations much more expensive than the rest.  */
+  for (j = 0; j < (i < N / 8 ? 20000 : 10); j++)
+    a += j;
+  if (a < 0)
+    sink = a;
+  #pragma omp atomic
+    cnt[i]++;
+}
+
+static void
+check (void)
+{
+  int i;
+
+  for (i = 0; i < N; i++)
+    {
+      if (cnt[i] != 1)
+	abort ();
+      cnt[i] = 0;
+    }
+}
+
+static void
+test (void)
+{
+  long l;
+  unsigned long long u;
+
+  #pragma omp parallel for schedule (runtime)
+    for (l = 0; l < N; l++)
+      work (l);
+  check ();
+
+  #pragma omp parallel for schedule (runtime)
+    for (l = 3 * N - 3; l >= 0; l -= 3)
+      work (l / 3);
+  check ();
+
+  #pragma omp parallel
+    {
+      #pragma omp for schedule (runtime) nowait
+	for (u = 0; u < N; u++)
+	  work (u);
+    }
+  check ();
+
+  #pragma omp parallel
+    {
+      #pragma omp for schedule (runtime)
+	for (u = 0x8000000000000000ULL + 2 * N;
+	     u > 0x8000000000000000ULL; u -= 2)
+	  work ((u - 0x8000000000000001ULL) / 2);
+    }
+  check ();
+
+  #pragma omp parallel for schedule (dynamic, 3)
+    for (l = 0; l < N; l++)
+      work (l);
+  check ();
+
+  #pragma omp parallel
+    {
+      #pragma omp for schedule (dynamic, 7)
+	for (u = N; u > 0; u--)
+	  work (u - 1);
+    }
+  check ();
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *sched = getenv ("OMP_SCHEDULE");
+  omp_sched_t kind;
+  int modifier;
+
+  if (sched != NULL && strcmp (sched, "adaptive,2") == 0)
+    {
+      /* omp_get_schedule reports the adaptive schedule as dynamic.  */
+      omp_get_schedule (&kind, &modifier);
+      if (kind != omp_sched_dynamic || modifier != 2)
+	abort ();
+    }
+
+  test ();
+  omp_set_schedule (omp_sched_static, 0);
+  test ();
+  omp_set_schedule (omp_sched_dynamic, 5);
+  test ();
+  omp_set_schedule (omp_sched_guided, 2);
+  test ();
+  omp_set_schedule (omp_sched_auto, 0);
+  test ();
+
+  if (sched == NULL && argc > 0)
+    {
+      setenv ("OMP_SCHEDULE", "adaptive,2", 1);
+      execv (argv[0], argv);
+      abort ();
+    }
+  return 0;
+}
@@ -0,0 +1,80 @@
+/* Entry and exit latency of nested parallel regions, opened from every
+   thread of an outer region and two levels deep, checking the thread
+   numbers and team sizes each time.  Compare e.g.
+   GOMP_NESTED_POOL_MAX=0 ./nested-4.exe 10
+   with ./nested-4.exe 10  */
+
+/* { dg-do run } */
+/* { dg-options "-O2 -fopenmp" } */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int reps = 200;
+static int errors;
+
+static void
+check (int level, int n)
+{
+  int ok = omp_get_level () == level
+	   && omp_get_num_threads () == n
+	   && omp_get_thread_num () < n
+	   && omp_get_team_size (level) == n;
+
+  if (!ok)
+    {
+      #pragma omp atomic
+	errors++;
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  int i;
+  double t;
+
+  if (argc > 1)
+    reps *= atoi (argv[1]);
+  omp_set_nested (1);
+  omp_set_dynamic (0);
+
+  t = omp_get_wtime ();
+  #pragma omp parallel num_threads (2) private (i)
+    for (i = 0; i < reps; i++)
+      {
+	#pragma omp parallel num_threads (3)
+	  check (2, 3);
+      }
+  printf ("2 x 3 threads   %9.3f us\n", (omp_get_wtime () - t) * 1e6 / reps);
+
+  t = omp_get_wtime ();
+  #pragma omp parallel num_threads (2) private (i)
+    for (i = 0; i < reps; i++)
+      {
+	/* The nested teams change size, so that idle threads are left
+	   over and taken up again.  */
+	#pragma omp parallel num_threads (2 + i % 3)
+	  check (2, 2 + i % 3);
+      }
+  printf ("2 x 2-4 threads %9.3f us\n", (omp_get_wtime () - t) * 1e6 / reps);
+
+  t = omp_get_wtime ();
+  #pragma omp parallel num_threads (2) private (i)
+    for (i = 0; i < reps / 4; i++)
+      {
+	#pragma omp parallel num_threads (2)
+	  {
+	    check (2, 2);
+	    #pragma omp parallel num_threads (2)
+	      check (3, 2);
+	  }
+      }
+  printf ("2 x 2 x 2 threads %7.3f us\n",
+	  (omp_get_wtime () - t) * 1e6 / (reps / 4));
+
+  if (errors)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,98 @@
+/* Back-to-back nowait loops with ordered regions, where the iterations
+   take uneven times and only some of them run an ordered region, so
+   that threads run ahead of the ordered regions.  Check that the ordered
+   regions of each loop run in order and time each schedule.  Pass a scale
+   argument to time larger loops, e.g. ./ordered-4.exe 10  */
+
+/* { dg-do run } */
+/* { dg-options "-O2 -fopenmp" } */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int n = 2000;
+static volatile int sink;
+static long last[3];
+static int errors;
+
+static void
+work (long i)
+{
+  int j, a = 0;
+
+  for (j = 0; j < (i % 7 == 0 ? 2000 : 100); j++)
+    a += j;
+  if (a < 0)
+    sink = a;
+}
+
+static void
+visit (int loop, long i)
+{
+  if (i <= last[loop])
+    errors++;
+  last[loop] = i;
+}
+
+static void
+report (const char *name, double t)
+{
+  printf ("%-20s %9.3f us\n", name, t * 1e6 / n);
+  if (errors)
+    {
+      fprintf (stderr, "%s: %d ordered regions out of order\n", name, errors);
+      abort ();
+    }
+}
+
+#define LOOPS(SCHED) \
+  last[0] = last[1] = last[2] = -1;					\
+  t = omp_get_wtime ();							\
+  _Pragma ("omp parallel private (i, u)")				\
+    {									\
+      _Pragma (#SCHED)							\
+	for (i = 0; i < n; i++)						\
+	  {								\
+	    work (i);							\
+	    _Pragma ("omp ordered")					\
+	      visit (0, i);						\
+	  }								\
+      _Pragma (#SCHED)							\
+	for (i = n; i < 2 * n; i++)					\
+	  {								\
+	    work (i);							\
+	    if (i % 3 == 0)						\
+	      _Pragma ("omp ordered")					\
+		visit (1, i);						\
+	  }								\
+      _Pragma (#SCHED)							\
+	for (u = 2ULL * n; u > 0; u--)					\
+	  {								\
+	    work (u);							\
+	    if (u % 5 != 0)						\
+	      _Pragma ("omp ordered")					\
+		visit (2, 2L * n - (long) u);				\
+	  }								\
+    }									\
+  report (#SCHED + 25, (omp_get_wtime () - t) / 3)
+
+int
+main (int argc, char **argv)
+{
+  long i;
+  unsigned long long u;
+  double t;
+
+  if (argc > 1)
+    n *= atoi (argv[1]);
+
+  LOOPS (omp for ordered schedule (static) nowait);
+  LOOPS (omp for ordered schedule (static, 1) nowait);
+  LOOPS (omp for ordered schedule (static, 5) nowait);
+  LOOPS (omp for ordered schedule (dynamic) nowait);
+  LOOPS (omp for ordered schedule (dynamic, 3) nowait);
+  LOOPS (omp for ordered schedule (guided) nowait);
+  LOOPS (omp for ordered schedule (runtime) nowait);
+  return 0;
+}
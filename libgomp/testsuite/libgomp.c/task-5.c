@@ -0,0 +1,173 @@
+/* Task throughput: recursive fib, N queens and an unbalanced tree search
+   (UTS), each run serially and with tasks.  Pass a scale argument to
+   time larger problems, e.g. ./task-5.exe 3  */
+
+/* { dg-do run } */
+/* { dg-options "-O2 -fopenmp" } */
+
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static long
+fib_serial (int n)
+{
+  return n < 2 ? n : fib_serial (n - 1) + fib_serial (n - 2);
+}
+
+static long
+fib (int n)
+{
+  long x, y;
+
+  if (n < 2)
+    return n;
+  #pragma omp task shared (x)
+    x = fib (n - 1);
+  #pragma omp task shared (y)
+    y = fib (n - 2);
+  #pragma omp taskwait
+  return x + y;
+}
+
+static long
+nqueens (const char *a, int n, int pos, int par)
+{
+  /* b[i] = j means the queen in i-th row is in column j.  */
+  char b[pos + 1];
+  long cnt[n];
+  long sum = 0;
+  int i, j;
+
+  memcpy (b, a, pos);
+  for (i = 0; i < n; i++)
+    {
+      cnt[i] = 0;
+      for (j = 0; j < pos; j++)
+	if (b[j] == i || b[j] == i + pos - j || i == b[j] + pos - j)
+	  break;
+      if (j < pos)
+	continue;
+      if (pos == n - 1)
+	cnt[i] = 1;
+      else if (par)
+	{
+	  b[pos] = i;
+	  #pragma omp task shared (cnt) firstprivate (b)
+	    cnt[i] = nqueens (b, n, pos + 1, par);
+	}
+      else
+	{
+	  b[pos] = i;
+	  cnt[i] = nqueens (b, n, pos + 1, par);
+	}
+    }
+  #pragma omp taskwait
+  for (i = 0; i < n; i++)
+    sum += cnt[i];
+  return sum;
+}
+
+/* A binomial UTS tree: the root has uts_root children and every other
+   node has UTS_M children with probability UTS_Q, otherwise none.  */
+
+#define UTS_M 5
+#define UTS_Q 0.19995
+
+static int uts_root = 200;
+
+static unsigned long long
+uts_hash (unsigned long long x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static int
+uts_children (unsigned long long id, int depth)
+{
+  if (depth == 0)
+    return uts_root;
+  return (uts_hash (id) >> 11) * (1.0 / 9007199254740992.0) < UTS_Q
+	 ? UTS_M : 0;
+}
+
+static long
+uts (unsigned long long id, int depth, int par)
+{
+  int i, n = uts_children (id, depth);
+  long cnt[n + 1];
+  long sum = 1;
+
+  for (i = 0; i < n; i++)
+    {
+      unsigned long long child = uts_hash (id * uts_root + i + 1);
+      if (par)
+	{
+	  #pragma omp task shared (cnt)
+	    cnt[i] = uts (child, depth + 1, par);
+	}
+      else
+	cnt[i] = uts (child, depth + 1, par);
+    }
+  #pragma omp taskwait
+  for (i = 0; i < n; i++)
+    sum += cnt[i];
+  return sum;
+}
+
+static double stime;
+
+static void
+report (const char *name, long serial, long parallel, double ptime)
+{
+  printf ("%-8s %12ld serial %9.6fs  %d threads %9.6fs\n",
+	  name, serial, stime, omp_get_max_threads (), ptime);
+  if (serial != parallel)
+    {
+      fprintf (stderr, "%s: %ld != %ld\n", name, parallel, serial);
+      abort ();
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  int scale = argc > 1 ? atoi (argv[1]) : 0;
+  int fn = 20 + 2 * scale, qn = 7 + scale;
+  long s, p;
+  double t;
+
+  uts_root <<= scale;
+
+  t = omp_get_wtime ();
+  s = fib_serial (fn);
+  stime = omp_get_wtime () - t;
+  t = omp_get_wtime ();
+  #pragma omp parallel
+    #pragma omp single
+      p = fib (fn);
+  report ("fib", s, p, omp_get_wtime () - t);
+
+  t = omp_get_wtime ();
+  s = nqueens ("", qn, 0, 0);
+  stime = omp_get_wtime () - t;
+  t = omp_get_wtime ();
+  #pragma omp parallel
+    #pragma omp single
+      p = nqueens ("", qn, 0, 1);
+  report ("nqueens", s, p, omp_get_wtime () - t);
+
+  t = omp_get_wtime ();
+  s = uts (1, 0, 0);
+  stime = omp_get_wtime () - t;
+  t = omp_get_wtime ();
+  #pragma omp parallel
+    #pragma omp single
+      p = uts (1, 0, 1);
+  report ("uts", s, p, omp_get_wtime () - t);
+  return 0;
+}
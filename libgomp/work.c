@@ -31,16 +31,46 @@
 #include <string.h>
 
 
-/* Allocate a new work share structure, preferably from current team's
-   free gomp_work_share cache.  */
+#define WORK_SHARE_RING_SIZE \
+  (sizeof (((struct gomp_team *) 0)->work_shares) \
+   / sizeof (((struct gomp_team *) 0)->work_shares[0]))
+
+/* Return true if WS is one of the ring of work shares of TEAM.  */
+
+static inline bool
+work_share_in_ring (struct gomp_team *team, struct gomp_work_share *ws)
+{
+  return ws >= &team->work_shares[0]
+	 && ws < &team->work_shares[WORK_SHARE_RING_SIZE];
+}
+
+/* Allocate a new work share structure, preferably the next one of the
+   current team's ring, otherwise from its free gomp_work_share cache.  */
 
 static struct gomp_work_share *
 alloc_work_share (struct gomp_team *team)
 {
   struct gomp_work_share *ws;
   unsigned int i;
+  bool ring_free;
+
+  /* This is called in a critical section, so only one thread at a time
+     takes work shares from the ring, and in the order of the constructs.
+     As the team frees them in about the same order, the next one in the
+     ring is free unless this thread is far ahead of some other.  */
+  ws = &team->work_shares[team->work_share_ring_next];
+  ring_free = ws->ring_free;
+  /* We need an atomic read of ring_free, as free_work_share can be
+     called concurrently.  */
+  __asm ("" : "+r" (ring_free));
+  if (ring_free)
+    {
+      ws->ring_free = false;
+      if (++team->work_share_ring_next == WORK_SHARE_RING_SIZE)
+	team->work_share_ring_next = 0;
+      return ws;
+    }
 
-  /* This is called in a critical section.  */
   if (team->work_share_list_alloc != NULL)
     {
       ws = team->work_share_list_alloc;
@@ -100,21 +130,28 @@ gomp_init_work_share (struct gomp_work_share *ws, bool ordered,
     - offsetof (struct gomp_work_share, inline_ordered_team_ids)) \
    / sizeof (((struct gomp_work_share *) 0)->inline_ordered_team_ids[0]))
 
-      if (nthreads > INLINE_ORDERED_TEAM_IDS_CNT)
+      /* A power of two that leaves room for as many tickets of threads
+	 that ran ahead as there are threads, see ordered.c.  */
+      unsigned size = 2;
+
+      while (size < 2 * nthreads)
+	size *= 2;
+      if (size > INLINE_ORDERED_TEAM_IDS_CNT)
 	ws->ordered_team_ids
-	  = gomp_malloc (nthreads * sizeof (*ws->ordered_team_ids));
+	  = gomp_malloc (size * sizeof (*ws->ordered_team_ids));
       else
 	ws->ordered_team_ids = ws->inline_ordered_team_ids;
       memset (ws->ordered_team_ids, '\0',
-	      nthreads * sizeof (*ws->ordered_team_ids));
-      ws->ordered_num_used = 0;
-      ws->ordered_owner = -1;
-      ws->ordered_cur = 0;
+	      size * sizeof (*ws->ordered_team_ids));
+      ws->ordered_mask = size - 1;
+      ws->ordered_serving = 0;
+      ws->ordered_tickets = 0;
     }
   else
     ws->ordered_team_ids = NULL;
   gomp_ptrlock_init (&ws->next_ws, NULL);
   ws->threads_completed = 0;
+  ws->steal = NULL;
 }
 
 /* Do any needed destruction of gomp_work_share fields before it
@@ -127,6 +164,8 @@ gomp_fini_work_share (struct gomp_work_share *ws)
   if (ws->ordered_team_ids != ws->inline_ordered_team_ids)
     free (ws->ordered_team_ids);
   gomp_ptrlock_destroy (&ws->next_ws);
+  if (ws->steal)
+    gomp_iter_steal_fini (ws);
 }
 
 /* Free a work share struct, if not orphaned, put it into current
@@ -138,6 +177,14 @@ free_work_share (struct gomp_team *team, struct gomp_work_share *ws)
   gomp_fini_work_share (ws);
   if (__builtin_expect (team == NULL, 0))
     free (ws);
+  else if (work_share_in_ring (team, ws))
+    {
+#ifdef HAVE_SYNC_BUILTINS
+      /* Finish with WS before alloc_work_share can see it free.  */
+      __sync_synchronize ();
+#endif
+      ws->ring_free = true;
+    }
   else
     {
       struct gomp_work_share *next_ws;
@@ -171,6 +218,11 @@ gomp_work_share_start (bool ordered)
   struct gomp_team *team = thr->ts.team;
   struct gomp_work_share *ws;
 
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (gomp_profile_var, 0))
+    thr->ts.prof_ws_start = gomp_clock_ns ();
+#endif
+
   /* Work sharing constructs can be orphaned.  */
   if (team == NULL)
     {
@@ -208,6 +260,11 @@ gomp_work_share_end (void)
   struct gomp_team *team = thr->ts.team;
   gomp_barrier_state_t bstate;
 
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (gomp_profile_var, 0))
+    gomp_profile_work_share_end (thr);
+#endif
+
   /* Work sharing constructs can be orphaned.  */
   if (team == NULL)
     {
@@ -239,6 +296,11 @@ gomp_work_share_end_nowait (void)
   struct gomp_work_share *ws = thr->ts.work_share;
   unsigned completed;
 
+#ifdef LIBGOMP_PROFILE
+  if (__builtin_expect (gomp_profile_var, 0))
+    gomp_profile_work_share_end (thr);
+#endif
+
   /* Work sharing constructs can be orphaned.  */
   if (team == NULL)
     {
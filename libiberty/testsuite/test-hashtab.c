@@ -0,0 +1,231 @@
+/* Tests and a microbenchmark for the hash tables in hashtab.h.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of the libiberty library, which is part of GCC.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Without arguments, check that htab_t and a DEFINE_HTAB_TAGGED table
+   agree on a random sequence of insertions, lookups and removals.
+   With a numeric argument N, also time both on N string keys and
+   print the results, e.g.
+
+     ./test-hashtab 1000000  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "libiberty.h"
+#include "hashtab.h"
+#include <stdio.h>
+#include <time.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifndef EXIT_SUCCESS
+#define EXIT_SUCCESS 0
+#endif
+
+#ifndef EXIT_FAILURE
+#define EXIT_FAILURE 1
+#endif
+
+/* A table element: a string with its hash.  */
+
+struct sym
+{
+  hashval_t hash;
+  char name[24];
+};
+
+static int
+sym_eq_1 (const struct sym *entry, const struct sym *key)
+{
+  return strcmp (entry->name, key->name) == 0;
+}
+
+static hashval_t
+sym_hash (const void *p)
+{
+  return ((const struct sym *) p)->hash;
+}
+
+static int
+sym_eq (const void *p1, const void *p2)
+{
+  return sym_eq_1 ((const struct sym *) p1, (const struct sym *) p2);
+}
+
+DEFINE_HTAB_TAGGED (symtab, struct sym, struct sym, sym_eq_1);
+
+static int failures;
+
+static void
+check (int ok, const char *what, int i)
+{
+  if (!ok)
+    {
+      fprintf (stderr, "test-hashtab: %s failed at step %d\n", what, i);
+      failures++;
+    }
+}
+
+/* Fill SYMS with N distinct names.  */
+
+static void
+make_syms (struct sym *syms, int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      sprintf (syms[i].name, "sym_%d_%x", i, (unsigned) (i * 2654435761U));
+      syms[i].hash = htab_hash_string (syms[i].name);
+    }
+}
+
+static int
+count_cb (struct sym **slot ATTRIBUTE_UNUSED, void *info)
+{
+  ++*(size_t *) info;
+  return 1;
+}
+
+/* Apply the same random operations to both kinds of table.  */
+
+static void
+run_tests (void)
+{
+  const int n = 5000;
+  struct sym *syms = XNEWVEC (struct sym, n);
+  htab_t h = htab_create (7, sym_hash, sym_eq, NULL);
+  struct symtab *t = symtab_create (7);
+  size_t count;
+  int i;
+
+  make_syms (syms, n);
+  srand (1);
+  for (i = 0; i < 200000; i++)
+    {
+      struct sym *s = &syms[rand () % n];
+      int op = rand () % 4;
+      void **hslot;
+      struct sym **tslot;
+
+      if (op < 2)
+	{
+	  hslot = htab_find_slot_with_hash (h, s, s->hash, INSERT);
+	  tslot = symtab_find_slot_with_hash (t, s, s->hash, INSERT);
+	  check ((*hslot == NULL) == (*tslot == NULL), "insert", i);
+	  *hslot = s;
+	  *tslot = s;
+	}
+      else if (op == 2)
+	{
+	  hslot = htab_find_slot_with_hash (h, s, s->hash, NO_INSERT);
+	  tslot = symtab_find_slot_with_hash (t, s, s->hash, NO_INSERT);
+	  check ((hslot == NULL) == (tslot == NULL), "remove lookup", i);
+	  if (hslot)
+	    {
+	      htab_clear_slot (h, hslot);
+	      symtab_clear_slot (t, tslot);
+	    }
+	}
+      else
+	check (htab_find_with_hash (h, s, s->hash)
+	       == symtab_find_with_hash (t, s, s->hash), "find", i);
+
+      check (htab_elements (h) == symtab_elements (t), "elements", i);
+      if (i % 50000 == 0)
+	{
+	  count = 0;
+	  symtab_traverse (t, count_cb, &count);
+	  check (count == symtab_elements (t), "traverse", i);
+	}
+    }
+
+  htab_empty (h);
+  symtab_empty (t);
+  check (symtab_elements (t) == 0, "empty", 0);
+  check (symtab_find_with_hash (t, &syms[0], syms[0].hash) == NULL,
+	 "find after empty", 0);
+
+  htab_delete (h);
+  symtab_delete (t);
+  free (syms);
+}
+
+/* Time N insertions followed by N successful and N failing lookups,
+   first with htab_t and then with the tagged table.  */
+
+static void
+run_bench (int n)
+{
+  struct sym *syms = XNEWVEC (struct sym, 2 * n);
+  htab_t h;
+  struct symtab *t;
+  clock_t start;
+  double ht[2], tt[2];
+  long found = 0;
+  int i;
+
+  make_syms (syms, 2 * n);
+
+  start = clock ();
+  h = htab_create (7, sym_hash, sym_eq, NULL);
+  for (i = 0; i < n; i++)
+    *htab_find_slot_with_hash (h, &syms[i], syms[i].hash, INSERT) = &syms[i];
+  ht[0] = (double) (clock () - start) / CLOCKS_PER_SEC;
+  start = clock ();
+  for (i = 0; i < 2 * n; i++)
+    found += htab_find_with_hash (h, &syms[i], syms[i].hash) != NULL;
+  ht[1] = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  start = clock ();
+  t = symtab_create (7);
+  for (i = 0; i < n; i++)
+    *symtab_find_slot_with_hash (t, &syms[i], syms[i].hash, INSERT)
+      = &syms[i];
+  tt[0] = (double) (clock () - start) / CLOCKS_PER_SEC;
+  start = clock ();
+  for (i = 0; i < 2 * n; i++)
+    found += symtab_find_with_hash (t, &syms[i], syms[i].hash) != NULL;
+  tt[1] = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  check (found == 2 * (long) n, "bench lookups", n);
+  printf ("%d keys        insert   lookup  collisions/search\n", n);
+  printf ("htab_t        %7.3fs %7.3fs %8.2f\n",
+	  ht[0], ht[1], htab_collisions (h));
+  printf ("tagged        %7.3fs %7.3fs %8.2f\n",
+	  tt[0], tt[1], symtab_collisions (t));
+
+  htab_delete (h);
+  symtab_delete (t);
+  free (syms);
+}
+
+int
+main (int argc, char **argv)
+{
+  run_tests ();
+  if (argc > 1)
+    run_bench (atoi (argv[1]));
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}